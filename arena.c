@@ -0,0 +1,268 @@
+/*=======================================================================
+solunar
+arena.c
+Definition of the Arena object, a bump allocator, and the interning
+of strings
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "arena.h"
+
+// The size of each block an arena takes from the heap. A larger
+//  allocation gets a block of its own
+#define ARENA_BLOCK_SIZE 65536
+// Every allocation is aligned to this many bytes, which suits any type
+#define ARENA_ALIGN 16
+// Buckets in the table of interned strings
+#define ARENA_INTERN_HASH_SIZE 256
+
+typedef struct _ArenaBlock
+  {
+  struct _ArenaBlock *next;
+  size_t size;
+  size_t used;
+  } ArenaBlock;
+
+// The space in a block starts after its header, rounded up to the
+//  alignment
+#define ARENA_HEADER_SIZE \
+  ((sizeof (ArenaBlock) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN)
+
+typedef struct _ArenaPriv
+  {
+  ArenaBlock *first;
+  // The block being allocated from. Blocks after it are empty, and
+  //  are kept from earlier use until the arena is freed
+  ArenaBlock *current;
+  } ArenaPriv;
+
+typedef struct _ArenaInterned
+  {
+  struct _ArenaInterned *next;
+  char s[1];
+  } ArenaInterned;
+
+static ArenaInterned *arena_interned [ARENA_INTERN_HASH_SIZE];
+static pthread_mutex_t arena_intern_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// The counters are updated from any thread, so atomically
+static ArenaStats arena_stats;
+#define ARENA_COUNT(field) \
+  __atomic_fetch_add (&arena_stats.field, 1, __ATOMIC_RELAXED)
+
+
+/*=======================================================================
+arena_new_block
+=======================================================================*/
+static ArenaBlock *arena_new_block (size_t size)
+  {
+  ArenaBlock *block = (ArenaBlock *) malloc (ARENA_HEADER_SIZE + size);
+  if (!block) 
+    {
+    fprintf (stderr, "Out of memory\n");
+    exit (-1);
+    }
+  ARENA_COUNT (arena_blocks);
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+  return block;
+  }
+
+
+/*=======================================================================
+Arena_new
+Caller must free with Arena_free
+=======================================================================*/
+Arena *Arena_new (void)
+  {
+  Arena *self = (Arena *) malloc (sizeof (Arena));
+  self->priv = (ArenaPriv *) malloc (sizeof (ArenaPriv));
+  self->priv->first = arena_new_block (ARENA_BLOCK_SIZE);
+  self->priv->current = self->priv->first;
+  return self;
+  }
+
+
+/*=======================================================================
+Arena_free
+Free the arena and everything allocated from it
+=======================================================================*/
+void Arena_free (Arena *self)
+  {
+  if (!self) return;
+  ArenaBlock *block = self->priv->first;
+  while (block)
+    {
+    ArenaBlock *next = block->next;
+    free (block);
+    block = next;
+    }
+  free (self->priv);
+  free (self);
+  }
+
+
+/*=======================================================================
+Arena_reset
+Release everything allocated from the arena, keeping its blocks for 
+reuse
+=======================================================================*/
+void Arena_reset (Arena *self)
+  {
+  ArenaBlock *block;
+  for (block = self->priv->first; block; block = block->next)
+    block->used = 0;
+  self->priv->current = self->priv->first;
+  ARENA_COUNT (arena_resets);
+  }
+
+
+/*=======================================================================
+Arena_alloc
+Allocate 'size' bytes from the arena or, if self is NULL, from the
+heap, in which case the caller must free() them
+=======================================================================*/
+void *Arena_alloc (Arena *self, size_t size)
+  {
+  if (!self) return malloc (size);
+
+  size = (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+  ArenaBlock *block = self->priv->current;
+  while (block->used + size > block->size)
+    {
+    if (!block->next || block->next->size < size)
+      {
+      // A new block goes in after the current one, so any empty 
+      //  blocks after it are still used later
+      ArenaBlock *newb = arena_new_block 
+        (size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE);
+      newb->next = block->next;
+      block->next = newb;
+      }
+    block = block->next;
+    }
+  self->priv->current = block;
+  void *p = (char *)block + ARENA_HEADER_SIZE + block->used;
+  block->used += size;
+  return p;
+  }
+
+
+/*=======================================================================
+Arena_strdup
+Copy a string into the arena or, if self is NULL, the heap
+=======================================================================*/
+char *Arena_strdup (Arena *self, const char *s)
+  {
+  size_t len = strlen (s) + 1;
+  char *r = (char *) Arena_alloc (self, len);
+  memcpy (r, s, len);
+  return r;
+  }
+
+
+/*=======================================================================
+Arena_alloc_object
+Allocate an object from 'arena', or the heap if arena is NULL, and 
+count it in the statistics. The object keeps the arena, to pass to 
+Arena_free_object when it is freed
+=======================================================================*/
+void *Arena_alloc_object (Arena *arena, size_t size)
+  {
+  if (arena)
+    ARENA_COUNT (arena_allocs);
+  else
+    ARENA_COUNT (heap_allocs);
+  return Arena_alloc (arena, size);
+  }
+
+
+/*=======================================================================
+Arena_free_object
+Free an object made by Arena_alloc_object. One that came from an 
+arena is left for the arena to release
+=======================================================================*/
+void Arena_free_object (Arena *owner, void *object)
+  {
+  if (owner || !object) return;
+  ARENA_COUNT (heap_frees);
+  free (object);
+  }
+
+
+/*=======================================================================
+arena_find_interned
+Look up an interned string, returning NULL if it has not been added
+=======================================================================*/
+static const char *arena_find_interned (unsigned int hash, const char *s)
+  {
+  ArenaInterned *entry = __atomic_load_n (&arena_interned[hash], 
+    __ATOMIC_ACQUIRE);
+  for (; entry; entry = entry->next)
+    if (strcmp (entry->s, s) == 0) return entry->s;
+  return NULL;
+  }
+
+
+/*=======================================================================
+Arena_intern
+Returns the one copy of a string that is equal to s, making it if 
+need be. Interned strings are never freed, so they suit names that
+come from a small, fixed set, like those of holidays. Entries are 
+never changed once added, so a string that is already interned is 
+found without taking the lock, as ZoneInfo_get finds a loaded zone.
+Only adding a string locks out other threads
+=======================================================================*/
+const char *Arena_intern (const char *s)
+  {
+  unsigned int hash = 5381;
+  const char *p;
+  for (p = s; *p; p++)
+    hash = hash * 33 + (unsigned char)*p;
+  hash %= ARENA_INTERN_HASH_SIZE;
+
+  const char *r = arena_find_interned (hash, s);
+  if (r) return r;
+
+  pthread_mutex_lock (&arena_intern_lock);
+  // Another thread might have added the string while we waited
+  r = arena_find_interned (hash, s);
+  if (!r)
+    {
+    size_t len = strlen (s);
+    ArenaInterned *entry = (ArenaInterned *) malloc 
+      (sizeof (ArenaInterned) + len);
+    memcpy (entry->s, s, len + 1);
+    entry->next = arena_interned[hash];
+    __atomic_store_n (&arena_interned[hash], entry, __ATOMIC_RELEASE);
+    ARENA_COUNT (interned);
+    r = entry->s;
+    }
+  pthread_mutex_unlock (&arena_intern_lock);
+  return r;
+  }
+
+
+/*=======================================================================
+Arena_get_stats
+=======================================================================*/
+void Arena_get_stats (ArenaStats *stats)
+  {
+  stats->heap_allocs = __atomic_load_n (&arena_stats.heap_allocs, 
+    __ATOMIC_RELAXED);
+  stats->heap_frees = __atomic_load_n (&arena_stats.heap_frees, 
+    __ATOMIC_RELAXED);
+  stats->arena_allocs = __atomic_load_n (&arena_stats.arena_allocs, 
+    __ATOMIC_RELAXED);
+  stats->arena_blocks = __atomic_load_n (&arena_stats.arena_blocks, 
+    __ATOMIC_RELAXED);
+  stats->arena_resets = __atomic_load_n (&arena_stats.arena_resets, 
+    __ATOMIC_RELAXED);
+  stats->interned = __atomic_load_n (&arena_stats.interned, 
+    __ATOMIC_RELAXED);
+  }
+
@@ -0,0 +1,62 @@
+/*=======================================================================
+solunar
+arena.h
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#pragma once
+
+#include <stddef.h>
+#include "defs.h"
+
+/*=======================================================================
+Arena
+A bump allocator. Allocating from an arena takes a pointer increment,
+and everything allocated from it is released at once, by 
+Arena_reset or Arena_free, and never individually. 
+
+The DateTime, LatLong and Error constructors that end in _in take the
+arena to allocate from, or NULL for the heap. The _free functions do
+nothing for an object from an arena, which lasts until the arena is
+reset. So a caller that makes and drops many objects per query, as 
+batch mode does, can pass the same arena to each query's objects, 
+through SolunarContext, and reset it after each query. An arena must
+only be used by one thread at a time
+=======================================================================*/
+typedef struct _Arena
+  {
+  struct _ArenaPriv *priv;
+  } Arena;
+
+/*=======================================================================
+ArenaStats
+Counts, over the whole process, of the allocations that objects have
+made from the heap and from arenas, for comparing the two
+=======================================================================*/
+typedef struct _ArenaStats
+  {
+  // Objects allocated with malloc(), because no arena was given, and
+  //  how many of those have been freed
+  unsigned long heap_allocs;
+  unsigned long heap_frees;
+  // Objects allocated from arenas, and the blocks that the arenas 
+  //  themselves took from the heap
+  unsigned long arena_allocs;
+  unsigned long arena_blocks;
+  unsigned long arena_resets;
+  // Distinct strings interned by Arena_intern
+  unsigned long interned;
+  } ArenaStats;
+
+Arena *Arena_new (void);
+void Arena_free (Arena *self);
+void Arena_reset (Arena *self);
+void *Arena_alloc (Arena *self, size_t size);
+char *Arena_strdup (Arena *self, const char *s);
+
+void *Arena_alloc_object (Arena *arena, size_t size);
+void Arena_free_object (Arena *owner, void *object);
+
+const char *Arena_intern (const char *s);
+
+void Arena_get_stats (ArenaStats *stats);
+
@@ -25,13 +25,13 @@ works :)
 double AstroDays_periodic24 (double t)
   {
   int i;
-  static double A[24] = {485,203,199,182,156,136,77,74,70,58,
+  static const double A[24] = {485,203,199,182,156,136,77,74,70,58,
       52,50,45,44,29,18,17,16,14,12,12,12,9,8};
-  static double B[24] = {324.96,337.23,342.08,27.85,73.14,
+  static const double B[24] = {324.96,337.23,342.08,27.85,73.14,
       171.52,222.54,296.72,243.58,119.81,297.17,21.02, 247.54,
       325.15,60.93,155.12,288.79,198.04,199.76,95.39,287.11,
       320.81,227.73,15.45};
-  static double C[24] = {1934.136,32964.467,20.186,445267.112,
+  static const double C[24] = {1934.136,32964.467,20.186,445267.112,
       45036.886,22518.443, 65928.934,3034.906,9037.513,33718.147,
       150.678,2281.226, 29929.562,31555.956,4443.417,67555.328,
       4562.452,62894.029, 31436.921,14577.848,31931.756,34777.259,
@@ -135,22 +135,22 @@ DateTime *AstroDays_get_summer_solstice (int year, BOOL southern)
 
 /*=======================================================================
 AstroDays_get_list_for_year 
-Given a year and a pointer to a pointerlist of DateTime objects,
+Given a year and a PointerArray of DateTime objects,
 add the soltices and equinoxes for the specified year to the
 list.
 =======================================================================*/
-PointerList *AstroDays_get_list_for_year (PointerList *in, int year, 
-     const char *tz, BOOL utc, BOOL southern)
+PointerArray *AstroDays_get_list_for_year (PointerArray *in, int year, 
+     BOOL southern)
   {
-  PointerList *l = in;
+  PointerArray *l = in;
   DateTime *vernal_equinox = AstroDays_get_vernal_equinox (year);
-  l = PointerList_append (l, vernal_equinox);
+  PointerArray_append (l, vernal_equinox);
   DateTime *autumnal_equinox = AstroDays_get_autumnal_equinox (year);
-  l = PointerList_append (l, autumnal_equinox);
+  PointerArray_append (l, autumnal_equinox);
   DateTime *winter_solstice = AstroDays_get_winter_solstice (year, southern);
-  l = PointerList_append (l, winter_solstice);
+  PointerArray_append (l, winter_solstice);
   DateTime *summer_solstice = AstroDays_get_summer_solstice (year, southern);
-  l = PointerList_append (l, summer_solstice);
+  PointerArray_append (l, summer_solstice);
 
   return l;
   }
@@ -1,10 +1,10 @@
 #pragma once
 
 #include "defs.h"
-#include "pointerlist.h"
+#include "pointerarray.h"
 
-PointerList *AstroDays_get_list_for_year (PointerList *l, int year, 
-     const char *tz, BOOL utc, BOOL southern);
+PointerArray *AstroDays_get_list_for_year (PointerArray *l, int year, 
+     BOOL southern);
 
 DateTime *AstroDays_get_vernal_equinox (int year);
 DateTime *AstroDays_get_autumnal_equinox (int year);
@@ -9,27 +9,66 @@ Functions for finding latitude and longitude of cities
 #include <stdlib.h>
 #include <string.h>
 #include "city.h"
-#include "pointerlist.h"
+#include "cityinfo.h"
+#include "pointerarray.h"
+#include "arena.h"
+
+// A City made by City_new_from_name is allocated together with its
+//  strings, which follow it
 
 /*=======================================================================
 City_get_matching_name
-Returns a PointerList of pointer to char*. Caller must
-call PointerList_free (result, TRUE) to free. 
+Returns a PointerArray of pointers to char*. Caller must
+call PointerArray_free (result, TRUE) to free. 
 =======================================================================*/
-PointerList *City_get_matching_name (const char *name)
+PointerArray *City_get_matching_name (const char *name)
   {
-  PointerList *list = NULL;
+  PointerArray *list = PointerArray_new ();
   City *city = cities;
   while (city->name)
     {
     if (strcasestr (city->name, name))
-      list = PointerList_append (list, strdup (city->name)); 
+      PointerArray_append (list, strdup (city->name)); 
     city++;
     };
 
   return list;
   }
 
+/*=======================================================================
+City_find
+Returns a pointer into the city table for the city whose name matches
+the supplied name, or NULL if there is no match, or the match is
+ambiguous. A case-insensitive exact match wins over any number of 
+partial matches. If nmatches is not NULL, it receives the number of
+partial matches. The result points to static data, and must not be 
+freed
+=======================================================================*/
+const City *City_find (const char *name, int *nmatches)
+  {
+  const City *match = NULL;
+  int n = 0;
+  City *city = cities;
+  while (city->name)
+    {
+    if (strcasecmp (city->name, name) == 0)
+      {
+      if (nmatches) *nmatches = 1;
+      return city;
+      }
+    if (strcasestr (city->name, name))
+      {
+      match = city;
+      n++;
+      }
+    city++;
+    };
+
+  if (nmatches) *nmatches = n;
+  if (n == 1) return match;
+  return NULL;
+  }
+
 /*=======================================================================
 City_new_from_name
 Returns a city object whose name matches the supplied name, or NULL
@@ -42,10 +81,15 @@ City *City_new_from_name (const char *name)
     {
     if (strcmp (city->name, name) == 0)
       {
-      City *c = (City *) malloc (sizeof (City));
+      size_t name_len = strlen (city->name) + 1;
+      size_t code_len = strlen (city->country_code) + 1;
+      City *c = (City *) Arena_alloc_object 
+        (NULL, sizeof (City) + name_len + code_len);
       memcpy (c, city, sizeof (City));
-      c->country_code = strdup (city->country_code);
-      c->name = strdup (city->name);
+      c->name = (char *) (c + 1);
+      memcpy (c->name, city->name, name_len);
+      c->country_code = c->name + name_len;
+      memcpy (c->country_code, city->country_code, code_len);
       return c;
       }
     city++;
@@ -59,9 +103,7 @@ City_free
 void City_free (City *self)
   {
   if (!self) return;
-  if (self->country_code) free (self->country_code);
-  if (self->name) free (self->name);
-  free (self);
+  Arena_free_object (NULL, self);
   }
 
 
@@ -72,8 +114,19 @@ call LatLong_free() on the return, which will always be non-null
 =======================================================================*/
 LatLong *City_get_latlong (const City *self)
   {
-  LatLong *l = LatLong_new_deg_min (self->lat_degrees, self->lat_minutes,
-    self->lat_south, self->long_degrees, self->long_minutes, self->long_west);
+  return City_get_latlong_in (NULL, self);
+  }
+
+/*=======================================================================
+City_get_latlong_in
+As City_get_latlong, but the result is allocated from 'arena', or
+from the heap if arena is NULL
+=======================================================================*/
+LatLong *City_get_latlong_in (Arena *arena, const City *self)
+  {
+  LatLong *l = LatLong_new_deg_min_in (arena, self->lat_degrees, 
+    self->lat_minutes, self->lat_south, self->long_degrees, 
+    self->long_minutes, self->long_west);
   return l;
   }
 
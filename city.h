@@ -21,10 +21,12 @@ typedef struct City {
 
 extern City cities[];
 
-struct _PointerList *City_get_matching_name (const char *name);
+struct _PointerArray *City_get_matching_name (const char *name);
 City *City_new_from_name (const char *name);
+const City *City_find (const char *name, int *nmatches);
 void City_free (City *self);
 LatLong *City_get_latlong (const City *self);
+LatLong *City_get_latlong_in (Arena *arena, const City *self);
 
 
 
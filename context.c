@@ -0,0 +1,107 @@
+/*=======================================================================
+solunar
+context.c
+Definition of the SolunarContext object
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <string.h>
+#include "context.h"
+
+
+/*=======================================================================
+SolunarContext_init
+Set up a context that formats times according to tz, utc, and
+syslocal, with every other setting off, and the moon at the standard
+precision. The location and date are left NULL for the caller to 
+fill in
+=======================================================================*/
+void SolunarContext_init (SolunarContext *self, const char *tz,
+    BOOL utc, BOOL syslocal)
+  {
+  memset (self, 0, sizeof (SolunarContext));
+  self->tz = tz;
+  self->utc = utc;
+  self->syslocal = syslocal;
+  self->precision = MOONTIMES_PRECISION_STANDARD;
+  }
+
+
+/*=======================================================================
+SolunarContext_set_location
+Set the location, which may be NULL, and the observer derived from it
+=======================================================================*/
+void SolunarContext_set_location (SolunarContext *self, 
+    const LatLong *latlong)
+  {
+  self->latlong = latlong;
+  if (latlong)
+    Observer_init_latlong (&self->observer, latlong);
+  }
+
+
+/*=======================================================================
+SolunarContext_time_to_string
+Format a time in whichever zone the context asks for. Caller must
+free the result
+=======================================================================*/
+char *SolunarContext_time_to_string (const SolunarContext *self,
+    const DateTime *dt)
+  {
+  if (self->syslocal)
+    return DateTime_time_to_string_syslocal (dt, self->twelvehour);
+  else if (self->utc)
+    return DateTime_time_to_string_UTC (dt, self->twelvehour);
+  else
+    return DateTime_time_to_string_local (dt, self->tz, self->twelvehour);
+  }
+
+
+/*=======================================================================
+SolunarContext_init_formatter
+Set up a formatter that writes times and dates in whichever zone, and
+in whichever form, the context asks for
+=======================================================================*/
+void SolunarContext_init_formatter (const SolunarContext *self,
+    DateTimeFormatter *formatter)
+  {
+  DateTimeFormatter_init (formatter, self->tz, self->utc, self->syslocal,
+    self->twelvehour);
+  }
+
+
+/*=======================================================================
+SolunarContext_date_to_string
+Format a date in whichever zone the context asks for. Caller must
+free the result
+=======================================================================*/
+char *SolunarContext_date_to_string (const SolunarContext *self,
+    const DateTime *dt)
+  {
+  if (self->syslocal)
+    return DateTime_date_to_string_syslocal (dt);
+  else if (self->utc)
+    return DateTime_date_to_string_UTC (dt);
+  else
+    return DateTime_date_to_string_local (dt, self->tz);
+  }
+
+
+/*=======================================================================
+SolunarContext_get_stars
+Represent a score between 0 and 1 as a bar of asterisks. The result
+is stored in the context, and is overwritten by the next call
+=======================================================================*/
+const char *SolunarContext_get_stars (SolunarContext *self, double score)
+  {
+  int i;
+  for (i = 0; i < SOLUNAR_STARS; i++)
+    {
+    if (score > (double) i / SOLUNAR_STARS)
+      self->stars[i] = '*';
+    else
+      self->stars[i] = ' ';
+    }
+  self->stars[SOLUNAR_STARS] = 0;
+  return self->stars;
+  }
+
@@ -0,0 +1,68 @@
+/*=======================================================================
+solunar
+context.h
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#pragma once
+
+#include "defs.h"
+#include "latlong.h"
+#include "observer.h"
+#include "datetime.h"
+#include "ephemeris.h"
+#include "moontimes.h"
+#include "arena.h"
+
+// Width of the bar of stars that represents a score in the solunar table
+#define SOLUNAR_STARS 10
+
+/*=======================================================================
+SolunarContext
+Everything needed to produce a report for one location and date, along
+with the working storage that formatting it requires. The caller owns
+the context, and none of the pointers in it is owned by the context.
+The library keeps no other per-call state, so threads can compute
+reports at the same time so long as each has its own context
+=======================================================================*/
+typedef struct _SolunarContext
+  {
+  const char *tz;
+  const LatLong *latlong;
+  // The same location, in the form the calculations use. Set both 
+  //  with SolunarContext_set_location
+  Observer observer;
+  const DateTime *datetime;
+  BOOL utc;
+  BOOL syslocal;
+  BOOL twelvehour;
+  BOOL full;
+  BOOL quiet;
+  BOOL show_solunar;
+  // Which series gives the moon's position for moonrise and moonset
+  MoonTimesPrecision precision;
+  // Positions of the sun and moon, or NULL to calculate them afresh
+  //  every time. A cache must not be shared between threads
+  EphemerisCache *ephemeris;
+  // Where the objects that a query makes are allocated, or NULL for
+  //  the heap. An arena must not be shared between threads
+  Arena *arena;
+  char stars [SOLUNAR_STARS + 1];
+  } SolunarContext;
+
+void SolunarContext_init (SolunarContext *self, const char *tz,
+    BOOL utc, BOOL syslocal);
+
+void SolunarContext_set_location (SolunarContext *self, 
+    const LatLong *latlong);
+
+char *SolunarContext_time_to_string (const SolunarContext *self,
+    const DateTime *dt);
+
+void SolunarContext_init_formatter (const SolunarContext *self,
+    DateTimeFormatter *formatter);
+
+char *SolunarContext_date_to_string (const SolunarContext *self,
+    const DateTime *dt);
+
+const char *SolunarContext_get_stars (SolunarContext *self, double score);
+
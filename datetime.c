@@ -13,54 +13,96 @@ optionally be associated with a name, e.g., 'vernal equinox'
 #include <math.h>
 #include <stdint.h>
 #include "timeutil.h"
+#include "zoneinfo.h"
 #include "datetime.h"
-
-extern char *strptime (const char *s, const char *fmt, struct tm *tm);
+#include "arena.h"
 
 typedef struct _DateTimePriv
   {
-  time_t utime;
-  char *name; // e.g., Christmas day
+  DateTimeValue value;
+  Arena *arena; // The arena the object came from, or NULL
   } DateTimePriv;
 
+// A DateTime and its private part are allocated together
+typedef struct _DateTimeBlock
+  {
+  DateTime datetime;
+  DateTimePriv priv;
+  } DateTimeBlock;
+
 
 /*=======================================================================
-my_setenv
-A variant of setenv() that allows a NULL value to call unsetenv; 
-setenv() itself does not accept NULL as a value
+DateTimeValue_from_utime
 =======================================================================*/
-void my_setenv (const char *name, const char *value, BOOL dummy)
+DateTimeValue DateTimeValue_from_utime (int64_t utime)
   {
-  //printf ("name=%s value=%s\n", name, value); 
-  if (value)
-    setenv (name, value, 1);  
-  else
-    unsetenv (name);
+  DateTimeValue r;
+  r.utime = utime;
+  r.name = NULL;
+  return r;
   }
 
 
 /*=======================================================================
-getenv_dup
-Gets a copy of an environment string. Caller must free it. Note that the
-return value might be null (which cannot be freed)
+DateTime_new_value
+Wrap a DateTimeValue in a DateTime. Caller must free the result
 =======================================================================*/
-static char *getenv_dup (const char *env)
+DateTime *DateTime_new_value (DateTimeValue value)
   {
-  char *s = getenv (env);
-  if (s) return strdup (s);
-  return NULL;
+  return DateTime_new_value_in (NULL, value);
+  }
+
+
+/*=======================================================================
+DateTime_new_value_in
+As DateTime_new_value, but allocated from 'arena', or from the heap if
+arena is NULL. Every other constructor allocates from the heap
+=======================================================================*/
+DateTime *DateTime_new_value_in (Arena *arena, DateTimeValue value)
+  {
+  DateTimeBlock *block = (DateTimeBlock *) Arena_alloc_object 
+    (arena, sizeof (DateTimeBlock));
+  DateTime *self = &block->datetime;
+  self->priv = &block->priv;
+  self->priv->value = value;
+  self->priv->arena = arena;
+  return self;
   }
 
+
+/*=======================================================================
+DateTime_get_value
+=======================================================================*/
+DateTimeValue DateTime_get_value (const DateTime *self)
+  {
+  return self->priv->value;
+  }
+
+
+/*=======================================================================
+DateTime_set_value
+=======================================================================*/
+void DateTime_set_value (DateTime *self, DateTimeValue value)
+  {
+  self->priv->value = value;
+  }
+
+
 /*=======================================================================
 DateTime_new_utime
 =======================================================================*/
 DateTime *DateTime_new_utime (time_t utime)
   {
-  DateTime *self = (DateTime *) malloc (sizeof (DateTime));
-  self->priv = (DateTimePriv *) malloc (sizeof (DateTimePriv));
-  self->priv->utime = utime;
-  self->priv->name = NULL;
-  return self;
+  return DateTime_new_value (DateTimeValue_from_utime (utime));
+  }
+
+
+/*=======================================================================
+DateTimeValue_from_julian
+=======================================================================*/
+DateTimeValue DateTimeValue_from_julian (double jd)
+  {
+  return DateTimeValue_from_utime ((time_t) ((jd - 2440587.5) * 86400));
   }
 
 
@@ -69,40 +111,48 @@ DateTime_new_julian
 =======================================================================*/
 DateTime *DateTime_new_julian (double jd)
   {
-  DateTime *self = (DateTime *) malloc (sizeof (DateTime));
-  self->priv = (DateTimePriv *) malloc (sizeof (DateTimePriv));
-  self->priv->utime = (jd - 2440587.5) * 86400;
-  self->priv->name = NULL;
-  return self;
+  return DateTime_new_value (DateTimeValue_from_julian (jd));
   }
 
 
 /*=======================================================================
-DateTime_new_centre
-Creates a new datetime half-way between the two specified values. 
+DateTimeValue_centre
+The time half-way between the two specified values. 
 The result should always be between d1 and d2, but we fix a bug
 in this method where sometimes the calculted sunrise comes out exactly
 24 hours early, which would make the value of high noon 12 hours
 early. It would be better to fix the bug rather than work around it
 here, but I can't find it :/
 =======================================================================*/
+DateTimeValue DateTimeValue_centre (DateTimeValue d1, DateTimeValue d2)
+  {
+  int64_t t1 = d1.utime;
+  int64_t t2 = d2.utime;
+  if (t2 < t1) t1 += SECONDS_PER_DAY;
+  return DateTimeValue_from_utime (timeutil_floor_div (t1 + t2, 2));
+  }
+
+
+/*=======================================================================
+DateTime_new_centre
+Creates a new datetime half-way between the two specified values, as
+DateTimeValue_centre does
+=======================================================================*/
 DateTime *DateTime_new_centre (const DateTime *d1, const DateTime *d2)
   {
-  DateTime *self = (DateTime *) malloc (sizeof (DateTime));
-  self->priv = (DateTimePriv *) malloc (sizeof (DateTimePriv));
-  if (d2->priv->utime < d1->priv->utime)
-    {
-    // Watch out here -- time_t is no big enough to hold the sum of two
-    //  times
-    self->priv->utime = (time_t) 
-      (((uint64_t)d2->priv->utime + (uint64_t)(d1->priv->utime + 24 * 3600)) / 2); 
-    }
-  else
-    {
-    self->priv->utime = (time_t) 
-      (((uint64_t)d2->priv->utime + (uint64_t)d1->priv->utime) / 2); 
-    }
-  self->priv->name = NULL;
+  return DateTime_new_value (DateTimeValue_centre (d1->priv->value, 
+    d2->priv->value));
+  }
+
+
+/*=======================================================================
+DateTimeValue_with_name
+The same time, with the specified name, which may be NULL. Names come
+from a small set, so they are interned, and copies share them
+=======================================================================*/
+DateTimeValue DateTimeValue_with_name (DateTimeValue self, const char *name)
+  {
+  self.name = name ? Arena_intern (name) : NULL;
   return self;
   }
 
@@ -112,11 +162,7 @@ DateTime_set_name
 =======================================================================*/
 void DateTime_set_name (const DateTime *self, const char *name)
   {
-  if (self->priv->name) free (self->priv->name);
-  if (name)
-    self->priv->name = strdup (name);
-  else
-    self->priv->name = NULL;
+  self->priv->value = DateTimeValue_with_name (self->priv->value, name);
   }
 
 
@@ -125,7 +171,7 @@ DateTime_get_name
 =======================================================================*/
 const char* DateTime_get_name (const DateTime *self)
   {
-  return self->priv->name;
+  return self->priv->value.name;
   }
 
 
@@ -134,83 +180,400 @@ DateTime_clone
 =======================================================================*/
 DateTime *DateTime_clone (const DateTime *other)
   {
-  DateTime *r = DateTime_new_utime (other->priv->utime);
-  DateTime_set_name (r, other->priv->name);
-  return r;
+  // The name is interned already
+  return DateTime_new_value (other->priv->value);
   }
 
 
 /*=======================================================================
-DateTime_parse
-Parse a string against a format, write results to tm
+datetime_parse_number
+Read a number of from 1 to max_digits digits, after any spaces, as 
+strptime() does. Returns the position after it, or NULL if there are 
+no digits. If ndigits is not NULL, it is set to the number of digits
 =======================================================================*/
-BOOL DateTime_parse (const char *str, const char *fmt, struct tm *tm)
+static const char *datetime_parse_number (const char *p, int max_digits,
+    int *n, int *ndigits)
   {
-  time_t now = time (NULL);
-  BOOL ret;
+  int value = 0, len = 0;
+  while (*p == ' ') p++;
+  while (len < max_digits && *p >= '0' && *p <= '9')
+    {
+    value = value * 10 + (*p++ - '0');
+    len++;
+    }
+  if (len == 0) return NULL;
+  *n = value;
+  if (ndigits) *ndigits = len;
+  return p;
+  }
 
-  memcpy (tm, localtime (&now), sizeof (struct tm));
-  tm->tm_hour = 2;
-  tm->tm_min = 0;
-  tm->tm_sec = 0;
-  tm->tm_isdst = -1;
-  char *last = strptime (str, fmt, tm);
-  if (tm->tm_year < 50) tm->tm_year += 2000;
-  if (last != str + strlen (str))
-    ret = FALSE;
-  else
-    ret = TRUE;
 
-  return ret;
+/*=======================================================================
+datetime_parse_digits
+Read exactly 'len' digits, with nothing before them, as ISO-8601 has 
+them. Returns the position after them, or NULL
+=======================================================================*/
+static const char *datetime_parse_digits (const char *p, int len, int *n)
+  {
+  int value = 0;
+  for (; len > 0; len--, p++)
+    {
+    if (*p < '0' || *p > '9') return NULL;
+    value = value * 10 + (*p - '0');
+    }
+  *n = value;
+  return p;
   }
 
+
 /*=======================================================================
-DateTime_new_parse
+datetime_parse_month_name
+Read an English month name, in full or its first three letters, in 
+any case. Returns the position after it, or NULL
 =======================================================================*/
-DateTime *DateTime_new_parse (const char *str, Error **error, const char *tz,
-    BOOL utc)
+static const char *datetime_parse_month_name (const char *p, int *month)
   {
-  struct tm tm;
-  time_t utime = 0;
-  char *oldtz = NULL;
-
-  if (DateTime_parse (str, "%e/%m/%Y %H:%M", &tm)) goto success;
-  if (DateTime_parse (str, "%e/%m/%Y", &tm)) goto success;
-  if (DateTime_parse (str, "%e/%m %M:M", &tm)) goto success;
-  if (DateTime_parse (str, "%e/%m", &tm)) goto success;
-  if (DateTime_parse (str, "%b %e %Y %H:%M", &tm)) goto success;
-  if (DateTime_parse (str, "%b %e %H:%M", &tm)) goto success;
-  if (DateTime_parse (str, "%b %e %Y", &tm)) goto success;
-  if (DateTime_parse (str, "%b %e", &tm)) goto success;
-  if (DateTime_parse (str, "%H:%M", &tm)) goto success;
-  if (DateTime_parse (str, "%j#%Y", &tm)) goto success;
-
-  // Failed
-  *error = Error_new ("Can't parse date");
+  int m;
+  for (m = JAN; m <= DEC; m++)
+    {
+    const char *name = timeutil_get_month_name_english (m);
+    int len = 0;
+    while (name[len] && (p[len] | 0x20) == (name[len] | 0x20)) len++;
+    if (name[len] == 0 || len == 3)
+      {
+      *month = m;
+      return p + len;
+      }
+    }
   return NULL;
+  }
 
-  success:
-  if (utc) tz = "UTC0";
-  if (tz)
+
+/*=======================================================================
+datetime_parse_hm
+Read a time as HH:MM, after any spaces. Returns the position after
+it, or NULL
+=======================================================================*/
+static const char *datetime_parse_hm (const char *p, DateTimeFields *fields)
+  {
+  p = datetime_parse_number (p, 2, &fields->hour, NULL);
+  if (!p || *p++ != ':') return NULL;
+  p = datetime_parse_number (p, 2, &fields->minute, NULL);
+  if (!p || fields->hour > 23 || fields->minute > 59) return NULL;
+  return p;
+  }
+
+
+/*=======================================================================
+datetime_parse_year
+Read a year of up to four digits. A year of one or two digits is
+taken to be in the 2000s
+=======================================================================*/
+static const char *datetime_parse_year (const char *p, 
+    DateTimeFields *fields)
+  {
+  int ndigits;
+  p = datetime_parse_number (p, 4, &fields->year, &ndigits);
+  if (!p) return NULL;
+  if (ndigits <= 2) fields->year += 2000;
+  fields->has_year = TRUE;
+  return p;
+  }
+
+
+/*=======================================================================
+datetime_parse_iso_time
+Read the time part of an ISO-8601 date and time: HH:MM, then 
+optionally :SS and a decimal fraction of a second, which is dropped, 
+then optionally Z or an offset of the form +HH, +HH:MM or +HHMM.
+Returns the position after it, or NULL
+=======================================================================*/
+static const char *datetime_parse_iso_time (const char *p, 
+    DateTimeFields *fields)
+  {
+  if (!(p = datetime_parse_digits (p, 2, &fields->hour))) return NULL;
+  if (*p++ != ':') return NULL;
+  if (!(p = datetime_parse_digits (p, 2, &fields->minute))) return NULL;
+  if (*p == ':')
     {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
+    if (!(p = datetime_parse_digits (p + 1, 2, &fields->second))) 
+      return NULL;
+    if (*p == '.' || *p == ',')
+      {
+      p++;
+      if (*p < '0' || *p > '9') return NULL;
+      while (*p >= '0' && *p <= '9') p++;
+      }
+    }
+  // 24:00 is the end of the day, which ISO-8601 allows
+  if (fields->hour > 24 || fields->minute > 59 || fields->second > 59
+      || (fields->hour == 24 && (fields->minute || fields->second)))
+    return NULL;
+
+  if (*p == 'Z' || *p == 'z')
+    {
+    fields->has_offset = TRUE;
+    fields->offset = 0;
+    return p + 1;
     }
-  utime = mktime (&tm);
-  if (tz)
+  if (*p == '+' || *p == '-')
     {
-    ////if (oldtz)
+    int sign = *p++ == '-' ? -1 : 1;
+    int hours, minutes = 0;
+    if (!(p = datetime_parse_digits (p, 2, &hours))) return NULL;
+    if (*p == ':')
       {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
+      if (!(p = datetime_parse_digits (p + 1, 2, &minutes))) return NULL;
       }
-    //unmy_setenv ("TZ");
+    else if (*p >= '0' && *p <= '9')
+      {
+      if (!(p = datetime_parse_digits (p, 2, &minutes))) return NULL;
+      }
+    if (hours > 23 || minutes > 59) return NULL;
+    fields->has_offset = TRUE;
+    fields->offset = sign * (hours * 3600 + minutes * 60);
+    }
+  return p;
+  }
+
+
+/*=======================================================================
+datetime_parse_iso
+Read an ISO-8601 date, YYYY-MM-DD or YYYY-DDD, with p just after the
+year, optionally followed by a T, or a space, and a time
+=======================================================================*/
+static const char *datetime_parse_iso (const char *p, 
+    DateTimeFields *fields)
+  {
+  int n, ndigits;
+  fields->has_year = TRUE;
+  p = datetime_parse_digits (p, 2, &n);
+  if (!p) return NULL;
+  if (*p >= '0' && *p <= '9')
+    {
+    // Three digits make a day of the year
+    ndigits = 3;
+    n = n * 10 + (*p++ - '0');
+    }
+  else
+    {
+    ndigits = 2;
+    fields->month = n;
+    if (*p++ != '-') return NULL;
+    if (!(p = datetime_parse_digits (p, 2, &fields->day))) return NULL;
+    }
+
+  if (ndigits == 3)
+    {
+    int ndays = timeutil_is_leap_year (fields->year) ? 366 : 365;
+    if (n < 1 || n > ndays) return NULL;
+    int64_t year;
+    timeutil_civil_from_days (timeutil_days_from_civil 
+      (fields->year, JAN, 1) + n - 1, &year, &fields->month, &fields->day);
+    fields->format = DATETIME_FORMAT_ISO_ORDINAL;
+    }
+  else
+    {
+    if (fields->month < 1 || fields->month > 12 || fields->day < 1 
+        || fields->day > timeutil_get_days_in_month (fields->year, 
+           fields->month))
+      return NULL;
+    fields->format = DATETIME_FORMAT_ISO_DATE;
     }
 
-  DateTime *dt = DateTime_new_utime (utime);
-  return dt;
+  if (*p == 'T' || *p == 't' || (*p == ' ' && p[1] >= '0' && p[1] <= '9'))
+    {
+    if (!(p = datetime_parse_iso_time (p + 1, fields))) return NULL;
+    fields->format = DATETIME_FORMAT_ISO_DATETIME;
+    }
+  return p;
+  }
+
+
+/*=======================================================================
+DateTime_parse_fields
+Parse a date and time in any of the forms that DateTimeFormat lists
+into 'fields', in a single pass and without calling the C library. 
+These are the forms that --datetime help describes, and ISO-8601 
+dates, ordinal dates, and dates and times. Returns FALSE, with 
+fields->format set to DATETIME_FORMAT_NONE, if the string is in 
+none of them
+=======================================================================*/
+BOOL DateTime_parse_fields (const char *str, DateTimeFields *fields)
+  {
+  const char *p = str;
+  int n, ndigits;
+  memset (fields, 0, sizeof (DateTimeFields));
+  fields->hour = 2;
+
+  while (*p == ' ') p++;
+  if (((*p | 0x20) >= 'a' && (*p | 0x20) <= 'z'))
+    {
+    // month_name DD [YYYY] [HH:MM]
+    p = datetime_parse_month_name (p, &fields->month);
+    if (p) p = datetime_parse_number (p, 2, &fields->day, NULL);
+    if (!p) goto fail;
+    fields->has_date = TRUE;
+    fields->format = DATETIME_FORMAT_MD;
+    const char *q = datetime_parse_number (p, 4, &n, NULL);
+    if (q && *q == ':')
+      {
+      p = datetime_parse_hm (p, fields);
+      fields->format = DATETIME_FORMAT_MD_HM;
+      }
+    else if (q)
+      {
+      p = datetime_parse_year (p, fields);
+      fields->format = DATETIME_FORMAT_MDY;
+      q = p;
+      while (*q == ' ') q++;
+      if (*q)
+        {
+        p = datetime_parse_hm (p, fields);
+        fields->format = DATETIME_FORMAT_MDY_HM;
+        }
+      }
+    }
+  else
+    {
+    if (!(p = datetime_parse_number (p, 4, &n, &ndigits))) goto fail;
+    switch (*p)
+      {
+      case '-':
+        // YYYY-MM-DD or YYYY-DDD
+        if (ndigits != 4) goto fail;
+        fields->year = n;
+        fields->has_date = TRUE;
+        p = datetime_parse_iso (p + 1, fields);
+        break;
+
+      case '/':
+        // DD/MM[/YYYY] [HH:MM]
+        fields->day = n;
+        fields->has_date = TRUE;
+        if (ndigits > 2) goto fail;
+        if (!(p = datetime_parse_number (p + 1, 2, &fields->month, NULL)))
+          goto fail;
+        fields->format = DATETIME_FORMAT_DM;
+        if (*p == '/')
+          {
+          p = datetime_parse_year (p + 1, fields);
+          fields->format = DATETIME_FORMAT_DMY;
+          }
+        if (p)
+          {
+          const char *q = p;
+          while (*q == ' ') q++;
+          if (*q)
+            {
+            p = datetime_parse_hm (p, fields);
+            fields->format = fields->has_year 
+              ? DATETIME_FORMAT_DMY_HM : DATETIME_FORMAT_DM_HM;
+            }
+          }
+        break;
+
+      case ':':
+        // HH:MM, today
+        fields->format = DATETIME_FORMAT_HM;
+        p = datetime_parse_hm (str, fields);
+        break;
+
+      case '#':
+        {
+        // DDD#YYYY
+        if (ndigits > 3) goto fail;
+        p = datetime_parse_year (p + 1, fields);
+        if (!p) goto fail;
+        int ndays = timeutil_is_leap_year (fields->year) ? 366 : 365;
+        if (n < 1 || n > ndays) goto fail;
+        int64_t year;
+        timeutil_civil_from_days (timeutil_days_from_civil 
+          (fields->year, JAN, 1) + n - 1, &year, &fields->month, 
+          &fields->day);
+        fields->has_date = TRUE;
+        fields->format = DATETIME_FORMAT_DOY;
+        }
+        break;
+
+      default:
+        goto fail;
+      }
+    }
+
+  if (!p) goto fail;
+  if (fields->has_date && (fields->day < 1 || fields->day > 31 
+      || fields->month < 1 || fields->month > 12)) goto fail;
+  while (*p == ' ') p++;
+  if (*p == 0) return TRUE;
+
+  fail:
+  memset (fields, 0, sizeof (DateTimeFields));
+  return FALSE;
+  }
+
+
+/*=======================================================================
+DateTimeFields_get_utime
+The universal time of the parsed date and time in zone tz, or UTC if
+utc is set, unless the string gave its own offset. Parts of the date
+that were not given are today's, in the system's local zone, which is
+the only time the clock is read
+=======================================================================*/
+time_t DateTimeFields_get_utime (const DateTimeFields *self, 
+    const char *tz, BOOL utc)
+  {
+  struct tm tm;
+  memset (&tm, 0, sizeof (tm));
+  if (!self->has_year || !self->has_date)
+    ZoneInfo_localtime (ZoneInfo_get (NULL), time (NULL), &tm);
+  if (self->has_year) tm.tm_year = self->year - 1900;
+  if (self->has_date)
+    {
+    tm.tm_mon = self->month - 1;
+    tm.tm_mday = self->day;
+    }
+  tm.tm_hour = self->hour;
+  tm.tm_min = self->minute;
+  tm.tm_sec = self->second;
+
+  if (self->has_offset)
+    return (time_t) (timeutil_civil_to_unix (tm.tm_year + 1900, 
+      tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec) 
+      - self->offset);
+
+  tm.tm_isdst = -1;
+  if (utc) tz = "UTC0";
+  return ZoneInfo_mktime (ZoneInfo_get (tz), &tm);
+  }
+
+
+/*=======================================================================
+DateTime_new_parse
+=======================================================================*/
+DateTime *DateTime_new_parse (const char *str, Error **error, const char *tz,
+    BOOL utc)
+  {
+  return DateTime_new_parse_in (NULL, str, error, tz, utc);
+  }
+
+
+/*=======================================================================
+DateTime_new_parse_in
+As DateTime_new_parse, but the result, or the error, is allocated from
+'arena', or from the heap if arena is NULL
+=======================================================================*/
+DateTime *DateTime_new_parse_in (Arena *arena, const char *str, 
+    Error **error, const char *tz, BOOL utc)
+  {
+  DateTimeFields fields;
+  if (!DateTime_parse_fields (str, &fields))
+    {
+    *error = Error_new_in (arena, "Can't parse date");
+    return NULL;
+    }
+  return DateTime_new_value_in (arena, DateTimeValue_from_utime 
+    (DateTimeFields_get_utime (&fields, tz, utc)));
   }
 
 /*=======================================================================
@@ -223,23 +586,21 @@ DateTime *DateTime_new_dmy (int day, int month, int year,
   }
 
 /*=======================================================================
-DateTime_new_dmy_name
-Creates a new datetime at midnight on the specified date. Note that
-we need to pass timezone info, because midnight in one zone is not
-the same universal time as midnight in another
+DateTimeValue_from_dmy
+Midnight on the specified date, with the specified name, which may be
+NULL. Note that we need to pass timezone info, because midnight in one
+zone is not the same universal time as midnight in another
 =======================================================================*/
-DateTime *DateTime_new_dmy_name (int day, int month, int year, 
+DateTimeValue DateTimeValue_from_dmy (int day, int month, int year, 
     const char *name, const char *tz, BOOL utc)
   {
   struct tm tm;
-  time_t utime = 0;
-  char *oldtz = NULL;
-  if (utc) tz = "UTC0";
-  if (tz)
+  DateTimeValue r;
+  if (utc) 
     {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
+    r = DateTimeValue_from_utime (timeutil_civil_to_unix 
+      (year, month, day, 0, 0, 0));
+    return DateTimeValue_with_name (r, name);
     }
   tm.tm_mday = day;
   tm.tm_mon = month - 1;
@@ -248,21 +609,21 @@ DateTime *DateTime_new_dmy_name (int day, int month, int year,
   tm.tm_min = 0; 
   tm.tm_sec = 0; 
   tm.tm_isdst = -1; 
-  utime = mktime (&tm);
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
+  r = DateTimeValue_from_utime (ZoneInfo_mktime (ZoneInfo_get (tz), &tm));
+  return DateTimeValue_with_name (r, name);
+  }
 
-  DateTime *r = DateTime_new_utime (utime);
-  DateTime_set_name (r, name);
-  return r;
+
+/*=======================================================================
+DateTime_new_dmy_name
+Creates a new datetime at midnight on the specified date, as
+DateTimeValue_from_dmy does
+=======================================================================*/
+DateTime *DateTime_new_dmy_name (int day, int month, int year, 
+    const char *name, const char *tz, BOOL utc)
+  {
+  return DateTime_new_value (DateTimeValue_from_dmy (day, month, year, 
+    name, tz, utc));
   }
 
 /*=======================================================================
@@ -270,55 +631,194 @@ DateTime_new_today
 =======================================================================*/
 DateTime *DateTime_new_today (void)
   {
-  return DateTime_new_utime (time (NULL));
+  return DateTime_new_today_in (NULL);
   }
 
 
 /*=======================================================================
-DateTime_date_to_string_syslocal
-Caller must free string
+DateTime_new_today_in
+As DateTime_new_today, but allocated from 'arena', or from the heap if
+arena is NULL
 =======================================================================*/
-char *DateTime_date_to_string_syslocal (const DateTime *self)
+DateTime *DateTime_new_today_in (Arena *arena)
   {
-  struct tm *tm = localtime(&(self->priv->utime));
-  char s[100];
-  strftime (s, sizeof (s), "%A %e %B %Y", tm);
-  return strdup (s);
+  return DateTime_new_value_in (arena, DateTimeValue_from_utime 
+    (time (NULL)));
   }
 
 
 /*=======================================================================
-DateTime_date_to_string_syslocal
-Caller must free string
+datetime_formatter_init_zone
 =======================================================================*/
-char *DateTime_date_to_string_local (const DateTime *self, const char *tz)
+static void datetime_formatter_init_zone (DateTimeFormatter *self, 
+    const ZoneInfo *zone, BOOL twelve_hour, BOOL zero_pad_hour)
+  {
+  self->zone = zone;
+  self->twelve_hour = twelve_hour;
+  self->zero_pad_hour = zero_pad_hour;
+  // An empty span, so that the first time looks up the offset
+  self->offset.from = INT64_MAX;
+  self->offset.until = INT64_MIN;
+  }
+
+
+/*=======================================================================
+DateTimeFormatter_init
+Set up a formatter for the system's local zone if syslocal is set, 
+otherwise for UTC if utc is set, otherwise for the zone tz
+=======================================================================*/
+void DateTimeFormatter_init (DateTimeFormatter *self, const char *tz,
+     BOOL utc, BOOL syslocal, BOOL twelve_hour)
+  {
+  if (syslocal)
+    datetime_formatter_init_zone (self, ZoneInfo_get (NULL), 
+      twelve_hour, FALSE);
+  else if (utc)
+    datetime_formatter_init_zone (self, ZoneInfo_get ("UTC0"), 
+      twelve_hour, TRUE);
+  else
+    datetime_formatter_init_zone (self, ZoneInfo_get (tz), 
+      twelve_hour, FALSE);
+  }
+
+
+/*=======================================================================
+datetime_formatter_local
+The local time, in seconds since 1970-01-01 00:00 local
+=======================================================================*/
+static int64_t datetime_formatter_local (DateTimeFormatter *self, 
+    time_t utime)
   {
-  char *oldtz = NULL;
-  if (tz)
+  int64_t t = utime;
+  if (t < self->offset.from || t >= self->offset.until)
+    ZoneInfo_get_offset_span (self->zone, utime, &self->offset);
+  return t + self->offset.utoff;
+  }
+
+
+/*=======================================================================
+datetime_put_int
+Write n, with at least 'width' digits padded with 'pad', and return
+the next position in the buffer
+=======================================================================*/
+static char *datetime_put_int (char *p, int64_t n, int width, char pad)
+  {
+  char digits[24];
+  int len = 0;
+  uint64_t u = n < 0 ? -(uint64_t)n : (uint64_t)n;
+  do
     {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
-  struct tm *tm = localtime(&(self->priv->utime));
-  char s[100];
-  strftime (s, sizeof (s), "%A %e %B %Y", tm);
-  if (s[strlen(s) - 1] == 10) s[strlen(s) - 1] = 0;
+    digits[len++] = '0' + u % 10;
+    u /= 10;
+    } while (u);
+  if (n < 0) *p++ = '-';
+  for (; width > len; width--) *p++ = pad;
+  while (len) *p++ = digits[--len];
+  return p;
+  }
 
-  if (tz)
+
+/*=======================================================================
+DateTimeFormatter_time
+Write the time as HH:MM, or HH:MM am/pm, into buf, which must have
+room for DATETIME_TIME_BUFSIZE characters. Returns the length
+=======================================================================*/
+int DateTimeFormatter_time (DateTimeFormatter *self, time_t utime, 
+     char *buf)
+  {
+  int64_t local = datetime_formatter_local (self, utime);
+  int secs = (int)(local - timeutil_floor_div (local, SECONDS_PER_DAY) 
+    * SECONDS_PER_DAY);
+  int hour = secs / 3600;
+  int min = (secs / 60) % 60;
+  char *p = buf;
+  if (self->twelve_hour)
     {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
+    p = datetime_put_int (p, hour <= 12 ? hour : hour - 12, 2, 
+      self->zero_pad_hour ? '0' : ' ');
+    *p++ = ':';
+    p = datetime_put_int (p, min, 2, '0');
+    *p++ = ' ';
+    *p++ = hour >= 12 ? 'p' : 'a';
+    *p++ = 'm';
     }
+  else
+    {
+    p = datetime_put_int (p, hour, 2, '0');
+    *p++ = ':';
+    p = datetime_put_int (p, min, 2, '0');
+    }
+  *p = 0;
+  return p - buf;
+  }
+
+
+/*=======================================================================
+DateTimeFormatter_date
+Write the date as, for example, "Monday  1 January 2024", into buf,
+which must have room for DATETIME_DATE_BUFSIZE characters. Returns
+the length
+=======================================================================*/
+int DateTimeFormatter_date (DateTimeFormatter *self, time_t utime, 
+     char *buf)
+  {
+  static const char *day_names[7] = {"Sunday", "Monday", "Tuesday",
+    "Wednesday", "Thursday", "Friday", "Saturday"};
+  int64_t days = timeutil_floor_div (datetime_formatter_local 
+    (self, utime), SECONDS_PER_DAY);
+  int64_t year;
+  int month, day;
+  timeutil_civil_from_days (days, &year, &month, &day);
+
+  // 1970-01-01 was a Thursday
+  const char *s = day_names [((days % 7) + 7 + 4) % 7];
+  char *p = buf;
+  while (*s) *p++ = *s++;
+  *p++ = ' ';
+  p = datetime_put_int (p, day, 2, ' ');
+  *p++ = ' ';
+  s = timeutil_get_month_name_english (month);
+  while (*s) *p++ = *s++;
+  *p++ = ' ';
+  p = datetime_put_int (p, year, 1, '0');
+  *p = 0;
+  return p - buf;
+  }
+
+
+/*=======================================================================
+datetime_date_to_string
+Caller must free string
+=======================================================================*/
+static char *datetime_date_to_string (const DateTime *self, 
+    const ZoneInfo *zone)
+  {
+  DateTimeFormatter f;
+  datetime_formatter_init_zone (&f, zone, FALSE, FALSE);
+  char s[DATETIME_DATE_BUFSIZE];
+  DateTimeFormatter_date (&f, self->priv->value.utime, s);
   return strdup (s);
   }
 
 
+/*=======================================================================
+DateTime_date_to_string_syslocal
+Caller must free string
+=======================================================================*/
+char *DateTime_date_to_string_syslocal (const DateTime *self)
+  {
+  return datetime_date_to_string (self, ZoneInfo_get (NULL));
+  }
+
+
+/*=======================================================================
+DateTime_date_to_string_local
+Caller must free string
+=======================================================================*/
+char *DateTime_date_to_string_local (const DateTime *self, const char *tz)
+  {
+  return datetime_date_to_string (self, ZoneInfo_get (tz));
+  }
 
 
 /*=======================================================================
@@ -327,9 +827,22 @@ Caller must free string
 =======================================================================*/
 char *DateTime_date_to_string_UTC (const DateTime *self)
   {
-  struct tm *tm = gmtime(&(self->priv->utime));
+  return datetime_date_to_string (self, ZoneInfo_get ("UTC0"));
+  }
+
+
+/*=======================================================================
+datetime_to_ctime_string
+Format the date and time in the specified zone, in the same way as 
+ctime(), but without the trailing newline. Caller must free string
+=======================================================================*/
+static char *datetime_to_ctime_string (const DateTime *self, 
+    const ZoneInfo *zone)
+  {
+  struct tm tm;
+  ZoneInfo_localtime (zone, self->priv->value.utime, &tm);
   char s[100];
-  strftime (s, sizeof (s), "%A %e %B %Y", tm);
+  strftime (s, sizeof (s), "%a %b %e %H:%M:%S %Y", &tm);
   return strdup (s);
   }
 
@@ -341,26 +854,7 @@ If tz is null, gives the local time at the home locale
 =======================================================================*/
 char *DateTime_to_string_local (const DateTime *self, const char *tz)
   {
-  char *oldtz = NULL;
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
-  char *s = ctime (&(self->priv->utime));
-  if (s[strlen(s) - 1] == 10) s[strlen(s) - 1] = 0;
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
-  return strdup (s);
+  return datetime_to_ctime_string (self, ZoneInfo_get (tz));
   }
 
 
@@ -370,9 +864,7 @@ Caller must free string
 =======================================================================*/
 char *DateTime_to_string_syslocal (const DateTime *self)
   {
-  char *s = ctime (&(self->priv->utime));
-  if (s[strlen(s) - 1] == 10) s[strlen(s) - 1] = 0;
-  return strdup (s);
+  return datetime_to_ctime_string (self, ZoneInfo_get (NULL));
   }
 
 
@@ -382,26 +874,24 @@ Caller must free string
 =======================================================================*/
 char *DateTime_to_string_UTC (const DateTime *self)
   {
-  char *oldtz = NULL;
-  char *tz = "GMT0";
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
-  char *s = ctime (&(self->priv->utime));
-  if (s[strlen(s) - 1] == 10) s[strlen(s) - 1] = 0;
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
+  return datetime_to_ctime_string (self, ZoneInfo_get ("GMT0"));
+  }
+
+
+/*=======================================================================
+datetime_time_to_string
+Format the time as HH:MM, or as HH:MM am/pm, in the specified zone.
+The UTC format has always had a leading zero on the hour in the 
+twelve-hour form, and the others a space
+Caller must free string
+=======================================================================*/
+static char *datetime_time_to_string (const DateTime *self, 
+    const ZoneInfo *zone, BOOL twelve_hour, BOOL zero_pad_hour)
+  {
+  DateTimeFormatter f;
+  datetime_formatter_init_zone (&f, zone, twelve_hour, zero_pad_hour);
+  char s[DATETIME_TIME_BUFSIZE];
+  DateTimeFormatter_time (&f, self->priv->value.utime, s);
   return strdup (s);
   }
 
@@ -412,36 +902,8 @@ Caller must free string
 =======================================================================*/
 char *DateTime_time_to_string_UTC (const DateTime *self, BOOL twelve_hour)
   {
-  char *oldtz = NULL;
-  char *tz = "UTC0";
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
-  struct tm *tm = localtime(&(self->priv->utime));
-  //struct tm *tm = gmtime(&(self->priv->utime));
-  char s[20];
-  if (twelve_hour)
-    {
-    snprintf (s, sizeof (s), "%02d:%02d %s", 
-      tm->tm_hour <= 12  ? tm->tm_hour : tm->tm_hour - 12 , tm->tm_min,
-      tm->tm_hour >= 12 ? "pm": "am");
-    }
-  else
-    snprintf (s, sizeof (s), "%02d:%02d", tm->tm_hour, tm->tm_min);
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
-  return strdup (s);
+  return datetime_time_to_string (self, ZoneInfo_get ("UTC0"), 
+    twelve_hour, TRUE);
   }
 
 
@@ -452,36 +914,8 @@ Caller must free string
 char *DateTime_time_to_string_local (const DateTime *self, const char *tz, 
     BOOL twelve_hour)
   {
-  char *oldtz = NULL;
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
-  struct tm *tm = localtime(&(self->priv->utime));
-  char s[20];
-  if (twelve_hour)
-    {
-    snprintf (s, sizeof (s), "%2d:%02d %s", 
-      tm->tm_hour <= 12  ? tm->tm_hour : tm->tm_hour - 12 , tm->tm_min,
-      tm->tm_hour >= 12 ? "pm": "am");
-    }
-  else
-    //snprintf (s, sizeof (s), "%02d:%02d", tm->tm_hour, tm->tm_min);
-    //snprintf (s, sizeof (s), "%02d:%02d %d/%d", tm->tm_hour, tm->tm_min, tm->tm_mday, tm->tm_mon + 1);
-    snprintf (s, sizeof (s), "%02d:%02d", tm->tm_hour, tm->tm_min);
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
-  return strdup (s);
+  return datetime_time_to_string (self, ZoneInfo_get (tz), 
+    twelve_hour, FALSE);
   }
 
 
@@ -491,17 +925,8 @@ Caller must free string
 =======================================================================*/
 char *DateTime_time_to_string_syslocal (const DateTime *self, BOOL twelve_hour)
   {
-  struct tm *tm = localtime(&(self->priv->utime));
-  char s[20];
-  if (twelve_hour)
-    {
-    snprintf (s, sizeof (s), "%2d:%02d %s", 
-      tm->tm_hour <= 12  ? tm->tm_hour : tm->tm_hour - 12 , tm->tm_min,
-      tm->tm_hour >= 12 ? "pm": "am");
-    }
-  else
-    snprintf (s, sizeof (s), "%02d:%02d", tm->tm_hour, tm->tm_min);
-  return strdup (s);
+  return datetime_time_to_string (self, ZoneInfo_get (NULL), 
+    twelve_hour, FALSE);
   }
 
 
@@ -511,43 +936,32 @@ DateTime_free
 void DateTime_free (DateTime *self)
   {
   if (!self) return;
-  if (self->priv)
-    {
-    if (self->priv->name) free (self->priv->name);
-    free (self->priv);
-    }
-  free (self);
+  Arena_free_object (self->priv->arena, self);
   }
 
 
 /*=======================================================================
-DateTime_get_day_of_year
+DateTimeValue_get_day_of_year
+Note that the day is reckoned in UTC
 =======================================================================*/
-int DateTime_get_day_of_year (const DateTime *self, const char *tz)
+int DateTimeValue_get_day_of_year (DateTimeValue self)
   {
   struct tm tm;
-  char *oldtz = NULL;
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
-  memcpy (&tm, gmtime (&self->priv->utime), sizeof (struct tm));
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
+  ZoneInfo_gmtime (self.utime, &tm);
   return tm.tm_yday + 1;
   }
 
 
+/*=======================================================================
+DateTime_get_day_of_year
+Note that the day is reckoned in UTC, whatever the zone
+=======================================================================*/
+int DateTime_get_day_of_year (const DateTime *self)
+  {
+  return DateTimeValue_get_day_of_year (self->priv->value);
+  }
+
+
 /*=======================================================================
 DateTime_set_time_hours_fracion
 =======================================================================*/
@@ -555,7 +969,7 @@ void DateTime_set_time_hours_fraction (DateTime *self, double hours)
   {
   struct tm tm;
   double h, m, s;
-  memcpy (&tm, gmtime (&self->priv->utime), sizeof (struct tm));
+  ZoneInfo_gmtime (self->priv->value.utime, &tm);
   h = floor (hours);
   m = floor ((hours - h) * 60);
   s = (hours - h - m / 60) * 3600;
@@ -563,27 +977,25 @@ void DateTime_set_time_hours_fraction (DateTime *self, double hours)
   tm.tm_min = m;
   tm.tm_sec = s;
 
-  char *oldtz = NULL;
-  char *tz = "UTC0";
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
+  self->priv->value.utime = ZoneInfo_mktime (ZoneInfo_get ("UTC0"), &tm);
+  }
 
-  self->priv->utime = mktime (&tm);
 
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    }
+/*=======================================================================
+DateTime_get_utime
+=======================================================================*/
+time_t DateTime_get_utime (const DateTime *self)
+  {
+  return self->priv->value.utime;
+  }
 
+
+/*=======================================================================
+DateTimeValue_get_julian_date
+=======================================================================*/
+double DateTimeValue_get_julian_date (DateTimeValue self)
+  {
+  return timeutil_unix_to_JD (self.utime);
   }
 
 
@@ -592,8 +1004,16 @@ DateTime_get_juian_date
 =======================================================================*/
 double DateTime_get_julian_date (const DateTime *self)
   {
-  double jd = timeutil_unix_to_JD (self->priv->utime);
-  return jd; 
+  return DateTimeValue_get_julian_date (self->priv->value);
+  }
+
+
+/*=======================================================================
+DateTimeValue_get_modified_julian_date
+=======================================================================*/
+double DateTimeValue_get_modified_julian_date (DateTimeValue self)
+  {
+  return timeutil_unix_to_MJD (self.utime);
   }
 
 
@@ -602,88 +1022,80 @@ DateTime_get_modified_juian_date
 =======================================================================*/
 double DateTime_get_modified_julian_date (const DateTime *self)
   {
-  double jd = timeutil_unix_to_MJD (self->priv->utime);
-  return jd; 
+  return DateTimeValue_get_modified_julian_date (self->priv->value);
   }
 
 
 /*=======================================================================
-DateTime_get_day_start
-Caller must free result
+datetime_value_set_time_of_day
+The time h:m:s on the day in zone, in which self falls. The name is
+not kept
+=======================================================================*/
+static DateTimeValue datetime_value_set_time_of_day (DateTimeValue self, 
+    const ZoneInfo *zone, int h, int m, int s)
+  {
+  struct tm tm;
+  ZoneInfo_localtime (zone, self.utime, &tm);
+  tm.tm_hour = h;
+  tm.tm_min = m;
+  tm.tm_sec = s;
+  return DateTimeValue_from_utime (ZoneInfo_mktime (zone, &tm));
+  }
+
+
+/*=======================================================================
+DateTimeValue_get_day_start
 Get midnight on the day in which this datetime falls
 Umm... I'm not sure if we should take DST into account here
 =======================================================================*/
-DateTime *DateTime_get_day_start (const DateTime *self, const char *tz)
+DateTimeValue DateTimeValue_get_day_start (DateTimeValue self, 
+    const char *tz)
   {
-  char *oldtz = NULL;
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
-
-  struct tm tm;
-  memcpy (&tm, localtime (&self->priv->utime), sizeof (struct tm));
-  tm.tm_hour = 0;
-  tm.tm_min = 0;
-  tm.tm_sec = 0;
+  return datetime_value_set_time_of_day (self, ZoneInfo_get (tz), 0, 0, 0);
+  }
 
-  time_t utime = mktime (&tm);
 
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
+/*=======================================================================
+DateTime_get_day_start
+Caller must free result
+=======================================================================*/
+DateTime *DateTime_get_day_start (const DateTime *self, const char *tz)
+  {
+  return DateTime_new_value (DateTimeValue_get_day_start 
+    (self->priv->value, tz));
+  }
 
-  DateTime *dt = DateTime_new_utime (utime);
 
-  return dt;
+/*=======================================================================
+DateTimeValue_get_day_end
+Get 23:59:59 on the day in which this datetime falls
+=======================================================================*/
+DateTimeValue DateTimeValue_get_day_end (DateTimeValue self, 
+    const char *tz)
+  {
+  return datetime_value_set_time_of_day (self, ZoneInfo_get (tz), 
+    23, 59, 59);
   }
 
 
 /*=======================================================================
 DateTime_get_day_end
 Caller must free result
-Get 23:59:59 on the day in which this datetime falls
 =======================================================================*/
 DateTime *DateTime_get_day_end (const DateTime *self, const char *tz)
   {
-  char *oldtz = NULL;
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
-
-  struct tm tm;
-  memcpy (&tm, localtime (&self->priv->utime), sizeof (struct tm));
-  tm.tm_hour = 23;
-  tm.tm_min = 59;
-  tm.tm_sec = 59;
-
-  time_t utime = mktime (&tm);
+  return DateTime_new_value (DateTimeValue_get_day_end 
+    (self->priv->value, tz));
+  }
 
-  if (tz)
-    {
-    if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
 
-  DateTime *dt = DateTime_new_utime (utime);
-  return dt;
+/*=======================================================================
+DateTimeValue_seconds_difference
+=======================================================================*/
+long DateTimeValue_seconds_difference (DateTimeValue start, 
+    DateTimeValue end)
+  {
+  return end.utime - start.utime;
   }
 
 
@@ -692,7 +1104,18 @@ DateTime_seconds_difference
 =======================================================================*/
 long DateTime_seconds_difference (const DateTime *start, const DateTime *end)
   {
-  return end->priv->utime - start->priv->utime;
+  return DateTimeValue_seconds_difference (start->priv->value, 
+    end->priv->value);
+  }
+
+
+/*=======================================================================
+DateTimeValue_add_seconds
+=======================================================================*/
+DateTimeValue DateTimeValue_add_seconds (DateTimeValue self, long seconds)
+  {
+  self.utime += seconds;
+  return self;
   }
 
 
@@ -701,107 +1124,112 @@ DateTime_add_seconds
 =======================================================================*/
 void DateTime_add_seconds (DateTime *self, long seconds)
   {
-  self->priv->utime += seconds;
+  self->priv->value = DateTimeValue_add_seconds (self->priv->value, 
+    seconds);
   }
 
 
 /*=======================================================================
-DateTime_add_days
+DateTimeValue_add_days
 Nightmare! We can't just add 24*3600*days seconds, because we might be
 crossing at DST boundary. We want the same time on the days a certan
 distance from the current day
 =======================================================================*/
-void DateTime_add_days (DateTime *self, int days, const char *tz, BOOL utc)
+DateTimeValue DateTimeValue_add_days (DateTimeValue self, int days, 
+    const char *tz, BOOL utc)
   {
   struct tm tm;
-  char *oldtz = NULL;
-  if (utc) tz = "UTC0";
-  if (tz)
+  // A UTC day is always the same length
+  if (utc) 
     {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
+    self.utime += (int64_t)days * SECONDS_PER_DAY;
+    return self;
     }
+  const ZoneInfo *zone = ZoneInfo_get (tz);
 
-  memcpy (&tm, localtime (&(self->priv->utime)), sizeof (struct tm));
+  ZoneInfo_localtime (zone, self.utime, &tm);
 
-  // mktime seems to cope with mday values > 31 and < 0, by adjusting
-  //  the other fields to match. This even deals with DST. I am unsure
-  //  whether this behaviour can be relied up on all systems
+  // ZoneInfo_mktime, like mktime, copes with mday values > 31 and < 0, 
+  //  by adjusting the other fields to match. This even deals with DST. 
   tm.tm_mday += days;
 
   tm.tm_isdst = -1;
-  self->priv->utime = mktime (&tm);
+  self.utime = ZoneInfo_mktime (zone, &tm);
+  return self;
+  }
 
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
 
+/*=======================================================================
+DateTime_add_days
+=======================================================================*/
+void DateTime_add_days (DateTime *self, int days, const char *tz, BOOL utc)
+  {
+  self->priv->value = DateTimeValue_add_days (self->priv->value, days, 
+    tz, utc);
   }
 
 
 /*=======================================================================
-DateTime_is_same_day
+DateTimeValue_is_same_day
 Returns true if the two datetimes fall on the same calendar day
 Note -- don't need tz info despite use of gmtime, because if two 
 events are on the same day in one zone, they are on the same day in
 another, even if they both are on a different day
 =======================================================================*/
+BOOL DateTimeValue_is_same_day (DateTimeValue self, DateTimeValue other)
+  {
+  return timeutil_floor_div (self.utime, SECONDS_PER_DAY)
+    == timeutil_floor_div (other.utime, SECONDS_PER_DAY);
+  }
+
+
+/*=======================================================================
+DateTime_is_same_day
+=======================================================================*/
 BOOL DateTime_is_same_day (const DateTime *self, const DateTime *other)
   {
-  struct tm self_tm, other_tm;
-  struct tm *tm = gmtime(&(self->priv->utime));
-  memcpy (&self_tm, tm, sizeof (struct tm));
-  tm = gmtime(&(other->priv->utime));
-  memcpy (&other_tm, tm, sizeof (struct tm));
-  if (self_tm.tm_mday == other_tm.tm_mday 
-     && self_tm.tm_mon == other_tm.tm_mon 
-     && self_tm.tm_year == other_tm.tm_year) return TRUE;
-  return FALSE;
+  return DateTimeValue_is_same_day (self->priv->value, other->priv->value);
   }
 
 
 /*=======================================================================
-DateTime_is_same_day_of_year
+DateTimeValue_is_same_day_of_year
 As is_same_day, but ignores the year. This is important for comparing
 anniversaries: Christmas day is the 25th December in any year
 =======================================================================*/
-BOOL DateTime_is_same_day_of_year (const DateTime *self, const DateTime *other)
+BOOL DateTimeValue_is_same_day_of_year (DateTimeValue self, 
+    DateTimeValue other)
   {
   struct tm self_tm, other_tm;
-  struct tm *tm = gmtime(&(self->priv->utime));
-  memcpy (&self_tm, tm, sizeof (struct tm));
-  tm = gmtime(&(other->priv->utime));
-  memcpy (&other_tm, tm, sizeof (struct tm));
+  ZoneInfo_gmtime (self.utime, &self_tm);
+  ZoneInfo_gmtime (other.utime, &other_tm);
   if (self_tm.tm_mday == other_tm.tm_mday 
      && self_tm.tm_mon == other_tm.tm_mon) return TRUE;
   return FALSE;
   }
 
+
 /*=======================================================================
-DateTime_get_ymdhms
+DateTime_is_same_day_of_year
 =======================================================================*/
-void DateTime_get_ymdhms (const DateTime *self, int *year, int *month, int *day,
-      int *hours, int *minutes, int *seconds, const char *tz, BOOL utc)
+BOOL DateTime_is_same_day_of_year (const DateTime *self, const DateTime *other)
+  {
+  return DateTimeValue_is_same_day_of_year (self->priv->value, 
+    other->priv->value);
+  }
+
+
+/*=======================================================================
+DateTimeValue_get_ymdhms
+=======================================================================*/
+void DateTimeValue_get_ymdhms (DateTimeValue self, int *year, int *month, 
+      int *day, int *hours, int *minutes, int *seconds, const char *tz, 
+      BOOL utc)
   { 
   struct tm tm;
-  char *oldtz = NULL;
   if (utc) tz = "UTC0";
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
 
-  memcpy (&tm, localtime (&self->priv->utime), sizeof (struct tm));
+  ZoneInfo_localtime (ZoneInfo_get (tz), self.utime, &tm);
 
   *year = tm.tm_year + 1900;
   *month = tm.tm_mon + 1;
@@ -809,39 +1237,34 @@ void DateTime_get_ymdhms (const DateTime *self, int *year, int *month, int *day,
   *hours = tm.tm_hour;
   *minutes = tm.tm_min;
   *seconds = tm.tm_sec;
+  }
 
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
+
+/*=======================================================================
+DateTime_get_ymdhms
+=======================================================================*/
+void DateTime_get_ymdhms (const DateTime *self, int *year, int *month, int *day,
+      int *hours, int *minutes, int *seconds, const char *tz, BOOL utc)
+  { 
+  DateTimeValue_get_ymdhms (self->priv->value, year, month, day, 
+    hours, minutes, seconds, tz, utc);
   }
 
+
 /*=======================================================================
-DateTime_get_jan_first
+DateTimeValue_get_jan_first
 Get start of year -- midnight on january first. Note the we need tz 
 information, as midnight occurs at different universal times in 
 different zones.
 =======================================================================*/
-DateTime *DateTime_get_jan_first (const DateTime *self, 
+DateTimeValue DateTimeValue_get_jan_first (DateTimeValue self, 
      const char *tz, BOOL utc)
   {
   struct tm tm;
-  char *oldtz = NULL;
   if (utc) tz = "UTC0";
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
+  const ZoneInfo *zone = ZoneInfo_get (tz);
 
-  memcpy (&tm, localtime (&(self->priv->utime)), sizeof (struct tm));
+  ZoneInfo_localtime (zone, self.utime, &tm);
 
   tm.tm_mday = 0;
   tm.tm_mon = 0;
@@ -850,20 +1273,43 @@ DateTime *DateTime_get_jan_first (const DateTime *self,
   tm.tm_min = 0;
   tm.tm_sec = 0;
   tm.tm_isdst = -1;
-  DateTime *r = DateTime_new_utime (mktime (&tm));
+  return DateTimeValue_from_utime (ZoneInfo_mktime (zone, &tm));
+  }
 
-  if (tz)
-    {
-    //if (oldtz)
-      {
-      my_setenv ("TZ", oldtz, 1);
-      if (oldtz) free (oldtz);
-      tzset ();
-      }
-    //unmy_setenv ("TZ");
-    }
 
-  return r;
+/*=======================================================================
+DateTime_get_jan_first
+Caller must free result
+=======================================================================*/
+DateTime *DateTime_get_jan_first (const DateTime *self, 
+     const char *tz, BOOL utc)
+  {
+  return DateTime_new_value (DateTimeValue_get_jan_first 
+    (self->priv->value, tz, utc));
+  }
+
+
+/*=======================================================================
+DateTimeValue_format_time
+Write the time into buf, which must have room for 
+DATETIME_TIME_BUFSIZE characters, as DateTimeFormatter_time does
+=======================================================================*/
+int DateTimeValue_format_time (DateTimeValue self, 
+    DateTimeFormatter *formatter, char *buf)
+  {
+  return DateTimeFormatter_time (formatter, self.utime, buf);
+  }
+
+
+/*=======================================================================
+DateTimeValue_format_date
+Write the date into buf, which must have room for 
+DATETIME_DATE_BUFSIZE characters, as DateTimeFormatter_date does
+=======================================================================*/
+int DateTimeValue_format_date (DateTimeValue self, 
+    DateTimeFormatter *formatter, char *buf)
+  {
+  return DateTimeFormatter_date (formatter, self.utime, buf);
   }
 
 
@@ -875,11 +1321,7 @@ supplied
 DateTime *DateTime_clone_offset_days (const DateTime *dt, int days, 
      const char *name, const char *tz, BOOL utc) 
   {
-  DateTime *r = DateTime_clone (dt);
-  DateTime_set_name (r, name);
-  DateTime_add_days (r, days, tz, utc);
-  return r;
+  DateTimeValue v = DateTimeValue_with_name (dt->priv->value, name);
+  return DateTime_new_value (DateTimeValue_add_days (v, days, tz, utc));
   }
 
-
-
@@ -5,33 +5,130 @@ datetime.h
 =======================================================================*/
 #pragma once
 
+#include <time.h>
+#include <stdint.h>
 #include "defs.h"
 #include "error.h"
+#include "zoneinfo.h"
+#include "arena.h"
+
+// Room for the longest time a DateTimeFormatter writes, "12:59 pm", 
+//  and its terminating zero
+#define DATETIME_TIME_BUFSIZE 16
+// Room for the longest date, "Wednesday 30 September" and a year
+#define DATETIME_DATE_BUFSIZE 48
 
 typedef struct _DateTime
   {
   struct _DateTimePriv *priv;
   } DateTime;
 
+/*=======================================================================
+DateTimeValue
+A date and time held by value, rather than behind a pointer: seconds 
+since the epoch, and an optional name. The name is interned, so it is
+never freed, and two names are the same if their pointers are. The 
+whole thing fits in two registers, so it can be passed and returned 
+by value, and needs no allocation. A DateTime wraps one of these
+=======================================================================*/
+typedef struct _DateTimeValue
+  {
+  int64_t utime;
+  const char *name;
+  } DateTimeValue;
+
+// The forms of date and time that DateTime_parse_fields recognizes
+typedef enum _DateTimeFormat
+  {
+  DATETIME_FORMAT_NONE = 0,
+  DATETIME_FORMAT_DMY_HM,     // 17/10/2026 05:30
+  DATETIME_FORMAT_DMY,        // 17/10/2026
+  DATETIME_FORMAT_DM_HM,      // 17/10 05:30
+  DATETIME_FORMAT_DM,         // 17/10
+  DATETIME_FORMAT_MDY_HM,     // Oct 17 2026 05:30
+  DATETIME_FORMAT_MD_HM,      // Oct 17 05:30
+  DATETIME_FORMAT_MDY,        // Oct 17 2026
+  DATETIME_FORMAT_MD,         // Oct 17
+  DATETIME_FORMAT_HM,         // 05:30
+  DATETIME_FORMAT_DOY,        // 290#2026
+  DATETIME_FORMAT_ISO_DATE,   // 2026-10-17
+  DATETIME_FORMAT_ISO_ORDINAL,// 2026-290
+  DATETIME_FORMAT_ISO_DATETIME// 2026-10-17T05:30, with :SS, a zone...
+  } DateTimeFormat;
+
+/*=======================================================================
+DateTimeFields
+The parts of a date and time as they were written, before any zone
+is applied. Parts that were not given are left for 
+DateTimeFields_get_utime to fill in: the date from today's, and the 
+time as 02:00
+=======================================================================*/
+typedef struct _DateTimeFields
+  {
+  DateTimeFormat format;
+  int year;
+  int month;
+  int day;
+  int hour;
+  int minute;
+  int second;
+  BOOL has_year;
+  BOOL has_date;
+  // Set if the string gave its own offset from UTC, in seconds east,
+  //  which then takes the place of the zone's
+  BOOL has_offset;
+  int offset;
+  } DateTimeFields;
+
+/*=======================================================================
+DateTimeFormatter
+Formats times and dates in one zone, in the same forms as the
+DateTime _to_string functions, into buffers supplied by the caller.
+The zone's offset is kept, with the span of time for which it holds,
+so that it is only looked up again when a time falls outside that
+span. A formatter must not be shared between threads
+=======================================================================*/
+typedef struct _DateTimeFormatter
+  {
+  const ZoneInfo *zone;
+  BOOL twelve_hour;
+  // Pad the hour of a twelve-hour time with a zero, as the UTC form 
+  //  always has, rather than a space
+  BOOL zero_pad_hour;
+  ZoneOffset offset;
+  } DateTimeFormatter;
+
 
 void DateTime_free (DateTime *self);
 
 DateTime *DateTime_new_parse (const char *str, Error **error, const char *tz,
   BOOL utc);
 
+BOOL DateTime_parse_fields (const char *str, DateTimeFields *fields);
+
+time_t DateTimeFields_get_utime (const DateTimeFields *self, 
+  const char *tz, BOOL utc);
+
 DateTime *DateTime_new_today (void);
 
+DateTime *DateTime_new_parse_in (Arena *arena, const char *str, 
+  Error **error, const char *tz, BOOL utc);
+
+DateTime *DateTime_new_today_in (Arena *arena);
+
 DateTime *DateTime_new_centre (const DateTime *d1, const DateTime *d2);
 
 DateTime *DateTime_new_julian (double jd);
 
+DateTime *DateTime_new_utime (time_t utime);
+
 char *DateTime_to_string_local (const DateTime *self, const char *tz);
 
 char *DateTime_to_string_syslocal (const DateTime *self);
 
 char *DateTime_to_string_UTC (const DateTime *self);
 
-int DateTime_get_day_of_year (const DateTime *self, const char *tz);
+int DateTime_get_day_of_year (const DateTime *self);
 
 void DateTime_set_time_hours_fraction (DateTime *self, double hours);
 
@@ -45,6 +142,8 @@ char *DateTime_time_to_string_local (const DateTime *self, const char *tz,
 char *DateTime_time_to_string_syslocal (const DateTime *self, 
     BOOL twelve_hour);
 
+time_t DateTime_get_utime (const DateTime *self);
+
 double DateTime_get_julian_date (const DateTime *self);
 double DateTime_get_modified_julian_date (const DateTime *self);
 
@@ -78,6 +177,56 @@ void DateTime_add_days (DateTime *self, int days, const char *tz, BOOL UTC);
 DateTime *DateTime_get_jan_first (const DateTime *self, 
   const char *tz, BOOL utc);
 
+void DateTimeFormatter_init (DateTimeFormatter *self, const char *tz,
+     BOOL utc, BOOL syslocal, BOOL twelve_hour);
+
+int DateTimeFormatter_time (DateTimeFormatter *self, time_t utime, 
+     char *buf);
+
+int DateTimeFormatter_date (DateTimeFormatter *self, time_t utime, 
+     char *buf);
+
 DateTime *DateTime_clone_offset_days (const DateTime *dt, int days, 
      const char *name, const char *tz, BOOL utc);
 
+DateTime *DateTime_new_value (DateTimeValue value);
+DateTime *DateTime_new_value_in (Arena *arena, DateTimeValue value);
+DateTimeValue DateTime_get_value (const DateTime *self);
+void DateTime_set_value (DateTime *self, DateTimeValue value);
+
+DateTimeValue DateTimeValue_from_utime (int64_t utime);
+DateTimeValue DateTimeValue_from_julian (double jd);
+DateTimeValue DateTimeValue_from_dmy (int day, int month, int year, 
+     const char *name, const char *tz, BOOL utc);
+DateTimeValue DateTimeValue_centre (DateTimeValue d1, DateTimeValue d2);
+DateTimeValue DateTimeValue_with_name (DateTimeValue self, const char *name);
+
+DateTimeValue DateTimeValue_add_seconds (DateTimeValue self, long seconds);
+DateTimeValue DateTimeValue_add_days (DateTimeValue self, int days, 
+     const char *tz, BOOL utc);
+long DateTimeValue_seconds_difference (DateTimeValue start, 
+     DateTimeValue end);
+
+DateTimeValue DateTimeValue_get_day_start (DateTimeValue self, 
+     const char *tz);
+DateTimeValue DateTimeValue_get_day_end (DateTimeValue self, 
+     const char *tz);
+DateTimeValue DateTimeValue_get_jan_first (DateTimeValue self, 
+     const char *tz, BOOL utc);
+
+double DateTimeValue_get_julian_date (DateTimeValue self);
+double DateTimeValue_get_modified_julian_date (DateTimeValue self);
+int DateTimeValue_get_day_of_year (DateTimeValue self);
+void DateTimeValue_get_ymdhms (DateTimeValue self, int *year, int *month, 
+     int *day, int *hour, int *minute, int *seconds, const char *tz, 
+     BOOL utc);
+
+BOOL DateTimeValue_is_same_day (DateTimeValue self, DateTimeValue other);
+BOOL DateTimeValue_is_same_day_of_year (DateTimeValue self, 
+     DateTimeValue other);
+
+int DateTimeValue_format_time (DateTimeValue self, 
+     DateTimeFormatter *formatter, char *buf);
+int DateTimeValue_format_date (DateTimeValue self, 
+     DateTimeFormatter *formatter, char *buf);
+
@@ -1,17 +1,23 @@
-main.o: main.c defs.h city.h cityinfo.h pointerlist.h error.h datetime.h latlong.h suntimes.h holidays.h astrodays.h solunar.h
-pointerlist.o: pointerlist.c pointerlist.h defs.h
-city.o: city.c city.h defs.h cityinfo.h
-latlong.o: latlong.c latlong.h error.h defs.h
-error.o: error.c defs.h
-datetime.o: datetime.c latlong.c datetime.h error.h defs.h
-suntimes.o: suntimes.c suntimes.h datetime.h latlong.h defs.h trigutil.h roundutil.h timeutil.h
-moontimes.o: moontimes.c moontimes.h datetime.h latlong.h defs.h trigutil.h roundutil.h timeutil.h
-timeutil.o: timeutil.c timeutil.h
+main.o: main.c defs.h arena.h city.h pointerarray.h error.h datetime.h latlong.h suntimes.h moontimes.h riseset.h holidays.h astrodays.h solunar.h context.h ephemeris.h observer.h zoneinfo.h timeutil.h nameddays.h
+pointerarray.o: pointerarray.c pointerarray.h defs.h
+city.o: city.c city.h defs.h cityinfo.h pointerarray.h arena.h
+latlong.o: latlong.c latlong.h error.h defs.h arena.h
+error.o: error.c defs.h error.h arena.h
+datetime.o: datetime.c latlong.c datetime.h error.h defs.h timeutil.h zoneinfo.h arena.h
+suntimes.o: suntimes.c suntimes.h datetime.h latlong.h defs.h trigutil.h roundutil.h timeutil.h ephemeris.h riseset.h observer.h zoneinfo.h arena.h
+moontimes.o: moontimes.c moontimes.h datetime.h latlong.h defs.h trigutil.h roundutil.h timeutil.h mathutil.h ephemeris.h riseset.h observer.h zoneinfo.h arena.h
+timeutil.o: timeutil.c timeutil.h defs.h roundutil.h zoneinfo.h
 roundutil.o: roundutil.c roundutil.h
 trigutil.o: trigutil.c trigutil.h
 mathutil.o: mathutil.c mathutil.h
-holidays.o: defs.h holidays.h datetime.h holidays.c
-astrodays.o: defs.h astrodays.h datetime.h astrodays.c
-nameddays.o: defs.h nameddays.c astrodays.h holidays.h datetime.h datetime.h 
-solunar.o: solunar.h solunar.c 
+holidays.o: defs.h holidays.h datetime.h holidays.c zoneinfo.h pointerarray.h arena.h
+astrodays.o: defs.h astrodays.h datetime.h astrodays.c zoneinfo.h pointerarray.h arena.h
+nameddays.o: defs.h nameddays.c nameddays.h astrodays.h holidays.h datetime.h zoneinfo.h timeutil.h pointerarray.h arena.h
+solunar.o: solunar.h solunar.c defs.h datetime.h latlong.h suntimes.h moontimes.h ephemeris.h riseset.h observer.h timeutil.h zoneinfo.h arena.h
 
+zoneinfo.o: zoneinfo.c zoneinfo.h defs.h timeutil.h
+context.o: context.c context.h defs.h datetime.h latlong.h ephemeris.h observer.h moontimes.h riseset.h zoneinfo.h arena.h
+ephemeris.o: ephemeris.c ephemeris.h defs.h error.h suntimes.h moontimes.h timeutil.h trigutil.h observer.h arena.h
+riseset.o: riseset.c riseset.h defs.h datetime.h latlong.h ephemeris.h timeutil.h trigutil.h mathutil.h observer.h zoneinfo.h arena.h
+observer.o: observer.c observer.h latlong.h trigutil.h arena.h
+arena.o: arena.c arena.h defs.h
@@ -0,0 +1,507 @@
+/*=======================================================================
+solunar
+ephemeris.c
+Definition of the EphemerisCache object
+The positions of the sun and moon change smoothly, so over a short
+span of time they can be represented very closely by a Chebyshev
+series. The cache fits such a series to the RA and declination of
+each body over each half-day that is asked for, using the full
+series in suntimes.c and moontimes.c, and then answers requests for
+times in that half-day by summing the Chebyshev series, which is
+several times quicker. The fits are of degree 10, which keeps the 
+RA within 1e-9 hours, and the declination within 1e-8 degrees, of 
+the direct calculation. A cache is not thread-safe, but it is cheap,
+so each thread can have its own. A NULL cache can be passed to any of
+the functions, which then use the full series directly.
+The same series can be worked out in advance, for a range of years,
+and written to a file by EphemerisFile_build. A cache that has been
+given an EphemerisFile takes the series for the segments the file
+covers directly from the file, which is mapped into memory rather 
+than read, so that it is paged in only as needed, and so that any 
+number of threads and processes can share one copy of it 
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ephemeris.h"
+#include "suntimes.h"
+#include "moontimes.h"
+#include "timeutil.h"
+#include "trigutil.h"
+
+// Length of a fitted segment, in days
+#define EPHEMERIS_SEGMENT 0.5
+// Degree of the fitted series
+#define EPHEMERIS_DEGREE 10
+// Number of segments kept for each body. Must be a power of two
+#define EPHEMERIS_SLOTS 128
+
+#define EPHEMERIS_MOON 0
+#define EPHEMERIS_SUN 1
+// The bodies up to here are stored in ephemeris files. The moon's 
+//  other precision tiers are only ever fitted in the cache
+#define EPHEMERIS_FILE_BODIES 2
+#define EPHEMERIS_MOON_FAST 2
+#define EPHEMERIS_MOON_HIGH 3
+#define EPHEMERIS_BODIES 4
+
+// Number of coefficients stored for each body in each segment: the
+//  series for RA, followed by the series for declination
+#define EPHEMERIS_COEFFS (2 * (EPHEMERIS_DEGREE + 1))
+
+#define EPHEMERIS_FILE_MAGIC "SOLUNEPH"
+#define EPHEMERIS_FILE_VERSION 1
+// Stored as a native integer, so a file written on a machine with 
+//  the other byte order can be recognized 
+#define EPHEMERIS_FILE_BYTE_ORDER 0x01020304
+
+typedef void (*EphemerisFunc) (double mjd, double *ra, double *dec);
+
+static const EphemerisFunc ephemeris_funcs [EPHEMERIS_BODIES] = 
+  {
+  MoonTimes_get_lunar_ephemeris,
+  suntimes_getSolarRAandDec,
+  MoonTimes_get_lunar_ephemeris_fast,
+  MoonTimes_get_lunar_ephemeris_high
+  };
+
+typedef struct _EphemerisSegment
+  {
+  int64_t index; // Start of the segment in units of EPHEMERIS_SEGMENT
+  BOOL valid;
+  double coeffs [EPHEMERIS_COEFFS];
+  } EphemerisSegment;
+
+/* An ephemeris file is this header followed, for each segment in turn,
+   by EPHEMERIS_COEFFS doubles for each body in turn. Everything is 
+   in the native format of the machine that wrote it */
+typedef struct _EphemerisFileHeader
+  {
+  char magic [8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t degree;
+  uint32_t bodies;
+  double segment;
+  int64_t first_index;
+  int64_t nsegments;
+  } EphemerisFileHeader;
+
+typedef struct _EphemerisFilePriv
+  {
+  void *map;
+  size_t size;
+  int64_t first_index;
+  int64_t nsegments;
+  const double *coeffs;
+  } EphemerisFilePriv;
+
+typedef struct _EphemerisCachePriv
+  {
+  const EphemerisFile *file;
+  EphemerisSegment segments [EPHEMERIS_BODIES][EPHEMERIS_SLOTS];
+  } EphemerisCachePriv;
+
+
+/*=======================================================================
+EphemerisCache_new
+Create a cache, which will take its series from 'file' where it can.
+file may be NULL; if not, it must stay open as long as the cache is in
+use
+=======================================================================*/
+EphemerisCache *EphemerisCache_new (const EphemerisFile *file)
+  {
+  EphemerisCache *self = malloc (sizeof (EphemerisCache));
+  self->priv = calloc (1, sizeof (EphemerisCachePriv));
+  self->priv->file = file;
+  return self;
+  }
+
+
+/*=======================================================================
+EphemerisCache_get_file
+=======================================================================*/
+const EphemerisFile *EphemerisCache_get_file (const EphemerisCache *self)
+  {
+  if (!self) return NULL;
+  return self->priv->file;
+  }
+
+
+/*=======================================================================
+EphemerisCache_free
+=======================================================================*/
+void EphemerisCache_free (EphemerisCache *self)
+  {
+  if (!self) return;
+  free (self->priv);
+  free (self);
+  }
+
+
+/*=======================================================================
+ephemeris_fit
+Fit Chebyshev series to the RA and declination given by func over
+one segment, by sampling at the Chebyshev nodes, and write their
+coefficients to 'coeffs'. The RA is unwrapped so that it doesn't 
+jump by 24 hours within the segment
+=======================================================================*/
+static void ephemeris_fit (double *coeffs, int64_t index, 
+    EphemerisFunc func)
+  {
+  const int n = EPHEMERIS_DEGREE + 1;
+  double ra[EPHEMERIS_DEGREE + 1], dec[EPHEMERIS_DEGREE + 1];
+  double start = index * EPHEMERIS_SEGMENT;
+  int j, k;
+  for (j = 0; j < n; j++)
+    {
+    double x = cos (M_PI * (j + 0.5) / n);
+    func (start + (x + 1.0) * 0.5 * EPHEMERIS_SEGMENT, &ra[j], &dec[j]);
+    if (j > 0)
+      {
+      if (ra[j] < ra[j - 1] - 12.0) ra[j] += 24.0;
+      if (ra[j] > ra[j - 1] + 12.0) ra[j] -= 24.0;
+      }
+    }
+  for (k = 0; k < n; k++)
+    {
+    double sra = 0, sdec = 0;
+    for (j = 0; j < n; j++)
+      {
+      double c = cos (M_PI * k * (j + 0.5) / n);
+      sra += ra[j] * c;
+      sdec += dec[j] * c;
+      }
+    coeffs[k] = 2.0 * sra / n;
+    coeffs[n + k] = 2.0 * sdec / n;
+    }
+  // With this halving, the series is just c[0] + sum c[k] * T[k](x)
+  coeffs[0] *= 0.5;
+  coeffs[n] *= 0.5;
+  }
+
+
+/*=======================================================================
+ephemeris_clenshaw
+Sum a Chebyshev series at x, which is in the range -1 to 1
+=======================================================================*/
+static double ephemeris_clenshaw (const double *c, double x)
+  {
+  double b1 = 0, b2 = 0;
+  int k;
+  for (k = EPHEMERIS_DEGREE; k >= 1; k--)
+    {
+    double b = 2.0 * x * b1 - b2 + c[k];
+    b2 = b1;
+    b1 = b;
+    }
+  return c[0] + x * b1 - b2;
+  }
+
+
+/*=======================================================================
+ephemeris_get
+Find the series for the segment containing mjd, from the file if it
+covers that segment, or else from the cache, fitting it if it isn't 
+there, and evaluate it
+=======================================================================*/
+static void ephemeris_get (EphemerisCache *self, int body, double mjd, 
+    double *ra, double *dec)
+  {
+  double s = mjd / EPHEMERIS_SEGMENT;
+  int64_t index = (int64_t) floor (s);
+  const double *coeffs;
+  const EphemerisFilePriv *file = self->priv->file 
+    ? self->priv->file->priv : NULL;
+  if (file && body < EPHEMERIS_FILE_BODIES && index >= file->first_index 
+      && index < file->first_index + file->nsegments)
+    {
+    coeffs = file->coeffs + ((index - file->first_index) 
+      * EPHEMERIS_FILE_BODIES + body) * EPHEMERIS_COEFFS;
+    }
+  else
+    {
+    EphemerisSegment *seg = 
+      &self->priv->segments[body][index & (EPHEMERIS_SLOTS - 1)];
+    if (!seg->valid || seg->index != index)
+      {
+      ephemeris_fit (seg->coeffs, index, ephemeris_funcs[body]);
+      seg->index = index;
+      seg->valid = TRUE;
+      }
+    coeffs = seg->coeffs;
+    }
+
+  double x = 2.0 * (s - index) - 1.0;
+  double r = ephemeris_clenshaw (coeffs, x);
+  r = fmod (r, 24.0);
+  if (r < 0) r += 24.0;
+  *ra = r;
+  *dec = ephemeris_clenshaw (coeffs + EPHEMERIS_DEGREE + 1, x);
+  }
+
+
+/*=======================================================================
+EphemerisCache_get_moon
+Get the moon's RA (hours) and declination (degrees) at the specified
+MJD, as MoonTimes_get_lunar_ephemeris
+=======================================================================*/
+void EphemerisCache_get_moon (EphemerisCache *self, double mjd,
+    double *ra, double *dec)
+  {
+  if (self)
+    ephemeris_get (self, EPHEMERIS_MOON, mjd, ra, dec);
+  else
+    MoonTimes_get_lunar_ephemeris (mjd, ra, dec);
+  }
+
+
+/*=======================================================================
+EphemerisCache_get_moon_fast
+As EphemerisCache_get_moon, but from the fast tier of the moon's 
+series, MoonTimes_get_lunar_ephemeris_fast. An ephemeris file holds 
+only the standard tier, so this always fits the series itself
+=======================================================================*/
+void EphemerisCache_get_moon_fast (EphemerisCache *self, double mjd,
+    double *ra, double *dec)
+  {
+  if (self)
+    ephemeris_get (self, EPHEMERIS_MOON_FAST, mjd, ra, dec);
+  else
+    MoonTimes_get_lunar_ephemeris_fast (mjd, ra, dec);
+  }
+
+
+/*=======================================================================
+EphemerisCache_get_moon_high
+As EphemerisCache_get_moon_fast, but from the high tier, 
+MoonTimes_get_lunar_ephemeris_high
+=======================================================================*/
+void EphemerisCache_get_moon_high (EphemerisCache *self, double mjd,
+    double *ra, double *dec)
+  {
+  if (self)
+    ephemeris_get (self, EPHEMERIS_MOON_HIGH, mjd, ra, dec);
+  else
+    MoonTimes_get_lunar_ephemeris_high (mjd, ra, dec);
+  }
+
+
+/*=======================================================================
+EphemerisCache_get_sun
+Get the sun's RA (hours) and declination (degrees) at the specified
+MJD, as suntimes_getSolarRAandDec
+=======================================================================*/
+void EphemerisCache_get_sun (EphemerisCache *self, double mjd,
+    double *ra, double *dec)
+  {
+  if (self)
+    ephemeris_get (self, EPHEMERIS_SUN, mjd, ra, dec);
+  else
+    suntimes_getSolarRAandDec (mjd, ra, dec);
+  }
+
+
+/*=======================================================================
+ephemeris_sin_altitude
+=======================================================================*/
+static double ephemeris_sin_altitude (const Observer *observer,
+    double mjd, double ra, double dec)
+  {
+  double TAU = 15.0 * (timeutil_lmst_hours (mjd, observer->longitude_hours) 
+    - ra);
+  double sinDec, cosDec;
+  sincosDeg (dec, &sinDec, &cosDec);
+  return observer->sin_latitude * sinDec
+    + observer->cos_latitude * cosDec * cosDeg (TAU);
+  }
+
+
+/*=======================================================================
+EphemerisCache_get_moon_sin_altitude
+As MoonTimes_getSinAltitude, but using the cache
+=======================================================================*/
+double EphemerisCache_get_moon_sin_altitude (EphemerisCache *self,
+    const Observer *observer, double mjd)
+  {
+  double ra, dec;
+  EphemerisCache_get_moon (self, mjd, &ra, &dec);
+  return ephemeris_sin_altitude (observer, mjd, ra, dec);
+  }
+
+
+/*=======================================================================
+EphemerisCache_get_sun_sin_altitude
+As suntimes_getSinAltitude, but using the cache
+=======================================================================*/
+double EphemerisCache_get_sun_sin_altitude (EphemerisCache *self,
+    const Observer *observer, double mjd)
+  {
+  double ra, dec;
+  EphemerisCache_get_sun (self, mjd, &ra, &dec);
+  return ephemeris_sin_altitude (observer, mjd, ra, dec);
+  }
+
+
+/*=======================================================================
+ephemeris_year_to_index
+The number of the segment that starts at midnight UTC on January 1st
+of the specified year
+=======================================================================*/
+static int64_t ephemeris_year_to_index (int year)
+  {
+  double mjd = timeutil_JD_to_MJD (timeutil_ymdhms_to_JD (year, 1, 1, 
+    0, 0, 0));
+  return (int64_t) floor (mjd / EPHEMERIS_SEGMENT + 0.5);
+  }
+
+
+/*=======================================================================
+EphemerisFile_build
+Work out the series for every segment from the start of first_year 
+to the end of last_year, and write them to the specified file. 
+Returns FALSE, and sets *e, if the file can't be written
+=======================================================================*/
+BOOL EphemerisFile_build (const char *filename, int first_year, 
+    int last_year, Error **e)
+  {
+  if (last_year < first_year)
+    {
+    *e = Error_new ("Last year of ephemeris is before first year");
+    return FALSE;
+    }
+
+  EphemerisFileHeader header;
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, EPHEMERIS_FILE_MAGIC, sizeof (header.magic));
+  header.version = EPHEMERIS_FILE_VERSION;
+  header.byte_order = EPHEMERIS_FILE_BYTE_ORDER;
+  header.degree = EPHEMERIS_DEGREE;
+  header.bodies = EPHEMERIS_FILE_BODIES;
+  header.segment = EPHEMERIS_SEGMENT;
+  header.first_index = ephemeris_year_to_index (first_year);
+  header.nsegments = ephemeris_year_to_index (last_year + 1) 
+    - header.first_index;
+
+  FILE *f = fopen (filename, "wb");
+  if (!f)
+    {
+    char s[512];
+    snprintf (s, sizeof (s), "Can't open %s for writing: %s", filename,
+      strerror (errno));
+    *e = Error_new (s);
+    return FALSE;
+    }
+
+  BOOL ok = fwrite (&header, sizeof (header), 1, f) == 1;
+  int64_t i;
+  for (i = 0; i < header.nsegments && ok; i++)
+    {
+    double coeffs [EPHEMERIS_FILE_BODIES * EPHEMERIS_COEFFS];
+    int body;
+    for (body = 0; body < EPHEMERIS_FILE_BODIES; body++)
+      ephemeris_fit (coeffs + body * EPHEMERIS_COEFFS, 
+        header.first_index + i, ephemeris_funcs[body]);
+    ok = fwrite (coeffs, sizeof (coeffs), 1, f) == 1;
+    }
+  if (fclose (f) != 0) ok = FALSE;
+
+  if (!ok)
+    {
+    char s[512];
+    snprintf (s, sizeof (s), "Can't write %s: %s", filename,
+      strerror (errno));
+    *e = Error_new (s);
+    remove (filename);
+    return FALSE;
+    }
+  return TRUE;
+  }
+
+
+/*=======================================================================
+EphemerisFile_open
+Map an ephemeris file written by EphemerisFile_build into memory. 
+Returns NULL, and sets *e, if the file can't be read or was not 
+written by a compatible version of this program on a compatible 
+machine
+=======================================================================*/
+EphemerisFile *EphemerisFile_open (const char *filename, Error **e)
+  {
+  char s[512];
+  int fd = open (filename, O_RDONLY);
+  if (fd < 0)
+    {
+    snprintf (s, sizeof (s), "Can't open %s: %s", filename, 
+      strerror (errno));
+    *e = Error_new (s);
+    return NULL;
+    }
+
+  struct stat sb;
+  void *map = MAP_FAILED;
+  if (fstat (fd, &sb) == 0
+      && sb.st_size >= (off_t) sizeof (EphemerisFileHeader))
+    map = mmap (NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    {
+    snprintf (s, sizeof (s), "Can't read %s", filename); 
+    *e = Error_new (s);
+    return NULL;
+    }
+
+  const EphemerisFileHeader *header = map;
+  const char *problem = NULL;
+  if (memcmp (header->magic, EPHEMERIS_FILE_MAGIC, 
+      sizeof (header->magic)) != 0)
+    problem = "is not an ephemeris file";
+  else if (header->byte_order != EPHEMERIS_FILE_BYTE_ORDER)
+    problem = "was written on a machine with a different byte order";
+  else if (header->version != EPHEMERIS_FILE_VERSION 
+      || header->degree != EPHEMERIS_DEGREE 
+      || header->bodies != EPHEMERIS_FILE_BODIES
+      || header->segment != EPHEMERIS_SEGMENT)
+    problem = "was written by an incompatible version of this program";
+  else if (header->nsegments < 0 || (size_t) sb.st_size 
+      != sizeof (EphemerisFileHeader) + header->nsegments 
+      * EPHEMERIS_FILE_BODIES * EPHEMERIS_COEFFS * sizeof (double))
+    problem = "is truncated or corrupt";
+  if (problem)
+    {
+    snprintf (s, sizeof (s), "%s %s", filename, problem); 
+    *e = Error_new (s);
+    munmap (map, sb.st_size);
+    return NULL;
+    }
+
+  EphemerisFile *self = malloc (sizeof (EphemerisFile));
+  self->priv = malloc (sizeof (EphemerisFilePriv));
+  self->priv->map = map;
+  self->priv->size = sb.st_size;
+  self->priv->first_index = header->first_index;
+  self->priv->nsegments = header->nsegments;
+  self->priv->coeffs = (const double *) (header + 1);
+  return self;
+  }
+
+
+/*=======================================================================
+EphemerisFile_close
+=======================================================================*/
+void EphemerisFile_close (EphemerisFile *self)
+  {
+  if (!self) return;
+  munmap (self->priv->map, self->priv->size);
+  free (self->priv);
+  free (self);
+  }
+
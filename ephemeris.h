@@ -0,0 +1,52 @@
+/*=======================================================================
+solunar
+ephemeris.h
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#pragma once
+
+#include "defs.h"
+#include "error.h"
+#include "observer.h"
+
+typedef struct _EphemerisCache
+  {
+  struct _EphemerisCachePriv *priv;
+  } EphemerisCache;
+
+typedef struct _EphemerisFile
+  {
+  struct _EphemerisFilePriv *priv;
+  } EphemerisFile;
+
+EphemerisCache *EphemerisCache_new (const EphemerisFile *file);
+
+const EphemerisFile *EphemerisCache_get_file (const EphemerisCache *self);
+
+void EphemerisCache_free (EphemerisCache *self);
+
+void EphemerisCache_get_moon (EphemerisCache *self, double mjd,
+    double *ra, double *dec);
+
+void EphemerisCache_get_moon_fast (EphemerisCache *self, double mjd,
+    double *ra, double *dec);
+
+void EphemerisCache_get_moon_high (EphemerisCache *self, double mjd,
+    double *ra, double *dec);
+
+void EphemerisCache_get_sun (EphemerisCache *self, double mjd,
+    double *ra, double *dec);
+
+double EphemerisCache_get_moon_sin_altitude (EphemerisCache *self,
+    const Observer *observer, double mjd);
+
+double EphemerisCache_get_sun_sin_altitude (EphemerisCache *self,
+    const Observer *observer, double mjd);
+
+BOOL EphemerisFile_build (const char *filename, int first_year,
+    int last_year, Error **e);
+
+EphemerisFile *EphemerisFile_open (const char *filename, Error **e);
+
+void EphemerisFile_close (EphemerisFile *self);
+
@@ -8,24 +8,29 @@ Definition of Error object
 #include <stdlib.h>
 #include <string.h>
 #include "error.h"
+#include "arena.h"
 
 typedef struct _ErrorPriv
   {
   char *str;
+  Arena *arena; // The arena the object came from, or NULL
   } ErrorPriv;
 
+// An Error, its private part, and its message are allocated together
+typedef struct _ErrorBlock
+  {
+  Error error;
+  ErrorPriv priv;
+  char str[1];
+  } ErrorBlock;
+
 /*=======================================================================
 Error_free
 =======================================================================*/
 void Error_free (Error *self)
   {
   if (!self) return;
-  if (self->priv) 
-    {
-    if (self->priv->str) free (self->priv->str);
-    free (self->priv);
-    }
-  free (self);
+  Arena_free_object (self->priv->arena, self);
   }
 
 /*=======================================================================
@@ -33,9 +38,24 @@ Error_new
 =======================================================================*/
 Error *Error_new (const char *message)
   {
-  Error *self = (Error *) malloc (sizeof (Error));
-  self->priv = (ErrorPriv *) malloc (sizeof (ErrorPriv));
-  self->priv->str = strdup (message);
+  return Error_new_in (NULL, message);
+  }
+
+/*=======================================================================
+Error_new_in
+As Error_new, but allocated from 'arena', or from the heap if arena is
+NULL
+=======================================================================*/
+Error *Error_new_in (Arena *arena, const char *message)
+  {
+  size_t len = strlen (message);
+  ErrorBlock *block = (ErrorBlock *) Arena_alloc_object 
+    (arena, sizeof (ErrorBlock) + len);
+  Error *self = &block->error;
+  self->priv = &block->priv;
+  self->priv->str = block->str;
+  memcpy (block->str, message, len + 1);
+  self->priv->arena = arena;
   return self;
   }
 
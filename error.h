@@ -5,6 +5,8 @@ error.h
 =======================================================================*/
 #pragma once
 
+#include "arena.h"
+
 typedef struct _Error
   {
   struct _ErrorPriv *priv;
@@ -12,5 +14,6 @@ typedef struct _Error
 
 void Error_free (Error *self);
 Error *Error_new (const char *message);
+Error *Error_new_in (Arena *arena, const char *message);
 const char *Error_get_message (Error *self);
 
@@ -11,7 +11,7 @@ Mainly western at present.
 #include "defs.h"
 #include "datetime.h"
 #include "holidays.h"
-#include "pointerlist.h"
+#include "pointerarray.h"
 
 
 /*=======================================================================
@@ -72,30 +72,30 @@ DateTime *Holidays_get_easter_sunday (int year, const char *tz, BOOL utc)
 /*=======================================================================
 Holidays_get_list_for_year
 =======================================================================*/
-PointerList *Holidays_get_list_for_year (PointerList *in, int year, 
+PointerArray *Holidays_get_list_for_year (PointerArray *in, int year, 
      const char *tz, BOOL utc)
   {
-  PointerList *l = in;
+  PointerArray *l = in;
   DateTime *easter_sunday = Holidays_get_easter_sunday (year, tz, utc);
-  l = PointerList_append (l, easter_sunday);
+  PointerArray_append (l, easter_sunday);
 
   DateTime *easter_monday = DateTime_clone_offset_days (easter_sunday, 1, 
    "Easter Monday", tz, utc); 
-  l = PointerList_append (l, easter_monday);
+  PointerArray_append (l, easter_monday);
 
-  l = PointerList_append (l, DateTime_clone_offset_days (easter_sunday, -47, 
+  PointerArray_append (l, DateTime_clone_offset_days (easter_sunday, -47, 
    "Shrove Tuesday", tz, utc));
-  l = PointerList_append (l, DateTime_clone_offset_days (easter_sunday, -2, 
+  PointerArray_append (l, DateTime_clone_offset_days (easter_sunday, -2, 
    "Good Friday", tz, utc));
-  l = PointerList_append (l, DateTime_clone_offset_days (easter_sunday, -3, 
+  PointerArray_append (l, DateTime_clone_offset_days (easter_sunday, -3, 
    "Maundy Thursday", tz, utc));
-  l = PointerList_append (l, DateTime_clone_offset_days (easter_sunday, -7, 
+  PointerArray_append (l, DateTime_clone_offset_days (easter_sunday, -7, 
    "Palm Sunday", tz, utc));
-  l = PointerList_append (l, DateTime_clone_offset_days (easter_sunday, -46, 
+  PointerArray_append (l, DateTime_clone_offset_days (easter_sunday, -46, 
    "Ash Wednesday", tz, utc));
-  l = PointerList_append (l, DateTime_clone_offset_days (easter_sunday, 49, 
+  PointerArray_append (l, DateTime_clone_offset_days (easter_sunday, 49, 
    "Whitsun/Pentecost", tz, utc));
-  l = PointerList_append (l, DateTime_clone_offset_days (easter_sunday, -21, 
+  PointerArray_append (l, DateTime_clone_offset_days (easter_sunday, -21, 
    "Mothering Sunday", tz, utc));
 
   return l;
@@ -7,9 +7,9 @@ holidays.h
 
 #include "defs.h"
 #include "datetime.h"
-#include "pointerlist.h"
+#include "pointerarray.h"
 
 DateTime *Holidays_get_easter_sunday (int year, const char *tz, BOOL utc);
-PointerList *Holidays_get_list_for_year (PointerList *l, int year, 
+PointerArray *Holidays_get_list_for_year (PointerArray *l, int year, 
      const char *tz, BOOL utc);
 
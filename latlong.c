@@ -8,18 +8,38 @@ Definition of the LatLong object
 #include <stdlib.h>
 #include <string.h>
 #include "latlong.h"
+#include "arena.h"
 
 
 typedef struct _LatLongPriv
   {
   double lat, longt;
+  Arena *arena; // The arena the object came from, or NULL
   } LatLongPriv;
 
+// A LatLong and its private part are allocated together
+typedef struct _LatLongBlock
+  {
+  LatLong latlong;
+  LatLongPriv priv;
+  } LatLongBlock;
+
 
 /*=======================================================================
 LatLong_new_parse
 =======================================================================*/
 LatLong *LatLong_new_parse (const char *s, Error **e)
+  {
+  return LatLong_new_parse_in (NULL, s, e);
+  }
+
+
+/*=======================================================================
+LatLong_new_parse_in
+As LatLong_new_parse, but the result, or the error, is allocated from
+'arena', or from the heap if arena is NULL
+=======================================================================*/
+LatLong *LatLong_new_parse_in (Arena *arena, const char *s, Error **e)
   {
   double lat, longt;
   int lat_deg, lat_min, long_deg, long_min;
@@ -27,17 +47,17 @@ LatLong *LatLong_new_parse (const char *s, Error **e)
   if (sscanf (s, "%c%2d%2d%c%3d%2d", &lat_sign, &lat_deg, 
       &lat_min, &long_sign, &long_deg, &long_min) == 6)
     {
-    LatLong *l = LatLong_new_deg_min (lat_deg, lat_min, 
+    LatLong *l = LatLong_new_deg_min_in (arena, lat_deg, lat_min, 
       lat_sign == '-' ? TRUE : FALSE,
       long_deg, long_min, long_sign == '-' ? TRUE : FALSE);
     return l;
     }
   if (sscanf (s, "%lf,%lf", &lat, &longt) == 2)
     {
-    LatLong *l = LatLong_new (lat,longt);
+    LatLong *l = LatLong_new_in (arena, lat, longt);
     return l;
     }
-  *e = Error_new ("Can't parse latitude/longitude string"); 
+  *e = Error_new_in (arena, "Can't parse latitude/longitude string"); 
   return NULL;
   }
 
@@ -48,10 +68,24 @@ East and North are +ve, West and South are -ve
 =======================================================================*/
 LatLong *LatLong_new (double lat, double longt)
   {
-  LatLong *self = (LatLong *) malloc (sizeof (LatLong));
-  self->priv = (LatLongPriv *) malloc (sizeof (LatLongPriv));
+  return LatLong_new_in (NULL, lat, longt);
+  }
+
+
+/*=======================================================================
+LatLong_new_in
+As LatLong_new, but allocated from 'arena', or from the heap if arena
+is NULL
+=======================================================================*/
+LatLong *LatLong_new_in (Arena *arena, double lat, double longt)
+  {
+  LatLongBlock *block = (LatLongBlock *) Arena_alloc_object 
+    (arena, sizeof (LatLongBlock));
+  LatLong *self = &block->latlong;
+  self->priv = &block->priv;
   self->priv->lat = lat;
   self->priv->longt = longt;
+  self->priv->arena = arena;
   return self;
   }
 
@@ -62,11 +96,24 @@ LatLong_new_deg_min
 LatLong *LatLong_new_deg_min (int lat_deg, int lat_min, BOOL lat_south, 
     int long_deg, int long_min, BOOL long_south)
   {
+  return LatLong_new_deg_min_in (NULL, lat_deg, lat_min, lat_south,
+    long_deg, long_min, long_south);
+  }
+
+
+/*=======================================================================
+LatLong_new_deg_min_in
+As LatLong_new_deg_min, but allocated from 'arena', or from the heap if
+arena is NULL
+=======================================================================*/
+LatLong *LatLong_new_deg_min_in (Arena *arena, int lat_deg, int lat_min, 
+    BOOL lat_south, int long_deg, int long_min, BOOL long_south)
+  {
   double longt = long_deg + long_min / 60.0;
   double lat = lat_deg + lat_min / 60.0;
   if (lat_south) lat = - lat;
   if (long_south) longt = - longt;
-  return LatLong_new (lat, longt);
+  return LatLong_new_in (arena, lat, longt);
   }
 
 
@@ -76,8 +123,7 @@ LatLong_free
 void LatLong_free (LatLong *self)
   {
   if (!self) return;
-  if (self->priv) free (self->priv);
-  free (self);
+  Arena_free_object (self->priv->arena, self);
   }
 
 
@@ -7,6 +7,7 @@ latlong.h
 
 #include "defs.h"
 #include "error.h"
+#include "arena.h"
 
 typedef struct _LatLong
   {
@@ -19,6 +20,11 @@ LatLong *LatLong_new_parse (const char *str, Error **error);
 LatLong *LatLong_new (double lat, double longt);
 LatLong *LatLong_new_deg_min (int lat_deg, int lat_min, BOOL lat_south, 
     int long_deg, int long_min, BOOL long_south);
+LatLong *LatLong_new_parse_in (Arena *arena, const char *str, 
+    Error **error);
+LatLong *LatLong_new_in (Arena *arena, double lat, double longt);
+LatLong *LatLong_new_deg_min_in (Arena *arena, int lat_deg, int lat_min,
+    BOOL lat_south, int long_deg, int long_min, BOOL long_south);
 LatLong *LatLong_clone (const LatLong *other);
 char *LatLong_to_string (const LatLong *self);
 double LatLong_get_latitude (const LatLong *self);
@@ -7,11 +7,13 @@ Copyright (c)2005-2019 Kevin Boone
 #include <getopt.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "defs.h"
 #include "city.h"
-#include "cityinfo.h"
 #include "latlong.h"
-#include "pointerlist.h"
+#include "pointerarray.h"
 #include "error.h"
 #include "datetime.h"
 #include "suntimes.h"
@@ -20,6 +22,28 @@ Copyright (c)2005-2019 Kevin Boone
 #include "astrodays.h"
 #include "nameddays.h"
 #include "solunar.h"
+#include "context.h"
+#include "timeutil.h"
+#include "arena.h"
+
+
+/*=======================================================================
+print_alloc_stats
+Report, on stderr, how the objects the program created were allocated.
+Registered with atexit() by --alloc-stats, so that it runs however
+the program ends
+=======================================================================*/
+void print_alloc_stats (void)
+  {
+  ArenaStats stats;
+  Arena_get_stats (&stats);
+  fprintf (stderr, "Heap allocations:  %lu (%lu freed)\n", 
+    stats.heap_allocs, stats.heap_frees);
+  fprintf (stderr, "Arena allocations: %lu\n", stats.arena_allocs);
+  fprintf (stderr, "Arena blocks:      %lu\n", stats.arena_blocks);
+  fprintf (stderr, "Arena resets:      %lu\n", stats.arena_resets);
+  fprintf (stderr, "Interned strings:  %lu\n", stats.interned);
+  }
 
 
 /*=======================================================================
@@ -50,16 +74,25 @@ print_long_usage
 void print_long_usage(const char *argv0)
   {
   printf ("Usage: %s [options]\n", argv0);
+  printf ("  --alloc-stats                  report object allocations on exit\n");
+  printf ("  --all-cities                   one line per day for every city\n");
+  printf ("  --batch                        read queries from stdin, one per line\n");
+  printf ("  --build-ephemeris [YYYY-YYYY] [file]\n");
+  printf ("                                 write ephemeris file for years\n");
   printf ("  -c, --city [name]              specify city\n");
   printf ("  --cities                       print list of cities\n");
+  printf ("  --cities-file [file]           like --all-cities, for cities in file\n");
   printf ("  -d, --datetime [date_time]     set date and/or time\n");
   printf ("  --days                         list significant days in year\n");
+  printf ("  --ephemeris [file]             use ephemeris file\n");
   printf ("  --datetime help                show date/time format\n");
   printf ("  -f, --full                     print full data\n");
   printf ("  -h                             print brief help message\n");
   printf ("  -l, --latlong [+DDMM+DDDMM]    latitude/longitude\n");
   printf ("  --latlong help                 show lat/long format\n");
   printf ("  --longhelp                     print long help message\n");
+  printf ("  --ndays [n]                    days covered by --all-cities\n");
+  printf ("  --precision [tier]             moon series: fast, standard, high\n");
   printf ("  -q, --quiet                    no captions or interim results\n");
   printf ("  -s, --solunar                  show solunar scores\n");
   printf ("  -t, --twelvehour               use AM/PM times\n");
@@ -87,6 +120,15 @@ void print_datetime_help()
 "month_name DD YYYY\n"
 "month_name DD\n"
 "DDD#YYYY            (day of year, 1-366; for use in scripts)\n"
+"YYYY-MM-DD          (ISO-8601)\n"
+"YYYY-DDD            (ISO-8601 day of year)\n"
+"\n"
+"A one- or two-digit year is taken to be in the 2000s.\n"
+"\n"
+"An ISO-8601 date may be followed by T and a time, as HH:MM or HH:MM:SS,\n"
+"then optionally Z or an offset from UTC such as +01:00 or -0500. A time\n"
+"with Z or an offset is taken to be in that offset, not the local zone;\n"
+"for example, 2026-10-17T05:30Z.\n"
 "\n"
 "Date and time  are assumed  to be local to the  selected city, or  to  the \n"
 "system locale  if no  city is specified,  including daylight savings where\n"
@@ -120,16 +162,14 @@ void print_latlong_help()
 
 
 /*=======================================================================
-print_sunrise_time
+sun_event_to_string
+Format the result of one of the SunTimes functions, or its error 
+message if there was no such event. Caller must free the result
 =======================================================================*/
-void print_sunrise_time (char *text, double zenith, BOOL opt_utc, 
-   const char *tz, const LatLong *latlong, const DateTime *date, 
-   BOOL twelve_hour, BOOL opt_syslocal)
+char *sun_event_to_string (const SolunarContext *ctx, DateTime *event, 
+    Error *e)
   {
   char *s;
-  Error *e = NULL;
-  DateTime *sunrise = SunTimes_get_sunrise (latlong, date, 
-      zenith, tz, &e);
   if (e)
     {
     s = strdup (Error_get_message (e));
@@ -137,15 +177,24 @@ void print_sunrise_time (char *text, double zenith, BOOL opt_utc,
     }
   else
     {
-    if (opt_syslocal)
-      s = DateTime_time_to_string_syslocal (sunrise, twelve_hour);
-    else if (opt_utc)
-      s = DateTime_time_to_string_UTC (sunrise, twelve_hour);
-    else
-      s = DateTime_time_to_string_local (sunrise, tz, twelve_hour);
-    DateTime_free (sunrise);
+    s = SolunarContext_time_to_string (ctx, event);
+    DateTime_free (event);
     }
-  printf ("%s%s\n", text, s);
+  return s;
+  }
+
+
+/*=======================================================================
+print_sunrise_time
+=======================================================================*/
+void print_sunrise_time (FILE *out, char *text, double zenith, 
+    const SolunarContext *ctx)
+  {
+  Error *e = NULL;
+  DateTime *sunrise = SunTimes_get_sunrise (&ctx->observer, ctx->datetime, 
+      zenith, &e);
+  char *s = sun_event_to_string (ctx, sunrise, e);
+  fprintf (out, "%s%s\n", text, s);
   free (s);
   }
 
@@ -153,30 +202,14 @@ void print_sunrise_time (char *text, double zenith, BOOL opt_utc,
 /*=======================================================================
 print_sunset_time
 =======================================================================*/
-void print_sunset_time (char *text, double zenith, BOOL opt_utc, const char *tz,
-    const LatLong *latlong, const DateTime *date, BOOL twelve_hour, 
-    BOOL opt_syslocal)
+void print_sunset_time (FILE *out, char *text, double zenith, 
+    const SolunarContext *ctx)
   {
-  char *s;
   Error *e = NULL;
-  DateTime *sunrise = SunTimes_get_sunset (latlong, date, 
-      zenith, tz, &e);
-  if (e)
-    {
-    s = strdup (Error_get_message (e));
-    Error_free (e);
-    }
-  else
-    {
-    if (opt_syslocal)
-      s = DateTime_time_to_string_syslocal (sunrise, twelve_hour);
-    else if (opt_utc)
-      s = DateTime_time_to_string_UTC (sunrise, twelve_hour);
-    else
-      s = DateTime_time_to_string_local (sunrise, tz, twelve_hour);
-    DateTime_free (sunrise);
-    }
-  printf ("%s%s\n", text, s);
+  DateTime *sunset = SunTimes_get_sunset (&ctx->observer, ctx->datetime, 
+      zenith, &e);
+  char *s = sun_event_to_string (ctx, sunset, e);
+  fprintf (out, "%s%s\n", text, s);
   free (s);
   }
 
@@ -184,37 +217,21 @@ void print_sunset_time (char *text, double zenith, BOOL opt_utc, const char *tz,
 /*=======================================================================
 print_high_noon_time
 =======================================================================*/
-void print_high_noon_time (char *text, BOOL opt_utc, const char *tz,
-    const LatLong *latlong, const DateTime *date, BOOL twelve_hour, 
-    BOOL opt_syslocal)
+void print_high_noon_time (FILE *out, char *text, const SolunarContext *ctx)
   {
-  char *s;
   Error *e = NULL;
-  DateTime *sunrise = SunTimes_get_high_noon (latlong, date, tz, &e);
-  if (e)
-    {
-    s = strdup (Error_get_message (e));
-    Error_free (e);
-    }
-  else
-    {
-    if (opt_syslocal)
-      s = DateTime_time_to_string_syslocal (sunrise, twelve_hour);
-    else if (opt_utc)
-      s = DateTime_time_to_string_UTC (sunrise, twelve_hour);
-    else
-      s = DateTime_time_to_string_local (sunrise, tz, twelve_hour);
-    DateTime_free (sunrise);
-    }
-  printf ("%s%s\n", text, s);
+  DateTime *noon = SunTimes_get_high_noon (&ctx->observer, ctx->datetime, 
+    &e);
+  char *s = sun_event_to_string (ctx, noon, e);
+  fprintf (out, "%s%s\n", text, s);
   free (s);
   }
 
 
 /*=======================================================================
-get_named_days_today
+initialize_day_events
 =======================================================================*/
-PointerList *initialize_day_events (const char *tz, BOOL utc, int year, 
+NamedDays *initialize_day_events (const char *tz, BOOL utc, int year, 
     const LatLong *latlong)
   {
   BOOL southern = FALSE;
@@ -223,103 +240,805 @@ PointerList *initialize_day_events (const char *tz, BOOL utc, int year,
     if (LatLong_get_latitude (latlong) < 0)
       southern = TRUE;
     }
-  return NamedDays_get_list_for_year (year, tz, utc, southern);
+  return NamedDays_new (year, year, tz, utc, southern);
+  }
+
+
+/*=======================================================================
+free_day_events
+=======================================================================*/
+void free_day_events (NamedDays *events)
+  {
+  if (events) NamedDays_free (events);
   }
 
+
 /*=======================================================================
-get_named_days_today
+list_named_days
 =======================================================================*/
-PointerList *get_named_days_today (PointerList *day_events, DateTime *day)
+void list_named_days (const NamedDays *day_events, const DateTime *start, 
+     const char *tz, BOOL utc)
   {
-  PointerList *list = NULL;
-  int i, l = PointerList_get_length (day_events);
-  for (i = 0; i < l; i++)
+  int64_t first = timeutil_floor_div (DateTime_get_utime (start), 
+    SECONDS_PER_DAY);
+  int64_t day;
+  for (day = first; day < first + 365; /* leap year? */ day++)
     {
-    DateTime *event = PointerList_get_pointer (day_events, i);
-    if (DateTime_is_same_day (day, event))
+    DateTime *const *events;
+    int i, l = NamedDays_get_day (day_events, day, &events);
+    for (i = 0; i < l; i++)
       {
-      DateTime *event2 = DateTime_clone (event); 
-      list = PointerList_append (list, event2);
+      DateTime *event = events[i];
+      int j;
+      const char *name = DateTime_get_name (event);
+      char *s = DateTime_date_to_string_syslocal (event);
+      printf ("%s", s);
+      putchar (' ');
+      for (j = strlen (s); j < 26; j++) 
+        putchar (' ');
+      printf ("%s", name);
+      int dummy, hour, min, sec;
+      DateTime_get_ymdhms (event, &dummy, &dummy, &dummy, &hour,
+        &min, &sec, tz, utc);
+      if (hour == 0 && min == 0 && sec == 0)
+        {
+        // All day event
+        }
+      else
+        {
+        printf (" (%02d:%02d)", hour, min);
+        }
+      putchar ('\n');
+      free (s);
       }
+    } 
+  }
+
+
+/*=======================================================================
+print_datetime_caption
+=======================================================================*/
+void print_datetime_caption (FILE *out, const SolunarContext *ctx)
+  {
+  char *s;
+  if (ctx->utc)
+    {
+    s = DateTime_to_string_UTC (ctx->datetime);
+    fprintf (out, "Date/time %s %s\n", s, "UTC");
+    }
+  else if (ctx->syslocal || !ctx->tz)
+    {
+    s = DateTime_to_string_syslocal (ctx->datetime);
+    fprintf (out, "Date/time %s %s\n", s, "syslocal");
     }
-  return list;
+  else
+    {
+    s = DateTime_to_string_local (ctx->datetime, ctx->tz);
+    fprintf (out, "Date/time %s %s\n", s, "local");
+    }
+  free (s);
+  fprintf (out, "\n");
   }
 
+
 /*=======================================================================
-free_day_events
+print_solunar
 =======================================================================*/
-void free_day_events (PointerList *events)
+void print_solunar (FILE *out, SolunarContext *ctx)
   {
-  int i, l = PointerList_get_length (events);
-  for (i = 0; i < l; i++)
+  SolunarDay sd;
+  Solunar_get_day (&ctx->observer, ctx->datetime, ctx->tz, ctx->utc, 
+    &sd);
+
+  fprintf (out, "Solunar\n");
+
+  fprintf (out, "              Moon phase score: %d%%\n", 
+    (int)(sd.phase_score * 100.0));
+
+  fprintf (out, "           Moon distance score: %d%%", 
+    (int)(sd.distance_score * 100.0));
+
+  fprintf (out, "\n");
+
+  if (ctx->full)
+    {
+    fprintf (out, "\n");
+    if (ctx->twelvehour)
+      {
+      fprintf (out, "Time     Sun        Moon       Combined\n");
+      fprintf (out, "====     ===        ====       ========\n");
+      }
+    else
+      {
+      fprintf (out, "Time  Sun        Moon       Combined\n");
+      fprintf (out, "====  ===        ====       ========\n");
+      }
+
+    // The table has always been in the zone's local time, even when
+    //  the rest of the report is not
+    DateTimeFormatter local;
+    DateTimeFormatter_init (&local, ctx->tz, FALSE, FALSE, ctx->twelvehour);
+    char ts[DATETIME_TIME_BUFSIZE];
+    time_t t = sd.start.utime;
+    int i;
+    for (i = 0; i < SOLUNAR_PERIODS; i++)
+      {
+      DateTimeFormatter_time (&local, t + i * 1800, ts);
+      fprintf (out, "%s ", ts);
+      fprintf (out, "%s ", 
+        SolunarContext_get_stars (ctx, sd.sun_score[i]));
+      fprintf (out, "%s ", 
+        SolunarContext_get_stars (ctx, sd.moon_score[i]));
+      fprintf (out, "%s\n", 
+        SolunarContext_get_stars (ctx, sd.combined_score[i]));
+      }
+
+    fprintf (out, "\n");
+    }
+
+  fprintf (out, "     Solunar coincidence score: %d%%\n", 
+    (int)(sd.coincidence_score * 100.0));
+  fprintf (out, "            Solunar peak times:"); 
+  if (sd.num_peaks == 0) fprintf (out, " none\n");
+  else
     {
-    DateTime_free ((DateTime *) PointerList_get_pointer (events, i));
+    DateTimeFormatter formatter;
+    SolunarContext_init_formatter (ctx, &formatter);
+    char s[DATETIME_TIME_BUFSIZE];
+    int i;
+    for (i = 0; i < sd.num_peaks; i++)
+      {
+      DateTimeValue_format_time (sd.peaks[i], &formatter, s);
+      fprintf (out, " %s", s);
+      }
+    fprintf (out, "\n");
     }
-  PointerList_free (events, FALSE);
+
+  fprintf (out, "         Overall solunar score: %d%%\n", 
+    (int)(sd.overall_score * 100.0));
   }
 
 
 /*=======================================================================
-list_named_days
+run_query
+Print the full report for one location and date. day_events is the 
+list of named days for the year, which may be NULL. Returns zero 
+on success, or -1 after printing a message to stderr if the query
+lacks something the report needs
 =======================================================================*/
-void list_named_days (PointerList *day_events, const DateTime *start, 
-     const char *tz, BOOL utc)
+int run_query (FILE *out, SolunarContext *ctx, const NamedDays *day_events)
   {
-  DateTime *d = DateTime_clone (start);
-  int i;
-  for (i = 0; i < 365; /* leap year? */ i++)
+  BOOL show_sunrise_sunset = TRUE;
+  BOOL show_moon_state = TRUE;
+  BOOL show_moon_rise_set = TRUE;
+  BOOL show_today = TRUE;
+
+  if (!ctx->datetime)
     {
-    int i, l = PointerList_get_length (day_events);
-    for (i = 0; i < l; i++)
+    fprintf (stderr, 
+      "Can't calculate astronomical dates because "
+      "no calendar date/time has been specified.\n");
+    return -1;
+    }
+
+  DateTime *start = DateTime_get_day_start (ctx->datetime, ctx->tz);
+
+  if (show_today)
+    {
+    fprintf (out, "Today\n");
+    char *s = SolunarContext_date_to_string (ctx, start);
+    fprintf (out, "                          Date: %s\n", s);
+    free (s);
+
+    DateTime *const *events = NULL;
+    int i, l = day_events 
+      ? NamedDays_get_events_on (day_events, ctx->datetime, &events) : 0;
+    if (l > 0)
       {
-      DateTime *event = PointerList_get_pointer (day_events, i);
-      if (DateTime_is_same_day_of_year (d, event))
+      fprintf (out, "                      Today is: ");
+      for (i = 0; i < l; i++)
         {
-        int j;
+        DateTime *event = events[i];
         const char *name = DateTime_get_name (event);
-        char *s = DateTime_date_to_string_syslocal (event);
-        printf ("%s", s);
-        putchar (' ');
-        for (j = strlen (s); j < 26; j++) 
-          putchar (' ');
-        printf ("%s", name);
-        int dummy, hour, min, sec;
-        DateTime_get_ymdhms (event, &dummy, &dummy, &dummy, &hour,
-          &min, &sec, tz, utc);
-        if (hour == 0 && min == 0 && sec == 0)
-          {
-          // All day event
-          }
-        else
+        if (name)
           {
-          printf (" (%02d:%02d)", hour, min);
+          if (i != 0) fprintf (out, ", ");
+          fprintf (out, "%s", name);
           }
-        putchar ('\n');
-        free (s);
         }
+      fprintf (out, "\n");
       }
-    DateTime_add_days (d, 1, tz, utc); 
+
+    if (ctx->full)
+      {
+      fprintf (out, "                   Day of year: %d\n", 
+         DateTime_get_day_of_year (ctx->datetime));
+      fprintf (out, "                   Julian date: %.2lf\n", 
+         DateTime_get_julian_date (ctx->datetime));
+      fprintf (out, "          Modified Julian date: %.2lf\n", 
+        DateTime_get_modified_julian_date (ctx->datetime));
+      }
+    fprintf (out, "\n");
     } 
-  DateTime_free (d);
+
+  if (show_sunrise_sunset)
+    {
+    if (!ctx->latlong)
+      {
+      fprintf (stderr, 
+        "Can't calculate sunrise/set times because "
+        "no location has been specified.\n");
+      DateTime_free (start);
+      return -1;
+      }
+    fprintf (out, "Sun\n");
+    print_sunrise_time (out, "                       Sunrise: ", 
+      SUNTIMES_DEFAULT_ZENITH, ctx); 
+    print_sunset_time (out, "                        Sunset: ", 
+      SUNTIMES_DEFAULT_ZENITH, ctx); 
+    if (ctx->full)
+      {
+      print_high_noon_time (out, "                     High noon: ", ctx); 
+
+      print_sunrise_time (out, "         Civil twilight starts: ", 
+        SUNTIMES_CIVIL_TWILIGHT, ctx); 
+      print_sunset_time (out, "           Civil twilight ends: ", 
+        SUNTIMES_NAUTICAL_TWILIGHT, ctx); 
+
+      print_sunrise_time (out, "      Nautical twilight starts: ", 
+        SUNTIMES_NAUTICAL_TWILIGHT, ctx); 
+      print_sunset_time (out, "        Nautical twilight ends: ", 
+        SUNTIMES_NAUTICAL_TWILIGHT, ctx); 
+      print_sunrise_time (out, "  Astronomical twilight starts: ", 
+        SUNTIMES_ASTRONOMICAL_TWILIGHT, ctx); 
+      print_sunset_time (out, "    Astronomical twilight ends: ", 
+        SUNTIMES_ASTRONOMICAL_TWILIGHT, ctx); 
+      }
+    fprintf (out, "\n");
+    }
+
+  if (show_moon_state || TRUE)
+    {
+    fprintf (out, "Moon\n");
+    if (show_moon_state)
+      {
+      double phase, age, distance;
+      MoonTimes_get_moon_state (ctx->datetime, &phase, &age, &distance); 
+      const char *phase_name = MoonTimes_get_phase_name (phase);
+      fprintf (out, "                    Moon phase: %.2lf %s\n", 
+        phase, phase_name);
+      if (ctx->full)
+        {
+        fprintf (out, "                      Moon age: %.1lf days\n", age);
+        fprintf (out, "                 Moon distance: %.lf km\n", distance);
+        }
+      }
+    if (show_moon_rise_set)
+      {
+      int i;
+
+      DateTime *end = DateTime_get_day_end (ctx->datetime, ctx->tz);
+
+      RiseSetEvents events;
+      RiseSetEvents_init (&events);
+      MoonTimes_get_moon_events (&ctx->observer, start, end, 
+        MOONTIMES_DEFAULT_TOLERANCE, ctx->precision, ctx->ephemeris, 
+        &events);
+      for (i = 0; i < events.nrises; i++)
+        {
+        char *s = SolunarContext_time_to_string (ctx, events.rises[i]);
+        fprintf (out, "                      Moonrise: %s\n", s);
+        free (s);
+        }
+      for (i = 0; i < events.nsets; i++)
+        {
+        char *s = SolunarContext_time_to_string (ctx, events.sets[i]);
+        fprintf (out, "                       Moonset: %s\n", s);
+        free (s);
+        }
+      RiseSetEvents_clear (&events);
+      DateTime_free (end);
+      }
+    fprintf (out, "\n");
+    }
+
+  DateTime_free (start);
+
+  if (ctx->show_solunar)
+    print_solunar (out, ctx);
+
+  return 0;
   }
 
 
 /*=======================================================================
-get_stars
+append_moon_events
+Append the times of moon events to a batch result field, separated
+by commas, or a '-' if there are none
 =======================================================================*/
-const char *get_stars (double score)
+void append_moon_events (FILE *out, DateTimeFormatter *formatter, 
+    const double events[], int nevents)
   {
-  static char s [20];
-  s[10] = 0;
+  char s[DATETIME_TIME_BUFSIZE];
   int i;
-  for (i = 0; i < 10; i++)
+  if (nevents == 0) fputc ('-', out);
+  for (i = 0; i < nevents; i++)
+    {
+    if (i != 0) fputc (',', out);
+    DateTimeFormatter_time (formatter, timeutil_JD_to_unix (events[i]), s);
+    fputs (s, out);
+    }
+  }
+
+
+/*=======================================================================
+append_sun_event
+Append the time of a sun event to a batch result field, or a '-' if 
+there was none
+=======================================================================*/
+void append_sun_event (FILE *out, DateTimeFormatter *formatter, 
+    RiseSetStatus status, double jd)
+  {
+  char s[DATETIME_TIME_BUFSIZE];
+  if (status != RISESET_OK)
+    fputc ('-', out);
+  else
+    {
+    DateTimeFormatter_time (formatter, timeutil_JD_to_unix (jd), s);
+    fputs (s, out);
+    }
+  }
+
+
+/*=======================================================================
+run_batch_query
+Print the one-line batch result for one location and date. The
+fields are tab-separated:
+location date sunrise sunset moonrise(s) moonset(s) phase solunar
+where 'location' is echoed from the query, the date is YYYY-MM-DD, 
+missing events are shown as '-', and the solunar field is the overall
+score as a percentage, or '-' if scores were not requested. 'moon' is
+the day's moonrises and moonsets, if they are already known, or NULL.
+'formatter' is one set up for the context, which can be kept from
+one day to the next at the same location, or NULL
+=======================================================================*/
+void run_batch_query (FILE *out, const char *location, 
+    const SolunarContext *ctx, const RiseSetTimes *moon,
+    DateTimeFormatter *formatter)
+  {
+  DateTimeFormatter own_formatter;
+  if (!formatter)
+    {
+    SolunarContext_init_formatter (ctx, &own_formatter);
+    formatter = &own_formatter;
+    }
+
+  int year, month, day, dummy;
+  const char *tz = ctx->syslocal ? NULL : ctx->tz;
+  DateTime_get_ymdhms (ctx->datetime, &year, &month, &day, &dummy, 
+    &dummy, &dummy, tz, ctx->utc);
+  fprintf (out, "%s\t%04d-%02d-%02d\t", location, year, month, day);
+
+  // The almanac gives the sun's events on the UT day of the date
+  long ut_day = (long) floor 
+    (DateTime_get_modified_julian_date (ctx->datetime));
+  double jd = 0;
+  RiseSetStatus status = SunTimes_get_sunrise_jd (&ctx->observer, ut_day,
+    SUNTIMES_DEFAULT_ZENITH, &jd);
+  append_sun_event (out, formatter, status, jd);
+  fputc ('\t', out);
+  status = SunTimes_get_sunset_jd (&ctx->observer, ut_day, 
+    SUNTIMES_DEFAULT_ZENITH, &jd);
+  append_sun_event (out, formatter, status, jd);
+  fputc ('\t', out);
+
+  RiseSetTimes times;
+  if (!moon)
+    {
+    double bounds[2];
+    RiseSet_get_day_bounds (ctx->datetime, 1, ctx->tz, ctx->utc, bounds);
+    MoonTimes_get_moon_times (&ctx->observer, bounds[0], 
+      bounds[1] - 1.0 / 86400.0, MOONTIMES_DEFAULT_TOLERANCE, 
+      ctx->precision, ctx->ephemeris, &times);
+    moon = &times;
+    }
+  append_moon_events (out, formatter, moon->rises, moon->nrises);
+  fputc ('\t', out);
+  append_moon_events (out, formatter, moon->sets, moon->nsets);
+
+  double phase, age, distance;
+  MoonTimes_get_moon_state (ctx->datetime, &phase, &age, &distance); 
+  fprintf (out, "\t%.2lf\t", phase);
+
+  if (ctx->show_solunar)
+    {
+    SolunarDay sd;
+    Solunar_get_day (&ctx->observer, ctx->datetime, ctx->tz, ctx->utc, 
+    &sd);
+    fprintf (out, "%d", (int)(sd.overall_score * 100.0));
+    }
+  else
+    fputc ('-', out);
+
+  fputc ('\n', out);
+  }
+
+
+/*=======================================================================
+resolve_location
+Set the location and zone in ctx from a city name or a lat/long, as
+given in a batch query. Returns the location, which the caller must
+free, or NULL after printing a batch error line to 'out'
+=======================================================================*/
+LatLong *resolve_location (FILE *out, const char *location, 
+    SolunarContext *ctx)
+  {
+  LatLong *latlong;
+  ctx->tz = NULL;
+  SolunarContext_set_location (ctx, NULL);
+  char c = location[0];
+  if (c == '+' || c == '-' || c == '.' || (c >= '0' && c <= '9'))
+    {
+    Error *e = NULL;
+    latlong = LatLong_new_parse_in (ctx->arena, location, &e);
+    if (e)
+      {
+      fprintf (out, "%s\tERROR\t%s\n", location, Error_get_message (e));
+      Error_free (e);
+      return NULL;
+      }
+    }
+  else
+    {
+    int nmatches;
+    const City *city = City_find (location, &nmatches);
+    if (!city)
+      {
+      fprintf (out, "%s\tERROR\t%s city\n", location, 
+        nmatches == 0 ? "No matching" : "Ambiguous");
+      return NULL;
+      }
+    ctx->tz = city->name;
+    latlong = City_get_latlong_in (ctx->arena, city);
+    }
+  SolunarContext_set_location (ctx, latlong);
+  return latlong;
+  }
+
+
+/*=======================================================================
+run_batch
+Read queries from 'in', one per line, and write one result line per
+query to 'out'. Each line is 
+
+location [date] [-u|-y] [-t] [-s]
+
+where location is a city name or a lat/long, and the date is in any
+of the forms accepted by --datetime. A line with no date takes 'date',
+the one given on the command line, in the line's zone, or today if 
+that is NULL. Options on the line are added to those given on the 
+command line, which are passed in 'defaults'. A location of '-' means
+the location from the command line or rc file. Blank lines and lines
+starting with '#' are ignored. A query that can't be answered, or 
+that has an option not listed above, produces a line of the form 
+'location ERROR message'
+=======================================================================*/
+int run_batch (FILE *in, FILE *out, const char *date, 
+    const SolunarContext *defaults)
+  {
+  // Everything one query creates is allocated from the arena, and 
+  //  released at once before the next query is read
+  Arena *arena = Arena_new ();
+  char line[1024];
+  while (fgets (line, sizeof (line), in))
     {
-    if (score > (double) i / 10.0)
-      s[i] = '*';
+    Arena_reset (arena);
+    char *save = NULL;
+    char *location = strtok_r (line, " \t\r\n", &save);
+    if (!location || location[0] == '#') continue;
+
+    SolunarContext ctx = *defaults;
+    ctx.arena = arena;
+    char line_date[256];
+    line_date[0] = 0;
+    char bad_option = 0;
+    char *tok;
+    while ((tok = strtok_r (NULL, " \t\r\n", &save)))
+      {
+      if (tok[0] == '-' && tok[1] && !tok[2])
+        {
+        switch (tok[1])
+          {
+          case 'u': ctx.utc = TRUE; break;
+          case 'y': ctx.syslocal = TRUE; break;
+          case 't': ctx.twelvehour = TRUE; break;
+          case 's': ctx.show_solunar = TRUE; break;
+          default: if (!bad_option) bad_option = tok[1];
+          }
+        }
+      else if (strlen (line_date) + strlen (tok) + 2 < sizeof (line_date))
+        {
+        if (line_date[0]) strcat (line_date, " ");
+        strcat (line_date, tok);
+        }
+      }
+
+    if (bad_option)
+      {
+      fprintf (out, "%s\tERROR\tUnknown option -%c\n", location, 
+        bad_option);
+      fflush (out);
+      continue;
+      }
+
+    LatLong *latlong = NULL;
+    if (strcmp (location, "-") != 0)
+      {
+      latlong = resolve_location (out, location, &ctx);
+      if (!latlong)
+        {
+        fflush (out);
+        continue;
+        }
+      }
+
+    if (!ctx.latlong)
+      {
+      fprintf (out, "%s\tERROR\tNo location\n", location);
+      fflush (out);
+      continue;
+      }
+
+    // The date from the command line is parsed afresh for each line,
+    //  since each line can have a zone of its own
+    const char *query_date = line_date[0] ? line_date : date;
+    DateTime *datetime;
+    if (query_date)
+      {
+      Error *e = NULL;
+      datetime = DateTime_new_parse_in (ctx.arena, query_date, &e, 
+        ctx.tz, ctx.utc);
+      if (e)
+        {
+        fprintf (out, "%s\tERROR\t%s\n", location, Error_get_message (e));
+        Error_free (e);
+        LatLong_free (latlong);
+        fflush (out);
+        continue;
+        }
+      }
     else
-      s[i] = ' ';
+      datetime = DateTime_new_today_in (ctx.arena);
+    ctx.datetime = datetime;
+
+    run_batch_query (out, location, &ctx, NULL, NULL);
+    fflush (out);
+
+    DateTime_free (datetime);
+    LatLong_free (latlong);
     }
-  return s;
+  Arena_free (arena);
+  return 0;
+  }
+
+
+/*=======================================================================
+Sweep
+The state shared by the worker threads of run_sweep. Each location is
+one unit of work: workers take the next unclaimed location, write all
+its results to a private buffer, and mark it done. The main thread
+prints the buffers in location order as they become available, so the
+output is the same however many workers there are
+=======================================================================*/
+typedef struct _SweepResult
+  {
+  char *text;
+  size_t length;
+  BOOL done;
+  } SweepResult;
+
+typedef struct _Sweep
+  {
+  const SolunarContext *defaults;
+  const char *date;
+  int ndays;
+  const char **locations;
+  int nlocations;
+  SweepResult *results;
+  int next;
+  pthread_mutex_t lock;
+  pthread_cond_t done_cond;
+  } Sweep;
+
+
+/*=======================================================================
+sweep_location
+Print the batch result lines for 'ndays' consecutive days at one
+location, starting at 'date', or today if date is NULL. 'cache' is
+the calling thread's ephemeris cache, and 'arena' its arena
+=======================================================================*/
+void sweep_location (FILE *out, const char *location, const char *date, 
+    int ndays, const SolunarContext *defaults, EphemerisCache *cache,
+    Arena *arena)
+  {
+  SolunarContext ctx = *defaults;
+  ctx.ephemeris = cache;
+  ctx.arena = arena;
+  LatLong *latlong = resolve_location (out, location, &ctx);
+  if (!latlong) return;
+
+  DateTime *datetime;
+  if (date)
+    {
+    Error *e = NULL;
+    datetime = DateTime_new_parse_in (ctx.arena, date, &e, ctx.tz, 
+      ctx.utc);
+    if (e)
+      {
+      fprintf (out, "%s\tERROR\t%s\n", location, Error_get_message (e));
+      Error_free (e);
+      LatLong_free (latlong);
+      return;
+      }
+    }
+  else
+    datetime = DateTime_new_today_in (ctx.arena);
+  ctx.datetime = datetime;
+
+  // The moon's events for all the days are found together, which is
+  //  quicker than a day at a time
+  double *bounds = malloc ((ndays + 1) * sizeof (double));
+  RiseSetTimes *moon = malloc (ndays * sizeof (RiseSetTimes));
+  RiseSet_get_day_bounds (datetime, ndays, ctx.tz, ctx.utc, bounds);
+  MoonTimes_get_times_range (&ctx.observer, bounds, ndays, 
+    MOONTIMES_DEFAULT_TOLERANCE, ctx.precision, cache, moon);
+
+  DateTimeFormatter formatter;
+  SolunarContext_init_formatter (&ctx, &formatter);
+
+  int i;
+  for (i = 0; i < ndays; i++)
+    {
+    if (i != 0) DateTime_add_days (datetime, 1, ctx.tz, ctx.utc);
+    run_batch_query (out, location, &ctx, &moon[i], &formatter);
+    }
+  free (moon);
+  free (bounds);
+
+  DateTime_free (datetime);
+  LatLong_free (latlong);
+  }
+
+
+/*=======================================================================
+sweep_worker
+=======================================================================*/
+void *sweep_worker (void *arg)
+  {
+  Sweep *sweep = arg;
+  // The cache isn't thread-safe, but most of what one worker puts in
+  //  it will be useful to that worker, since every location covers
+  //  the same days
+  EphemerisCache *cache = EphemerisCache_new 
+    (EphemerisCache_get_file (sweep->defaults->ephemeris));
+  // Each worker has its own arena, reset after each location
+  Arena *arena = Arena_new ();
+  while (1)
+    {
+    pthread_mutex_lock (&sweep->lock);
+    int i = sweep->next++;
+    pthread_mutex_unlock (&sweep->lock);
+    if (i >= sweep->nlocations) break;
+
+    char *text = NULL;
+    size_t length = 0;
+    FILE *out = open_memstream (&text, &length);
+    sweep_location (out, sweep->locations[i], sweep->date, sweep->ndays, 
+      sweep->defaults, cache, arena);
+    fclose (out);
+    Arena_reset (arena);
+
+    pthread_mutex_lock (&sweep->lock);
+    sweep->results[i].text = text;
+    sweep->results[i].length = length;
+    sweep->results[i].done = TRUE;
+    pthread_cond_broadcast (&sweep->done_cond);
+    pthread_mutex_unlock (&sweep->lock);
+    }
+  Arena_free (arena);
+  EphemerisCache_free (cache);
+  return NULL;
+  }
+
+
+/*=======================================================================
+run_sweep
+Write batch result lines for each of the locations, for 'ndays' days
+starting at 'date', to 'out'. The locations are shared out among one
+worker thread per processor, but the results are written in the order
+the locations are given
+=======================================================================*/
+int run_sweep (FILE *out, const char **locations, int nlocations, 
+    const char *date, int ndays, const SolunarContext *defaults)
+  {
+  Sweep sweep;
+  sweep.defaults = defaults;
+  sweep.date = date;
+  sweep.ndays = ndays;
+  sweep.locations = locations;
+  sweep.nlocations = nlocations;
+  sweep.results = calloc (nlocations, sizeof (SweepResult));
+  sweep.next = 0;
+  pthread_mutex_init (&sweep.lock, NULL);
+  pthread_cond_init (&sweep.done_cond, NULL);
+
+  int nthreads = sysconf (_SC_NPROCESSORS_ONLN);
+  if (nthreads > nlocations) nthreads = nlocations;
+  if (nthreads < 1) nthreads = 1;
+  pthread_t *threads = malloc (nthreads * sizeof (pthread_t));
+  int i, started = 0;
+  for (i = 0; i < nthreads; i++)
+    {
+    if (pthread_create (&threads[started], NULL, sweep_worker, &sweep) == 0)
+      started++;
+    }
+  // If no thread could be started, do all the work on this one
+  if (started == 0) sweep_worker (&sweep);
+
+  for (i = 0; i < nlocations; i++)
+    {
+    pthread_mutex_lock (&sweep.lock);
+    while (!sweep.results[i].done)
+      pthread_cond_wait (&sweep.done_cond, &sweep.lock);
+    pthread_mutex_unlock (&sweep.lock);
+    fwrite (sweep.results[i].text, 1, sweep.results[i].length, out);
+    fflush (out);
+    free (sweep.results[i].text);
+    }
+
+  for (i = 0; i < started; i++)
+    pthread_join (threads[i], NULL);
+
+  free (threads);
+  free (sweep.results);
+  pthread_mutex_destroy (&sweep.lock);
+  pthread_cond_destroy (&sweep.done_cond);
+  return 0;
+  }
+
+
+/*=======================================================================
+read_cities_file
+Read location names, one per line, from a file. Blank lines and lines
+starting with '#' are ignored. Returns an array of strings, which the
+caller must free along with each string, or NULL if the file can't
+be read
+=======================================================================*/
+char **read_cities_file (const char *filename, int *nlocations)
+  {
+  FILE *f = fopen (filename, "r");
+  if (!f) return NULL;
+
+  char **locations = NULL;
+  int n = 0, size = 0;
+  char line[1024];
+  while (fgets (line, sizeof (line), f))
+    {
+    char *save = NULL;
+    char *location = strtok_r (line, " \t\r\n", &save);
+    if (!location || location[0] == '#') continue;
+    if (n == size)
+      {
+      size = size ? size * 2 : 64;
+      locations = realloc (locations, size * sizeof (char *));
+      }
+    locations[n++] = strdup (location);
+    }
+  fclose (f);
+
+  *nlocations = n;
+  if (!locations) locations = malloc (sizeof (char *));
+  return locations;
   }
 
 
@@ -339,10 +1058,17 @@ int main (int argc, char **argv)
   static BOOL opt_list_named_days = FALSE;
   static BOOL opt_twelvehour = FALSE;
   static BOOL opt_show_solunar = FALSE;
-  BOOL show_sunrise_sunset = TRUE;
-  BOOL show_moon_state = TRUE;
-  BOOL show_moon_rise_set = TRUE;
-  BOOL show_today = TRUE;
+  static BOOL opt_batch = FALSE;
+  static BOOL opt_all_cities = FALSE;
+  static BOOL opt_alloc_stats = FALSE;
+  char *cities_file = NULL;
+  int ndays = 1;
+  BOOL opt_ndays = FALSE;
+  char *build_ephemeris = NULL;
+  char *ephemeris = NULL;
+  EphemerisFile *ephemerisObj = NULL;
+  char *precision = NULL;
+  MoonTimesPrecision precisionTier = MOONTIMES_PRECISION_STANDARD;
   char *datetime = NULL;
   char *tz = NULL;
   DateTime *datetimeObj = NULL;
@@ -351,12 +1077,17 @@ int main (int argc, char **argv)
   char *latlong = NULL;
   LatLong *latlongObj = NULL;
   LatLong *workingLatlong = NULL;
-  PointerList *day_events = NULL;
+  NamedDays *day_events = NULL;
   static struct option long_options[] = 
     {
+    {"all-cities", no_argument, &opt_all_cities, 0},
+    {"alloc-stats", no_argument, &opt_alloc_stats, 0},
+    {"batch", no_argument, &opt_batch, 0},
+    {"build-ephemeris", required_argument, NULL, 0},
     {"city", required_argument, NULL, 'c'},
     {"full", no_argument, &opt_full, 'f'},
     {"cities", no_argument, &opt_cities, 0},
+    {"cities-file", required_argument, NULL, 0},
     {"datetime", required_argument, NULL, 'd'},
     {"help", no_argument, &opt_help, 'h'},
     {"latlong", required_argument, NULL, 'l'},
@@ -367,6 +1098,9 @@ int main (int argc, char **argv)
     {"twelvehour", no_argument, &opt_twelvehour, 't'},
     {"version", no_argument, &opt_version, 'v'},
     {"days", no_argument, &opt_list_named_days, 0},
+    {"ephemeris", required_argument, NULL, 0},
+    {"ndays", required_argument, NULL, 0},
+    {"precision", required_argument, NULL, 0},
     {"solunar", no_argument, &opt_show_solunar, 0},
     {0, 0, 0, 0},
     };
@@ -383,23 +1117,59 @@ int main (int argc, char **argv)
         {
         if (strcmp (long_options[option_index].name, "longhelp") == 0)
           {
-          opt_longhelp = TRUE;
+          opt_longhelp = TRUE;
+          }
+        if (strcmp (long_options[option_index].name, "utc") == 0)
+          {
+          opt_utc = TRUE;
+          }
+        if (strcmp (long_options[option_index].name, "syslocal") == 0)
+          {
+          opt_syslocal = TRUE;
+          }
+        if (strcmp (long_options[option_index].name, "days") == 0)
+          {
+          opt_list_named_days = TRUE;
+          }
+        else if (strcmp (long_options[option_index].name, "cities") == 0)
+          {
+          opt_cities = TRUE;
+          }
+        else if (strcmp (long_options[option_index].name, "batch") == 0)
+          {
+          opt_batch = TRUE;
+          }
+        else if (strcmp (long_options[option_index].name, "all-cities") == 0)
+          {
+          opt_all_cities = TRUE;
+          }
+        else if (strcmp (long_options[option_index].name, "alloc-stats") 
+            == 0)
+          {
+          opt_alloc_stats = TRUE;
+          }
+        else if (strcmp (long_options[option_index].name, "cities-file") 
+            == 0)
+          {
+          cities_file = strdup (optarg);
           }
-        if (strcmp (long_options[option_index].name, "utc") == 0)
+        else if (strcmp (long_options[option_index].name, 
+            "build-ephemeris") == 0)
           {
-          opt_utc = TRUE;
+          build_ephemeris = strdup (optarg);
           }
-        if (strcmp (long_options[option_index].name, "syslocal") == 0)
+        else if (strcmp (long_options[option_index].name, "ephemeris") == 0)
           {
-          opt_syslocal = TRUE;
+          ephemeris = strdup (optarg);
           }
-        if (strcmp (long_options[option_index].name, "days") == 0)
+        else if (strcmp (long_options[option_index].name, "ndays") == 0)
           {
-          opt_list_named_days = TRUE;
+          ndays = atoi (optarg);
+          opt_ndays = TRUE;
           }
-        else if (strcmp (long_options[option_index].name, "cities") == 0)
+        else if (strcmp (long_options[option_index].name, "precision") == 0)
           {
-          opt_cities = TRUE;
+          precision = strdup (optarg);
           }
         else if (strcmp (long_options[option_index].name, "solunar") == 0)
           {
@@ -466,6 +1236,9 @@ int main (int argc, char **argv)
       }
     }
 
+  if (opt_alloc_stats)
+    atexit (print_alloc_stats);
+
   if (opt_version)
     {
     printf ("solunar version %s\nCopyright (c)2005-2019 Kevin Boone\n", VERSION);
@@ -491,6 +1264,54 @@ int main (int argc, char **argv)
     exit (0);
     }
 
+  if (ndays < 1)
+    {
+    fprintf (stderr, "Number of days must be at least 1\n");
+    exit (-1);
+    }
+
+  if (opt_ndays && !opt_all_cities && !cities_file)
+    {
+    fprintf (stderr, 
+      "--ndays can only be used with --all-cities or --cities-file\n");
+    exit (-1);
+    }
+
+  if (precision)
+    {
+    if (!MoonTimes_parse_precision (precision, &precisionTier))
+      {
+      fprintf (stderr, 
+        "Precision must be 'fast', 'standard', or 'high'\n");
+      exit (-1);
+      }
+    free (precision);
+    }
+
+  if (build_ephemeris)
+    {
+    int first_year, last_year;
+    if (sscanf (build_ephemeris, "%d-%d", &first_year, &last_year) != 2
+        || optind >= argc)
+      {
+      fprintf (stderr, 
+        "Usage: %s --build-ephemeris YYYY-YYYY file\n", argv[0]);
+      exit (-1);
+      }
+    Error *e = NULL;
+    if (!EphemerisFile_build (argv[optind], first_year, last_year, &e))
+      {
+      fprintf (stderr, "%s\n", Error_get_message (e));
+      Error_free (e);
+      exit (-1);
+      }
+    if (!opt_quiet)
+      printf ("Wrote ephemeris for %d-%d to %s\n", first_year, last_year,
+        argv[optind]);
+    free (build_ephemeris);
+    exit (0);
+    }
+
   if (opt_syslocal && opt_utc)
     {
     fprintf (stderr, 
@@ -528,6 +1349,10 @@ int main (int argc, char **argv)
             {
             city = strdup (value);
             }
+          else if (strcmp (key, "ephemeris") == 0 && !ephemeris)
+            {
+            ephemeris = strdup (value);
+            }
           }
 	}
       fclose (f);
@@ -537,15 +1362,15 @@ int main (int argc, char **argv)
 
   if (city)
     {
-    PointerList *cities = City_get_matching_name (city);
-    int i, l = PointerList_get_length (cities);
+    PointerArray *cities = City_get_matching_name (city);
+    int i, l = PointerArray_get_length (cities);
    
     if (l == 0)
       {
       fprintf (stderr, 
         "No city matching \"%s\"\n\"%s --cities\" shows a list\n",
         city, argv[0]);
-      PointerList_free (cities, TRUE);
+      PointerArray_free (cities, TRUE);
       exit (-1);
       }
     
@@ -554,16 +1379,16 @@ int main (int argc, char **argv)
       fprintf (stderr, "Ambiguous city \"%s\". Matches:\n", city);
       for (i = 0; i < l; i++)
         {
-        const char *name = PointerList_get_const_pointer (cities, i);
+        const char *name = PointerArray_get_const_pointer (cities, i);
         printf ("  %s\n", name);
         }
-      PointerList_free (cities, TRUE);
+      PointerArray_free (cities, TRUE);
       exit (0);
       }
 
     // If we get here, we have been told exactly one city. 
-    cityObj = City_new_from_name (PointerList_get_const_pointer (cities, 0));
-    PointerList_free (cities, TRUE);
+    cityObj = City_new_from_name (PointerArray_get_const_pointer (cities, 0));
+    PointerArray_free (cities, TRUE);
     }
 
   if (latlong)
@@ -586,7 +1411,7 @@ int main (int argc, char **argv)
 
   if (cityObj)
     {
-    if (!opt_quiet)
+    if (!opt_quiet && !opt_batch && !opt_all_cities && !cities_file)
       printf ("Selected city %s\n", cityObj->name);
     tz = cityObj->name;
     }
@@ -596,7 +1421,7 @@ int main (int argc, char **argv)
     workingLatlong = LatLong_clone (latlongObj);
     if (cityObj)
       {
-      if (!opt_quiet)
+      if (!opt_quiet && !opt_batch && !opt_all_cities && !cities_file)
         printf ("Overriding city location with specified lat/long\n");
       }
     else
@@ -616,6 +1441,85 @@ int main (int argc, char **argv)
      }
    }
 
+  if (ephemeris)
+    {
+    Error *e = NULL;
+    ephemerisObj = EphemerisFile_open (ephemeris, &e);
+    if (e)
+      {
+      fprintf (stderr, "%s\n", Error_get_message (e));
+      Error_free (e);
+      exit (-1);
+      }
+    }
+
+  SolunarContext ctx;
+  SolunarContext_init (&ctx, tz, opt_utc, opt_syslocal);
+  ctx.ephemeris = EphemerisCache_new (ephemerisObj);
+  SolunarContext_set_location (&ctx, workingLatlong);
+  ctx.twelvehour = opt_twelvehour;
+  ctx.full = opt_full;
+  ctx.quiet = opt_quiet;
+  ctx.show_solunar = opt_show_solunar;
+  ctx.precision = precisionTier;
+
+  if (opt_batch)
+    {
+    int ret = run_batch (stdin, stdout, datetime, &ctx);
+    if (datetime) free (datetime);
+    if (latlong) free (latlong);
+    if (latlongObj) LatLong_free (latlongObj);
+    if (workingLatlong) LatLong_free (workingLatlong);
+    if (city) free (city);
+    if (cityObj) City_free (cityObj);
+    EphemerisCache_free (ctx.ephemeris);
+    EphemerisFile_close (ephemerisObj);
+    if (ephemeris) free (ephemeris);
+    return ret;
+    }
+
+  if (opt_all_cities || cities_file)
+    {
+    const char **locations;
+    char **names = NULL;
+    int i, nlocations = 0;
+    if (cities_file)
+      {
+      names = read_cities_file (cities_file, &nlocations);
+      if (!names)
+        {
+        fprintf (stderr, "Can't read cities file \"%s\"\n", cities_file);
+        exit (-1);
+        }
+      locations = (const char **)names;
+      }
+    else
+      {
+      while (cities[nlocations].name) nlocations++;
+      locations = malloc (nlocations * sizeof (char *));
+      for (i = 0; i < nlocations; i++)
+        locations[i] = cities[i].name;
+      }
+    int ret = run_sweep (stdout, locations, nlocations, datetime, ndays, 
+      &ctx);
+    if (names)
+      {
+      for (i = 0; i < nlocations; i++) free (names[i]);
+      }
+    free (locations);
+    if (cities_file) free (cities_file);
+    if (datetime) free (datetime);
+    if (latlong) free (latlong);
+    if (latlongObj) LatLong_free (latlongObj);
+    if (workingLatlong) LatLong_free (workingLatlong);
+    if (city) free (city);
+    if (cityObj) City_free (cityObj);
+    EphemerisCache_free (ctx.ephemeris);
+    EphemerisFile_close (ephemerisObj);
+    if (ephemeris) free (ephemeris);
+    return ret;
+    }
+
   if (workingLatlong)
     {
     if (!opt_quiet)
@@ -650,459 +1554,25 @@ int main (int argc, char **argv)
   else
     datetimeObj = DateTime_new_today ();
 
-  if (show_today)
-    {
-    int year, dummy;
-    DateTime_get_ymdhms (datetimeObj, &year, &dummy, &dummy, &dummy, 
-      &dummy, &dummy, tz, opt_utc);
-    day_events = initialize_day_events (tz, opt_utc, year, workingLatlong);
-    }
+  ctx.datetime = datetimeObj;
 
+  int year, dummy;
+  DateTime_get_ymdhms (datetimeObj, &year, &dummy, &dummy, &dummy, 
+    &dummy, &dummy, tz, opt_utc);
+  day_events = initialize_day_events (tz, opt_utc, year, workingLatlong);
 
   if (!opt_quiet)
-    {
-    char *s;
-    if (opt_utc)
-      {
-      s = DateTime_to_string_UTC (datetimeObj);
-      printf ("Date/time %s %s\n", s, "UTC");
-      }
-    else if (opt_syslocal || !tz)
-      {
-      s = DateTime_to_string_syslocal (datetimeObj);
-      printf ("Date/time %s %s\n", s, "syslocal");
-      }
-    else
-      {
-      s = DateTime_to_string_local (datetimeObj, tz);
-      printf ("Date/time %s %s\n", s, "local");
-      }
-    free (s);
-    printf ("\n");
-    }
+    print_datetime_caption (stdout, &ctx);
 
+  int ret = 0;
   if (opt_list_named_days)
     {
-    if (!datetimeObj)
-      {
-      fprintf (stderr, 
-        "Can't list days because "
-        "no starting date has been specified.\n");
-      free_day_events (day_events);
-      exit (-1);
-      }
     DateTime *jan_first = DateTime_get_jan_first (datetimeObj, tz, opt_utc);
     list_named_days (day_events, jan_first, tz, opt_utc);
     DateTime_free (jan_first);
-    exit (0);
-    }
- 
-  DateTime *start = DateTime_get_day_start (datetimeObj, tz);
-
-  if (show_today)
-    {
-    if (!datetimeObj)
-      {
-      fprintf (stderr, 
-        "Can't calculate astronomical dates because "
-        "no calendar date/time has been specified.\n");
-      free_day_events (day_events);
-      exit (-1);
-      }
-
-    printf ("Today\n");
-    char *s;
-    if (opt_syslocal)
-      s = DateTime_date_to_string_syslocal (start);
-    else if (opt_utc)
-      s = DateTime_date_to_string_UTC (start);
-    else
-      s = DateTime_date_to_string_local (start, tz);
-    //char *s = DateTime_date_to_string (start);
-    printf ("                          Date: %s\n", s);
-    free (s);
-
-    PointerList *events = get_named_days_today (day_events, datetimeObj);
-    int i, l = PointerList_get_length (events);
-    if (l > 0)
-      {
-      printf ("                      Today is: ");
-      for (i = 0; i < l; i++)
-        {
-        DateTime *event = PointerList_get_pointer (events, i);
-        const char *name = DateTime_get_name (event);
-        if (name)
-          {
-          if (i != 0) printf (", ");
-          printf ("%s", name);
-          }
-        DateTime_free (event);
-        }
-      printf ("\n");
-      }
-    PointerList_free (events, FALSE);
-
-    if (opt_full)
-      {
-      printf ("                   Day of year: %d\n", 
-         DateTime_get_day_of_year (datetimeObj, tz));
-      printf ("                   Julian date: %.2lf\n", 
-         DateTime_get_julian_date (datetimeObj));
-      printf ("          Modified Julian date: %.2lf\n", 
-        DateTime_get_modified_julian_date (datetimeObj));
-      }
-    printf ("\n");
-    } 
-
-  BOOL twelve_hour = opt_twelvehour;
-
-  if (show_sunrise_sunset)
-    {
-    if (!workingLatlong)
-      {
-      fprintf (stderr, 
-        "Can't calculate sunrise/set times because "
-        "no location has been specified.\n");
-      free_day_events (day_events);
-      exit (-1);
-      }
-    if (!datetimeObj)
-      {
-      fprintf (stderr, 
-        "Can't calculate sunrise/set times because "
-        "no date has been specified.\n");
-      exit (-1);
-      }
-    printf ("Sun\n");
-    print_sunrise_time ("                       Sunrise: ", 
-      SUNTIMES_DEFAULT_ZENITH, opt_utc, tz, 
-      workingLatlong, datetimeObj, twelve_hour, opt_syslocal); 
-    print_sunset_time ("                        Sunset: ", 
-      SUNTIMES_DEFAULT_ZENITH, opt_utc, tz, 
-      workingLatlong, datetimeObj, twelve_hour, opt_syslocal); 
-    if (opt_full)
-      {
-      print_high_noon_time ("                     High noon: ", 
-        opt_utc, tz, workingLatlong, datetimeObj, twelve_hour, opt_syslocal); 
-
-      print_sunrise_time ("         Civil twilight starts: ", 
-        SUNTIMES_CIVIL_TWILIGHT, 
-        opt_utc, tz, workingLatlong, datetimeObj, twelve_hour, opt_syslocal); 
-      print_sunset_time ("           Civil twilight ends: ", 
-        SUNTIMES_NAUTICAL_TWILIGHT, 
-        opt_utc, tz, workingLatlong, datetimeObj, twelve_hour, opt_syslocal); 
-
-      print_sunrise_time ("      Nautical twilight starts: ", 
-        SUNTIMES_NAUTICAL_TWILIGHT, 
-        opt_utc, tz, workingLatlong, datetimeObj, twelve_hour, opt_syslocal); 
-      print_sunset_time ("        Nautical twilight ends: ", 
-        SUNTIMES_NAUTICAL_TWILIGHT, 
-        opt_utc, tz, workingLatlong, datetimeObj, twelve_hour, opt_syslocal); 
-      print_sunrise_time ("  Astronomical twilight starts: ", 
-        SUNTIMES_ASTRONOMICAL_TWILIGHT, 
-        opt_utc, tz, workingLatlong, datetimeObj, twelve_hour, opt_syslocal); 
-      print_sunset_time ("    Astronomical twilight ends: ", 
-        SUNTIMES_ASTRONOMICAL_TWILIGHT, 
-        opt_utc, tz, workingLatlong, datetimeObj, twelve_hour, opt_syslocal); 
-      }
-    printf ("\n");
-    }
-
-  if (show_moon_state || TRUE)
-    {
-    if (!datetimeObj)
-      {
-      fprintf (stderr, 
-        "Can't calculate moon phase because "
-        "no date has been specified.\n");
-      free_day_events (day_events);
-      exit (-1);
-      }
-    printf ("Moon\n");
-    if (show_moon_state)
-      {
-      double phase, age, distance;
-      MoonTimes_get_moon_state (datetimeObj, &phase, &age, &distance); 
-      const char *phase_name = MoonTimes_get_phase_name (phase);
-      printf ("                    Moon phase: %.2lf %s\n", phase, phase_name);
-      if (opt_full)
-        {
-        printf ("                      Moon age: %.1lf days\n", age);
-        printf ("                 Moon distance: %.lf km\n", distance);
-        }
-      }
-    if (show_moon_rise_set)
-      {
-      if (!workingLatlong)
-        {
-        fprintf (stderr, 
-          "Can't calculate sunrise/set times because "
-          "no location has been specified.\n");
-        free_day_events (day_events);
-        exit (-1);
-        }
-      int i, nevents = 0;
-
-      DateTime *end = DateTime_get_day_end (datetimeObj, tz);
-
-      DateTime *events[4];
-      MoonTimes_get_moon_rises (workingLatlong, start, end, 
-        15 * 60, events, 4, &nevents);
-      for (i = 0; i < nevents; i++)
-        {
-        char *s;
-        if (opt_syslocal)
-          s = DateTime_time_to_string_syslocal (events[i], twelve_hour);
-        else if (opt_utc)
-          s = DateTime_time_to_string_UTC (events[i], twelve_hour);
-        else
-          s = DateTime_time_to_string_local (events[i], tz, twelve_hour);
-        printf ("                      Moonrise: %s\n", s);
-        free (s);
-        DateTime_free (events[i]);
-        }
-      MoonTimes_get_moon_sets (workingLatlong, start, end, 
-        15 * 60, events, 4, &nevents);
-      for (i = 0; i < nevents; i++)
-        {
-        char *s;
-        if (opt_syslocal)
-          s = DateTime_time_to_string_syslocal (events[i], twelve_hour);
-        else if (opt_utc)
-          s = DateTime_time_to_string_UTC (events[i], twelve_hour);
-        else
-          s = DateTime_time_to_string_local (events[i], tz, twelve_hour);
-        printf ("                       Moonset: %s\n", s);
-        free (s);
-        DateTime_free (events[i]);
-        }
-      DateTime_free (start);
-      DateTime_free (end);
-      }
-    printf ("\n");
-    }
-
-  if (opt_show_solunar)
-    {
-    if (!workingLatlong)
-      {
-      fprintf (stderr, 
-        "Can't calculate solunar scores because "
-        "no location has been specified.\n");
-      free_day_events (day_events);
-      exit (-1);
-      }
-    if (!datetimeObj)
-      {
-      fprintf (stderr, 
-        "Can't calculate solunar scores because "
-        "no date has been specified.\n");
-      exit (-1);
-      }
-
-    printf ("Solunar\n");
-
-    double phase, age, distance;
-    MoonTimes_get_moon_state (datetimeObj, &phase, &age, &distance); 
-    double phase_score = Solunar_score_moon_phase (phase);
-    double distance_score = Solunar_score_moon_distance (distance);
-
-    printf ("              Moon phase score: %d%%\n", 
-      (int)(phase_score * 100.0));
-
-    printf ("           Moon distance score: %d%%", 
-      (int)(distance_score * 100.0));
-
-    printf ("\n");
-
-    int dummy, year, month, day;
-    DateTime_get_ymdhms (datetimeObj, &year, &month, &day, &dummy,
-          &dummy, &dummy, tz, opt_utc);
-
-    // Work out the maximum and minimum values of solunar and lunar
-    //  sine altitude over the whole day 
-
-    DateTime *mn = DateTime_new_dmy_name (day, month, year, 
-     "", tz, opt_utc);
-
-    double min_la = 0, max_la = 0, min_sa = 0, max_sa = 0;
-
-    double increment = 0.0;
-    for (; increment < 24; increment += 0.5)
-      {
-      // We'll take our calculation point as the middle of the
-      //  30 minute time period we are displaying
-
-      DateTime *t_center = DateTime_clone (mn);
-      DateTime_add_seconds (t_center, 1800 / 2);
-
-      double sa = SunTimes_get_SA (workingLatlong, t_center);
-      double la = MoonTimes_get_SA (workingLatlong, t_center);
-
-      if (sa > max_sa) max_sa = sa;
-      if (la > max_la) max_la = la;
-      if (sa < min_sa) min_sa = sa;
-      if (la < min_la) min_la = la;
-
-      DateTime_add_seconds (mn, 1800);
-      DateTime_free (t_center);
-      }
-
-    DateTime_free (mn);
-
-    //printf ("max la = %f min la = %f max sa = %f min sa = %f\n",
-    // max_la, min_la, max_sa, min_sa);
-
-    if (opt_full)
-      {
-      printf ("\n");
-      if (opt_twelvehour)
-        {
-        printf ("Time     Sun        Moon       Combined\n");
-        printf ("====     ===        ====       ========\n");
-        }
-      else
-        {
-        printf ("Time  Sun        Moon       Combined\n");
-        printf ("====  ===        ====       ========\n");
-        }
-      }
-
-    mn = DateTime_new_dmy_name (day, month, year, 
-     "", tz, opt_utc);
-    increment = 0.0;
-    double total_combined_score = 0.0;
-
-    BOOL in_solunar_period = FALSE;
-    int num_solunar_periods = 0;
-    // Since there's only one sun, and it has at most four significant
-    //  events (rise, set, under, over), there can't be more than four
-    //  active solunar events, even if there are multiple moonrises and
-    //  sets in one 24 hour period (which is theoretically possible).
-
-    DateTime *solunar_mid[4];    
-
-    double last_combined_score = 0;
-    BOOL got_solunar = FALSE;
-    for (; increment < 24; increment += 0.5)
-      {
-      char *ts = DateTime_time_to_string_local (mn, tz, twelve_hour);
-
-      // We'll take our calculation point as the middle of the
-      //  30 minute time period we are displaying
-
-      DateTime *t_center = DateTime_clone (mn);
-      DateTime_add_seconds (t_center, 1800 / 2);
-
-      double sa = SunTimes_get_SA (workingLatlong, t_center);
-      double la = MoonTimes_get_SA (workingLatlong, t_center);
-
-      BOOL include_high_noon = TRUE;
-      BOOL include_sun_underfoot = FALSE;
-      double sunscore = Solunar_score_solar_sa (sa, include_high_noon, 
-        include_sun_underfoot, max_sa, min_sa);
-
-      double moonscore = Solunar_score_moon (la, max_la, min_la);
-      double combined_score = moonscore * sunscore;
-      total_combined_score += combined_score;
-
-      if (in_solunar_period)
-        {
-        if (combined_score < last_combined_score)
-          {
-          if (!got_solunar)
-            {
-            got_solunar = TRUE;
-            solunar_mid[num_solunar_periods] = 
-              DateTime_clone (t_center);
-            DateTime_add_seconds (solunar_mid[num_solunar_periods], 
-              -1800);
-            num_solunar_periods++;
-            }
-          }
-        }
-
-      if (combined_score > 0.05 && !in_solunar_period)
-        {
-        in_solunar_period = TRUE;
-        }
-
-      if (combined_score <= 0.05 && in_solunar_period)
-        {
-        in_solunar_period = FALSE;
-        }
-
-      if (combined_score <= 0.05) 
-        {
-        got_solunar = FALSE; 
-        }
-
-      if (opt_full)
-        {
-        printf ("%s ", ts);
-        printf ("%s ", get_stars (sunscore));
-        printf ("%s ", get_stars (moonscore));
-        printf ("%s\n", get_stars (combined_score));
-        }
- 
-      DateTime_add_seconds (mn, 1800);
-      DateTime_free (t_center);
-      free (ts);
-      last_combined_score = combined_score;
-      }
-
-    DateTime_free (mn);
-
-   // We get the total coincidence score by integrating the 
-   //  combined sun/moon score over the 24-hour period. It's 
-   //  very difficult to work out what the maximum value of this
-   //  setting. The divisor '5' here is based on a large number of
-   //  experiments, such that the maximum value in a year-long period
-   //  is 1.00 
-    double coincidence_score = total_combined_score / 5; 
-    if (coincidence_score > 1.0) coincidence_score = 1.0;
-
-    if (opt_full)
-      {
-      printf ("\n");
-      }
-
-    printf ("     Solunar coincidence score: %d%%\n", 
-      (int)(coincidence_score * 100.0));
-    printf ("            Solunar peak times:"); 
-    if (num_solunar_periods == 0) printf (" none\n");
-    else
-      {
-      int i;
-      for (i = 0; i < num_solunar_periods; i++)
-        {
-        char *s;
-        if (opt_syslocal)
-          s = DateTime_time_to_string_syslocal (solunar_mid[i], 
-            opt_twelvehour);
-        else if (opt_utc)
-          s = DateTime_time_to_string_UTC (solunar_mid[i], 
-            opt_twelvehour);
-        else 
-          s = DateTime_time_to_string_local (solunar_mid[i], 
-            tz, opt_twelvehour);
-        printf (" %s", s);
-        free (s);
-        }
-      printf ("\n");
-      }
-
-
-    int i;
-    for (i = 0; i < num_solunar_periods; i++)
-      {
-      DateTime_free (solunar_mid[i]);    
-      }
-
-    printf ("         Overall solunar score: %d%%\n", 
-      (int)((coincidence_score + phase_score + distance_score) / 3.0 * 100.0));
     }
-
+  else
+    ret = run_query (stdout, &ctx, day_events);
 
   if (datetime) free (datetime);
   if (datetimeObj) DateTime_free (datetimeObj);
@@ -1112,7 +1582,10 @@ int main (int argc, char **argv)
   if (city) free (city);
   if (cityObj) City_free (cityObj);
   free_day_events (day_events);
+  EphemerisCache_free (ctx.ephemeris);
+  EphemerisFile_close (ephemerisObj);
+  if (ephemeris) free (ephemeris);
 
-  return 0;
+  return ret;
   }
 
@@ -54,83 +54,88 @@ void mathutil_get_minima (double *x, double *y, int npoints, double *mins,
   } 
 }
 
-// Find zero-crossings using muller's method 
-void mathutil_get_positive_axis_crossings (double *x, double *y, 
-  int npoints, double *mins, int maxmins, int *nmins)
+
+/*=======================================================================
+mathutil_find_root
+Find a root of f between a and b by Brent's method, which combines
+bisection with secant and inverse quadratic interpolation steps. fa 
+and fb are the values of f at a and b, which the caller will usually
+have worked out already to establish that they have opposite signs;
+if they don't, the result is whichever end is nearer to zero. The 
+search stops when the root is known to within tolerance. If nevals 
+is not NULL, the number of evaluations of f is added to it
+=======================================================================*/
+double mathutil_find_root (double (*f)(double x, void *data), void *data,
+  double a, double b, double fa, double fb, double tolerance, int *nevals)
 {
-  *nmins = 0;
+  if ((fa > 0 && fb > 0) || (fa < 0 && fb < 0))
+    return fabs (fa) < fabs (fb) ? a : b;
 
+  double c = b, fc = fb, d = 0, e = 0;
   int i;
-  for (i = 1; i < npoints - 1  && *nmins < maxmins; i++)
+  for (i = 0; i < 100; i++)
   {
-    double y0 = y[i - 1];
-    double y1 = y[i];
-    double y2 = y[i + 1];
-    if (y0 < 0 && y1 <= 0 && y2 > 0)
+    if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0))
     {
-      double root1 = 0.0;
-      double root2 = 0.0;
-      double A = (0.5 * (y0 + y2)) - y1;
-      double B = (0.5 * (y2 - y0));
-      double C = y1;
-      double xExtreme = -B / (2.0 * A);
-      double discriminant = (B * B) - 4.0 * A * C;
-      if (discriminant >= 0.0)
-      { 
-        double DX = 0.5 * sqrt(discriminant) / fabs(A);
-        root1 = xExtreme - DX;
-        root2 = xExtreme + DX;
-        double bisect = 0;
-        if (fabs (root2) < 1.0)
-          bisect = root2;
-        else if (fabs (root1) < 1.0)
-          bisect = root1;
-        double xguess = x[i] + (bisect * (x[i] - x[i-1])); 
-        mins[*nmins] = xguess;
-        (*nmins)++;
-      }
+      // The root lies between a and b; make c the other end
+      c = a;
+      fc = fa;
+      e = d = b - a;
+    }
+    if (fabs (fc) < fabs (fb))
+    {
+      a = b; b = c; c = a;
+      fa = fb; fb = fc; fc = fa;
     }
-  } 
-}
 
-// Find zero-crossings using muller's method 
-void mathutil_get_negative_axis_crossings (double *x, double *y, 
-  int npoints, double *mins, int maxmins, int *nmins)
-{
-  *nmins = 0;
+    double tol = 2.0 * 1e-16 * fabs (b) + 0.5 * tolerance;
+    double m = 0.5 * (c - b);
+    if (fabs (m) <= tol || fb == 0.0) break;
 
-  int i;
-  for (i = 1; i < npoints - 1  && *nmins < maxmins; i++)
-  {
-    double y0 = y[i - 1];
-    double y1 = y[i];
-    double y2 = y[i + 1];
-    if (y0 > 0 && y1 >= 0 && y2 < 0)
+    if (fabs (e) >= tol && fabs (fa) > fabs (fb))
     {
-      double root1 = 0.0;
-      double root2 = 0.0;
-      double A = (0.5 * (y0 + y2)) - y1;
-      double B = (0.5 * (y2 - y0));
-      double C = y1;
-      double xExtreme = -B / (2.0 * A);
-      double discriminant = (B * B) - 4.0 * A * C;
-      if (discriminant >= 0.0)
-      { 
-        double DX = 0.5 * sqrt(discriminant) / fabs(A);
-        root1 = xExtreme - DX;
-        root2 = xExtreme + DX;
-        double bisect = 0;
-        if (fabs (root2) < 1.0)
-          bisect = root2;
-        else if (fabs (root1) < 1.0)
-          bisect = root1;
-        double xguess = x[i] + (bisect * (x[i] - x[i-1])); 
-        mins[*nmins] = xguess;
-        (*nmins)++;
+      // Try interpolation
+      double p, q, r, s = fb / fa;
+      if (a == c)
+      {
+        p = 2.0 * m * s;
+        q = 1.0 - s;
+      }
+      else
+      {
+        q = fa / fc;
+        r = fb / fc;
+        p = s * (2.0 * m * q * (q - r) - (b - a) * (r - 1.0));
+        q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+      }
+      if (p > 0) q = -q;
+      else p = -p;
+      if (2.0 * p < fmin (3.0 * m * q - fabs (tol * q), fabs (e * q)))
+      {
+        e = d;
+        d = p / q;
+      }
+      else
+      {
+        d = m;
+        e = m;
       }
     }
-  } 
-}
+    else
+    {
+      d = m;
+      e = m;
+    }
 
- 
+    a = b;
+    fa = fb;
+    if (fabs (d) > tol)
+      b += d;
+    else
+      b += (m > 0 ? tol : -tol);
+    fb = f (b, data);
+    if (nevals) (*nevals)++;
+  }
+  return b;
+}
 
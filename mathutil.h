@@ -11,12 +11,9 @@ void mathutil_get_maxima (double *x, double *y, int npoints, double *mins,
 void mathutil_get_minima (double *x, double *y, int npoints, double *mins,
   int maxmins, int *nmins);
 
-void mathutil_get_positive_axis_crossings (double *x, double *y, 
-  int npoints, double *mins, int maxmins, int *nmins);
-
-void mathutil_get_negative_axis_crossings (double *x, double *y, 
-  int npoints, double *mins, int maxmins, int *nmins);
-
  
  
 
+double mathutil_find_root (double (*f)(double x, void *data), void *data,
+  double a, double b, double fa, double fb, double tolerance, int *nevals);
+
@@ -12,10 +12,12 @@ Functions for finding moonrise, moonset, etc
 #include "timeutil.h" 
 #include "trigutil.h" 
 #include "roundutil.h" 
-#include "mathutil.h" 
+#include "mathutil.h"
+#include "ephemeris.h" 
+#include "riseset.h"
 
 
-static double DegRad = M_PI / 180.0;
+static const double DegRad = M_PI / 180.0;
 
 const double MoonTimes_epoch  = 2444238.5;
 
@@ -44,54 +46,54 @@ const double MoonTimes_sunangsiz = 0.533128;
 /*
 * Moon mean longitude at epoch
 */
-double MoonTimes_mmlong = 64.975464;
+const double MoonTimes_mmlong = 64.975464;
 /*
 * Mean longitude of the perigee at the epoch
 */
-double MoonTimes_mmlongp = 349.383063;
+const double MoonTimes_mmlongp = 349.383063;
 /*
 * Mean longitude of the node at the epoch
 */
-double MoonTimes_mlnode = 151.950429;
+const double MoonTimes_mlnode = 151.950429;
 /*
 * Inclination of the Moon's orbit
 */
-double MoonTimes_minc = 5.145396;
+const double MoonTimes_minc = 5.145396;
 /*
 * Eccentricity of the Moon's orbit
 */
-double MoonTimes_mecc = 0.054900;
+const double MoonTimes_mecc = 0.054900;
 /*
 * Moon's angular size at distance a from Earth
 */
-double MoonTimes_mangsiz = 0.5181;
+const double MoonTimes_mangsiz = 0.5181;
 /*
 * Semi-major axis of Moon's orbit in km
 */
-double MoonTimes_msmax = 384401.0;
+const double MoonTimes_msmax = 384401.0;
 /*
 * Parallax at distance a from Earth
 */
-double MoonTimes_mparallax = 0.9507;
+const double MoonTimes_mparallax = 0.9507;
 /*
 * Synodic month (new Moon to new Moon)
 */
-double MoonTimes_synmonth = 29.53058868;
+const double MoonTimes_synmonth = 29.53058868;
 /*
 * Base date for E. W. Brown's numbered series of lunations
 */
-double MoonTimes_moonRad = 1737.4;
-double MoonTimes_lunatbase = 2423436.0;
+const double MoonTimes_moonRad = 1737.4;
+const double MoonTimes_lunatbase = 2423436.0;
 /*
 * Properties of the Earth
 * Radius of Earth in kilometres
 */
-double MoonTimes_earthrad = 6378.16;
+const double MoonTimes_earthrad = 6378.16;
 
 /*
 * Limiting parameter for the Kepler equation.
 */
-double MoonTimes_kEpsilon = 1.0e-6;
+const double MoonTimes_kEpsilon = 1.0e-6;
 
 
 static double kepler (double m, double ecc)
@@ -148,6 +150,17 @@ void MoonTimes_get_moon_state_jd (double jd, double *phase, double *age,
 }
 
 
+/*=======================================================================
+MoonTimes_get_lunar_ephemeris
+The standard tier: the moon's RA (hours) and declination (degrees) at
+the specified MJD, from a series of twenty-one terms (Montenbruck and
+Pfleger's MiniMoon). Over 1900-2100 it is within 0.11 degrees of the
+high tier in RA (measured on the sky) and 0.05 degrees in 
+declination. At latitudes up to 60 degrees, that puts moonrise and 
+moonset within 45 seconds of the high tier's, and about 5 seconds 
+from it on average. This is the series the ephemeris cache and files
+hold, and the one the sine altitude functions below use
+=======================================================================*/
 void MoonTimes_get_lunar_ephemeris (double mjd, double *_ra, double *_dec)
 {
   const double CosEPS = 0.91748;
@@ -187,7 +200,63 @@ void MoonTimes_get_lunar_ephemeris (double mjd, double *_ra, double *_dec)
   double Z = SinEPS * V + CosEPS * W;
   double RHO = sqrt(1.0 - Z*Z);
   double dec = (360.0 / P2) * atan(Z / RHO);
-  double ra = (48.0 / P2) * atan(Y / (X + RHO));
+  // Not the half-angle form, atan(Y / (X + RHO)): CosEPS and SinEPS
+  //  are rounded, so X + RHO can come out slightly negative when the
+  //  RA is near 12h, and the result jumps by minutes of RA
+  double ra = (24.0 / P2) * atan2(Y, X);
+
+  if (ra < 0) ra += 24 ;
+
+  *_ra = ra;
+  *_dec = dec;
+}
+
+
+/*=======================================================================
+MoonTimes_get_lunar_ephemeris_fast
+The fast tier. The same series as MoonTimes_get_lunar_ephemeris, cut
+down to the six largest terms in longitude and the one largest in 
+latitude, so it needs eight sines rather than twenty-two, and takes
+a little over half the time. Over 1900-2100 it is within 0.4 degrees
+of the high tier in RA (measured on the sky) and 0.3 degrees in 
+declination. At latitudes up to 60 degrees, that puts moonrise and 
+moonset within five minutes of the high tier's, and about 35 seconds
+from it on average
+=======================================================================*/
+void MoonTimes_get_lunar_ephemeris_fast (double mjd, double *_ra, 
+    double *_dec)
+{
+  const double CosEPS = 0.91748;
+  const double SinEPS = 0.39778;
+  const double ARC = 206264.8062;
+
+  const double P2 = M_PI * 2.0;
+  const double JD = mjd + 2400000.5; 
+  double t = (JD - 2451545.0)/36525.0;
+
+  double L0 = roundutil_pascalFrac(0.606433 + 1336.855225 * t); 
+  double L = P2 * roundutil_pascalFrac(0.374897 + 1325.552410 * t);
+  double LS = P2 * roundutil_pascalFrac(0.993133 + 99.997361 * t);
+  double D = P2 * roundutil_pascalFrac(0.827361 + 1236.853086 * t);
+  double F = P2 * roundutil_pascalFrac(0.259086 + 1342.227825 * t);
+
+  double sinLS = sin(LS), sin2F = sin(2*F);
+  double DL =  22640 * sin(L)  -4586 * sin(L - 2*D) +2370 * sin(2*D);
+  DL +=  +769 * sin(2*L)  -668 * sinLS -412 * sin2F;
+
+  double S = F + (DL + 412 * sin2F + 541* sinLS) / ARC;
+
+  double L_moon = P2 * roundutil_pascalFrac(L0 + DL / 1296000);
+  double B_moon = 18520.0 * sin(S) / ARC;
+  double CB = cos(B_moon);
+  double X = CB * cos(L_moon);
+  double V = CB * sin(L_moon);
+  double W = sin(B_moon);
+  double Y = CosEPS * V - SinEPS * W;
+  double Z = SinEPS * V + CosEPS * W;
+  double RHO = sqrt(1.0 - Z*Z);
+  double dec = (360.0 / P2) * atan(Z / RHO);
+  double ra = (24.0 / P2) * atan2(Y, X);
 
   if (ra < 0) ra += 24 ;
 
@@ -196,18 +265,596 @@ void MoonTimes_get_lunar_ephemeris (double mjd, double *_ra, double *_dec)
 }
 
 
+/*=======================================================================
+MoonTimes_get_lunar_ephemeris_high
+The high tier: the truncated ELP-2000/82 series given by Meeus 
+(Astronomical Algorithms, chapter 47), with sixty periodic terms each
+in longitude and latitude, corrected for nutation, and evaluated in 
+dynamical time, by way of timeutil_delta_t(). Meeus gives its 
+accuracy as 10" in longitude and 4" in latitude, which is about a 
+second of moonrise time. The arguments of the terms are built up 
+from the sines and cosines of the multiples of D, M, M', and F, which
+are found by the angle-addition formulae, so the whole series needs 
+only a dozen or so calls to sin and cos. Even so, it takes three to 
+four times as long as the standard tier
+=======================================================================*/
+
+// Multiples of D, M, M', and F in each term, with the coefficient of
+//  the sine of the argument in longitude, in 1e-6 degrees (Meeus table 
+//  47.A, without the terms in distance, which isn't needed)
+static const signed char moontimes_elp_lr_args [60][4] = 
+  {
+  {0, 0, 1, 0}, {2, 0,-1, 0}, {2, 0, 0, 0}, {0, 0, 2, 0},
+  {0, 1, 0, 0}, {0, 0, 0, 2}, {2, 0,-2, 0}, {2,-1,-1, 0},
+  {2, 0, 1, 0}, {2,-1, 0, 0}, {0, 1,-1, 0}, {1, 0, 0, 0},
+  {0, 1, 1, 0}, {2, 0, 0,-2}, {0, 0, 1, 2}, {0, 0, 1,-2},
+  {4, 0,-1, 0}, {0, 0, 3, 0}, {4, 0,-2, 0}, {2, 1,-1, 0},
+  {2, 1, 0, 0}, {1, 0,-1, 0}, {1, 1, 0, 0}, {2,-1, 1, 0},
+  {2, 0, 2, 0}, {4, 0, 0, 0}, {2, 0,-3, 0}, {0, 1,-2, 0},
+  {2, 0,-1, 2}, {2,-1,-2, 0}, {1, 0, 1, 0}, {2,-2, 0, 0},
+  {0, 1, 2, 0}, {0, 2, 0, 0}, {2,-2,-1, 0}, {2, 0, 1,-2},
+  {2, 0, 0, 2}, {4,-1,-1, 0}, {0, 0, 2, 2}, {3, 0,-1, 0},
+  {2, 1, 1, 0}, {4,-1,-2, 0}, {0, 2,-1, 0}, {2, 2,-1, 0},
+  {2, 1,-2, 0}, {2,-1, 0,-2}, {4, 0, 1, 0}, {0, 0, 4, 0},
+  {4,-1, 0, 0}, {1, 0,-2, 0}, {2, 1, 0,-2}, {0, 0, 2,-2},
+  {1, 1, 1, 0}, {3, 0,-2, 0}, {4, 0,-3, 0}, {2,-1, 2, 0},
+  {0, 2, 1, 0}, {1, 1,-1, 0}, {2, 0, 3, 0}, {2, 0,-1,-2}
+  };
+
+static const int moontimes_elp_l [60] = 
+  {
+  6288774, 1274027, 658314, 213618, -185116, -114332, 58793, 57066,
+  53322, 45758, -40923, -34720, -30383, 15327, -12528, 10980,
+  10675, 10034, 8548, -7888, -6766, -5163, 4987, 4036,
+  3994, 3861, 3665, -2689, -2602, 2390, -2348, 2236,
+  -2120, -2069, 2048, -1773, -1595, 1215, -1110, -892,
+  -810, 759, -713, -700, 691, 596, 549, 537,
+  520, -487, -399, -381, 351, -340, 330, 327,
+  -323, 299, 294, 0
+  };
+
+// The same for latitude, in 1e-6 degrees (Meeus table 47.B)
+static const signed char moontimes_elp_b_args [60][4] = 
+  {
+  {0, 0, 0, 1}, {0, 0, 1, 1}, {0, 0, 1,-1}, {2, 0, 0,-1},
+  {2, 0,-1, 1}, {2, 0,-1,-1}, {2, 0, 0, 1}, {0, 0, 2, 1},
+  {2, 0, 1,-1}, {0, 0, 2,-1}, {2,-1, 0,-1}, {2, 0,-2,-1},
+  {2, 0, 1, 1}, {2, 1, 0,-1}, {2,-1,-1, 1}, {2,-1, 0, 1},
+  {2,-1,-1,-1}, {0, 1,-1,-1}, {4, 0,-1,-1}, {0, 1, 0, 1},
+  {0, 0, 0, 3}, {0, 1,-1, 1}, {1, 0, 0, 1}, {0, 1, 1, 1},
+  {0, 1, 1,-1}, {0, 1, 0,-1}, {1, 0, 0,-1}, {0, 0, 3, 1},
+  {4, 0, 0,-1}, {4, 0,-1, 1}, {0, 0, 1,-3}, {4, 0,-2, 1},
+  {2, 0, 0,-3}, {2, 0, 2,-1}, {2,-1, 1,-1}, {2, 0,-2, 1},
+  {0, 0, 3,-1}, {2, 0, 2, 1}, {2, 0,-3,-1}, {2, 1,-1, 1},
+  {2, 1, 0, 1}, {4, 0, 0, 1}, {2,-1, 1, 1}, {2,-2, 0,-1},
+  {0, 0, 1, 3}, {2, 1, 1,-1}, {1, 1, 0,-1}, {1, 1, 0, 1},
+  {0, 1,-2,-1}, {2, 1,-1,-1}, {1, 0, 1, 1}, {2,-1,-2,-1},
+  {0, 1, 2, 1}, {4, 0,-2,-1}, {4,-1,-1,-1}, {1, 0, 1,-1},
+  {4, 0, 1,-1}, {1, 0,-1,-1}, {4,-1, 0,-1}, {2,-2, 0, 1}
+  };
+
+static const int moontimes_elp_b [60] = 
+  {
+  5128122, 280602, 277693, 173237, 55413, 46271, 32573, 17198,
+  9266, 8822, 8216, 4324, 4200, -3359, 2463, 2211,
+  2065, -1870, 1828, -1794, -1749, -1565, -1491, -1475,
+  -1410, -1344, -1335, 1107, 1021, 833, 777, 671,
+  607, 596, 491, -451, 439, 422, 421, -366,
+  -351, 331, 315, 302, -283, -229, 223, 223,
+  -220, -220, -185, 181, -177, 176, 166, -164,
+  132, -119, 115, 107
+  };
+
+// No argument has a multiple of more than four
+#define MOONTIMES_ELP_MAX_MULTIPLE 4
+
+/* Set s[k] and c[k] to the sine and cosine of k * x degrees, for k from 
+   -MOONTIMES_ELP_MAX_MULTIPLE to MOONTIMES_ELP_MAX_MULTIPLE, which are
+   stored offset by MOONTIMES_ELP_MAX_MULTIPLE */
+static void moontimes_elp_multiples (double x, double *s, double *c)
+{
+  const int m = MOONTIMES_ELP_MAX_MULTIPLE;
+  int k;
+  s[m] = 0; c[m] = 1;
+  sincosDeg (x, &s[m + 1], &c[m + 1]);
+  for (k = 2; k <= m; k++)
+    {
+    s[m + k] = s[m + k - 1] * c[m + 1] + c[m + k - 1] * s[m + 1];
+    c[m + k] = c[m + k - 1] * c[m + 1] - s[m + k - 1] * s[m + 1];
+    }
+  for (k = 1; k <= m; k++)
+    {
+    s[m - k] = -s[m + k];
+    c[m - k] = c[m + k];
+    }
+}
+
+/* The sine and cosine of the argument of a term, from the multiples
+   of each fundamental argument. The terms in M are scaled by E, for 
+   the decreasing eccentricity of the Earth's orbit */
+static void moontimes_elp_term (const signed char *args, 
+    double s[4][2 * MOONTIMES_ELP_MAX_MULTIPLE + 1], 
+    double c[4][2 * MOONTIMES_ELP_MAX_MULTIPLE + 1], 
+    double E, double *sin_arg, double *cos_arg)
+{
+  const int m = MOONTIMES_ELP_MAX_MULTIPLE;
+  double sa = s[0][m + args[0]], ca = c[0][m + args[0]];
+  int j;
+  for (j = 1; j < 4; j++)
+    {
+    double sj = s[j][m + args[j]], cj = c[j][m + args[j]];
+    double next = sa * cj + ca * sj;
+    ca = ca * cj - sa * sj;
+    sa = next;
+    }
+  if (args[1] != 0)
+    {
+    double e = (args[1] == 1 || args[1] == -1) ? E : E * E;
+    sa *= e;
+    ca *= e;
+    }
+  *sin_arg = sa;
+  *cos_arg = ca;
+}
+
+void MoonTimes_get_lunar_ephemeris_high (double mjd, double *_ra, 
+    double *_dec)
+{
+  const int m = MOONTIMES_ELP_MAX_MULTIPLE;
+  double JD = mjd + 2400000.5;
+  double T = (JD + timeutil_delta_t (JD) / 86400.0 - 2451545.0) 
+    / 36525.0;
+  double T2 = T * T, T3 = T2 * T, T4 = T3 * T;
+
+  // Fundamental arguments, in degrees
+  double Lp = 218.3164477 + 481267.88123421 * T - 0.0015786 * T2 
+    + T3 / 538841 - T4 / 65194000;
+  double D = 297.8501921 + 445267.1114034 * T - 0.0018819 * T2 
+    + T3 / 545868 - T4 / 113065000;
+  double M = 357.5291092 + 35999.0502909 * T - 0.0001536 * T2 
+    + T3 / 24490000;
+  double Mp = 134.9633964 + 477198.8675055 * T + 0.0087414 * T2 
+    + T3 / 69699 - T4 / 14712000;
+  double F = 93.2720950 + 483202.0175233 * T - 0.0036539 * T2 
+    - T3 / 3526000 + T4 / 863310000;
+  double A1 = 119.75 + 131.849 * T;
+  double A2 = 53.09 + 479264.290 * T;
+  double A3 = 313.45 + 481266.484 * T;
+  double E = 1 - 0.002516 * T - 0.0000074 * T2;
+  Lp = fixAngle (Lp);
+
+  double s[4][2 * MOONTIMES_ELP_MAX_MULTIPLE + 1];
+  double c[4][2 * MOONTIMES_ELP_MAX_MULTIPLE + 1];
+  moontimes_elp_multiples (fixAngle (D), s[0], c[0]);
+  moontimes_elp_multiples (fixAngle (M), s[1], c[1]);
+  moontimes_elp_multiples (fixAngle (Mp), s[2], c[2]);
+  moontimes_elp_multiples (fixAngle (F), s[3], c[3]);
+
+  double sum_l = 0, sum_b = 0;
+  int i;
+  for (i = 0; i < 60; i++)
+    {
+    double sa, ca;
+    moontimes_elp_term (moontimes_elp_lr_args[i], s, c, E, &sa, &ca);
+    sum_l += moontimes_elp_l[i] * sa;
+    moontimes_elp_term (moontimes_elp_b_args[i], s, c, E, &sa, &ca);
+    sum_b += moontimes_elp_b[i] * sa;
+    }
+
+  // Additive terms for the action of Venus and Jupiter, and the 
+  //  flattening of the Earth. sin (L' - F), sin (L' - M') and 
+  //  sin (L' + M') are built from sin L' and the multiples
+  double sinLp, cosLp;
+  sincosDeg (Lp, &sinLp, &cosLp);
+  double sF = s[3][m + 1], cF = c[3][m + 1];
+  double sMp = s[2][m + 1], cMp = c[2][m + 1];
+  double sinA1, cosA1;
+  sincosDeg (A1, &sinA1, &cosA1);
+  sum_l += 3958 * sinA1 + 1962 * (sinLp * cF - cosLp * sF) 
+    + 318 * sinDeg (A2);
+  sum_b += -2235 * sinLp + 382 * sinDeg (A3) 
+    + 350 * sinA1 * cF // sin (A1 - F) + sin (A1 + F)
+    + 127 * (sinLp * cMp - cosLp * sMp) - 115 * (sinLp * cMp + cosLp * sMp);
+
+  // Nutation in longitude and obliquity, to about 0.5" (Meeus 
+  //  chapter 22), and the mean obliquity of the ecliptic
+  double omega = 125.04452 - 1934.136261 * T;
+  double Ls = 280.4665 + 36000.7698 * T;
+  double sinOm, cosOm;
+  sincosDeg (omega, &sinOm, &cosOm);
+  double sin2Ls, cos2Ls, sin2Lp, cos2Lp;
+  sincosDeg (2 * Ls, &sin2Ls, &cos2Ls);
+  sin2Lp = 2 * sinLp * cosLp;
+  cos2Lp = cosLp * cosLp - sinLp * sinLp;
+  double sin2Om = 2 * sinOm * cosOm, cos2Om = cosOm * cosOm - sinOm * sinOm;
+  double dpsi = -17.20 * sinOm - 1.32 * sin2Ls - 0.23 * sin2Lp 
+    + 0.21 * sin2Om;
+  double deps = 9.20 * cosOm + 0.57 * cos2Ls + 0.10 * cos2Lp 
+    - 0.09 * cos2Om;
+  double eps = 23.4392911 + (-46.8150 * T - 0.00059 * T2 + 0.001813 * T3 
+    + deps) / 3600.0;
+
+  double lambda = Lp + sum_l / 1e6 + dpsi / 3600.0;
+  double beta = sum_b / 1e6;
+
+  double sinLambda, cosLambda, sinBeta, cosBeta, sinEps, cosEps;
+  sincosDeg (lambda, &sinLambda, &cosLambda);
+  sincosDeg (beta, &sinBeta, &cosBeta);
+  sincosDeg (eps, &sinEps, &cosEps);
+  double X = cosBeta * cosLambda;
+  double V = cosBeta * sinLambda;
+  double Y = cosEps * V - sinEps * sinBeta;
+  double Z = sinEps * V + cosEps * sinBeta;
+  double RHO = sqrt (1.0 - Z * Z);
+  double dec = (180.0 / M_PI) * atan2 (Z, RHO);
+  double ra = (12.0 / M_PI) * atan2 (Y, X);
+  if (ra < 0) ra += 24;
+
+  *_ra = ra;
+  *_dec = dec;
+}
+
+
+/*=======================================================================
+MoonTimes_get_precision_name
+=======================================================================*/
+const char *MoonTimes_get_precision_name (MoonTimesPrecision precision)
+{
+  switch (precision)
+    {
+    case MOONTIMES_PRECISION_FAST: return "fast";
+    case MOONTIMES_PRECISION_HIGH: return "high";
+    default: return "standard";
+    }
+}
+
+
+/*=======================================================================
+MoonTimes_parse_precision
+Set *precision to the tier named by 'name', as given by 
+MoonTimes_get_precision_name, and return TRUE, or return FALSE if
+there is no such tier
+=======================================================================*/
+BOOL MoonTimes_parse_precision (const char *name, 
+    MoonTimesPrecision *precision)
+{
+  MoonTimesPrecision p;
+  for (p = MOONTIMES_PRECISION_FAST; p <= MOONTIMES_PRECISION_HIGH; p++)
+    {
+    if (strcmp (name, MoonTimes_get_precision_name (p)) == 0)
+      {
+      *precision = p;
+      return TRUE;
+      }
+    }
+  return FALSE;
+}
+
+
+/*=======================================================================
+MoonTimes_get_lunar_ephemeris_array
+Does the same as MoonTimes_get_lunar_ephemeris for each of n dates,
+but evaluates the periodic terms for a block of dates at a time using
+sinArray(), so the sines can be worked out in parallel. The results
+agree with MoonTimes_get_lunar_ephemeris to within 1e-8 hours of RA
+and 1e-12 degrees of declination
+=======================================================================*/
+#define MOONTIMES_BLOCK 32
+#define MOONTIMES_TERMS 21
+
+void MoonTimes_get_lunar_ephemeris_array (const double *mjd, int n, 
+    double *_ra, double *_dec)
+{
+  const double CosEPS = 0.91748;
+  const double SinEPS = 0.39778;
+  const double ARC = 206264.8062;
+  const double P2 = M_PI * 2.0;
+
+  double L0[MOONTIMES_BLOCK], L[MOONTIMES_BLOCK], LS[MOONTIMES_BLOCK];
+  double D[MOONTIMES_BLOCK], F[MOONTIMES_BLOCK];
+  double arg[MOONTIMES_TERMS][MOONTIMES_BLOCK];
+  double sn[MOONTIMES_TERMS][MOONTIMES_BLOCK];
+  double L_moon[MOONTIMES_BLOCK], B_moon[MOONTIMES_BLOCK];
+  double sinL[MOONTIMES_BLOCK], cosL[MOONTIMES_BLOCK];
+  double sinB[MOONTIMES_BLOCK], cosB[MOONTIMES_BLOCK];
+
+  int start;
+  for (start = 0; start < n; start += MOONTIMES_BLOCK)
+    {
+    int i, m = n - start;
+    if (m > MOONTIMES_BLOCK) m = MOONTIMES_BLOCK;
+
+    for (i = 0; i < m; i++)
+      {
+      double JD = mjd[start + i] + 2400000.5; 
+      double t = (JD - 2451545.0)/36525.0;
+      L0[i] = roundutil_pascalFrac(0.606433 + 1336.855225 * t); 
+      L[i] = P2 * roundutil_pascalFrac(0.374897 + 1325.552410 * t);
+      LS[i] = P2 * roundutil_pascalFrac(0.993133 + 99.997361 * t);
+      D[i] = P2 * roundutil_pascalFrac(0.827361 + 1236.853086 * t);
+      F[i] = P2 * roundutil_pascalFrac(0.259086 + 1342.227825 * t);
+      double H = F[i] - 2*D[i];
+
+      arg[0][i] = L[i];
+      arg[1][i] = L[i] - 2*D[i];
+      arg[2][i] = 2*D[i];
+      arg[3][i] = 2*L[i];
+      arg[4][i] = LS[i];
+      arg[5][i] = 2*F[i];
+      arg[6][i] = 2*L[i] - 2*D[i];
+      arg[7][i] = L[i] + LS[i] - 2*D[i];
+      arg[8][i] = L[i] + 2*D[i];
+      arg[9][i] = LS[i] - 2*D[i];
+      arg[10][i] = D[i];
+      arg[11][i] = L[i] + LS[i];
+      arg[12][i] = L[i] - LS[i];
+      arg[13][i] = 2*F[i] - 2*D[i];
+      arg[14][i] = H;
+      arg[15][i] = L[i] + H;
+      arg[16][i] = -L[i] + H;
+      arg[17][i] = LS[i] + H;
+      arg[18][i] = -LS[i] + H;
+      arg[19][i] = -2*L[i] + F[i];
+      arg[20][i] = -L[i] + F[i];
+      }
+
+    for (i = 0; i < MOONTIMES_TERMS; i++)
+      sinArray (arg[i], sn[i], m);
+
+    for (i = 0; i < m; i++)
+      {
+      double DL =  22640 * sn[0][i]  -4586 * sn[1][i] +2370 * sn[2][i];
+      DL +=  +769 * sn[3][i]  -668 * sn[4][i] -412 * sn[5][i];
+      DL +=  -212 * sn[6][i] -206 * sn[7][i];
+      DL +=  +192 * sn[8][i] -165 * sn[9][i];
+      DL +=  -125 * sn[10][i] -110 * sn[11][i] +148 * sn[12][i];
+      DL +=   -55 * sn[13][i];
+
+      double S = F[i] + (DL + 412 * sn[5][i] + 541* sn[4][i]) / ARC;
+      double N =   -526 * sn[14][i]+44 * sn[15][i] -31 * sn[16][i];
+      N +=   -23 * sn[17][i] +11 * sn[18][i] -25 * sn[19][i];
+      N +=   +21 * sn[20][i];
+
+      L_moon[i] = P2 * roundutil_pascalFrac(L0[i] + DL / 1296000);
+      // arg[0] is no longer needed, so use it for S
+      arg[0][i] = S;
+      B_moon[i] = N;
+      }
+
+    sinArray (arg[0], arg[0], m);
+    for (i = 0; i < m; i++)
+      B_moon[i] = (18520.0 * arg[0][i] + B_moon[i]) /ARC;
+
+    sinArray (L_moon, sinL, m);
+    cosArray (L_moon, cosL, m);
+    sinArray (B_moon, sinB, m);
+    cosArray (B_moon, cosB, m);
+
+    for (i = 0; i < m; i++)
+      {
+      double CB = cosB[i];
+      double X = CB * cosL[i];
+      double V = CB * sinL[i];
+      double W = sinB[i];
+      double Y = CosEPS * V - SinEPS * W;
+      double Z = SinEPS * V + CosEPS * W;
+      double RHO = sqrt(1.0 - Z*Z);
+      double dec = (360.0 / P2) * atan(Z / RHO);
+      double ra = (24.0 / P2) * atan2(Y, X);
+
+      if (ra < 0) ra += 24 ;
+
+      _ra[start + i] = ra;
+      _dec[start + i] = dec;
+      }
+    }
+}
+
+
+/*=======================================================================
+MoonTimes_get_sin_altitude_array
+Does the same as MoonTimes_getSinAltitude for each of n dates. It is
+the reference that tests/test_grid.c checks 
+MoonTimes_get_sin_altitude_grid against
+=======================================================================*/
+void MoonTimes_get_sin_altitude_array (const Observer *observer,
+    const double *mjd, int n, double *result)
+{
+  double ra[MOONTIMES_BLOCK], dec[MOONTIMES_BLOCK], tau[MOONTIMES_BLOCK];
+  double sinDec[MOONTIMES_BLOCK], cosDec[MOONTIMES_BLOCK];
+
+  int start;
+  for (start = 0; start < n; start += MOONTIMES_BLOCK)
+    {
+    int i, m = n - start;
+    if (m > MOONTIMES_BLOCK) m = MOONTIMES_BLOCK;
+
+    MoonTimes_get_lunar_ephemeris_array (mjd + start, m, ra, dec);
+    for (i = 0; i < m; i++)
+      {
+      tau[i] = 15.0 * (timeutil_lmst_hours (mjd[start + i], 
+        observer->longitude_hours) - ra[i]) * DegRad;
+      dec[i] *= DegRad;
+      }
+    sinArray (dec, sinDec, m);
+    cosArray (dec, cosDec, m);
+    cosArray (tau, tau, m);
+    for (i = 0; i < m; i++)
+      result[start + i] = observer->sin_latitude * sinDec[i] 
+        + observer->cos_latitude * cosDec[i] * tau[i];
+    }
+}
+
+
+/*=======================================================================
+MoonTimes_get_sin_altitude_grid
+Does the same as MoonTimes_get_sin_altitude_array for the n dates
+mjd0, mjd0 + step, mjd0 + 2 * step... On a grid like this, the
+fundamental arguments L, LS, D, and F, and so the argument of each
+periodic term, advance by the same angle at every step. So the sine
+and cosine of each term are carried from one date to the next by the 
+angle-addition formulae, at the cost of four multiplications, rather
+than worked out afresh. They are worked out afresh at the start of each
+block of MOONTIMES_BLOCK dates, so rounding errors can't build up. The
+sidereal time is stepped in the same way, by timeutil_lmst_grid(), and
+the hour angle is taken from the moon's direction cosines, so there 
+is no inverse trig. The results agree with 
+MoonTimes_get_sin_altitude_array to within 1e-9 for steps of up to
+half an hour, and 1e-8 for steps of a few hours, as 
+timeutil_lmst_grid() does
+=======================================================================*/
+
+// The multiples of L, LS, D, and F in the argument of each term of
+//  MoonTimes_get_lunar_ephemeris_array, in the same order
+static const signed char moontimes_term_args [MOONTIMES_TERMS][4] = 
+  {
+  { 1,  0,  0,  0}, { 1,  0, -2,  0}, { 0,  0,  2,  0}, { 2,  0,  0,  0},
+  { 0,  1,  0,  0}, { 0,  0,  0,  2}, { 2,  0, -2,  0}, { 1,  1, -2,  0},
+  { 1,  0,  2,  0}, { 0,  1, -2,  0}, { 0,  0,  1,  0}, { 1,  1,  0,  0},
+  { 1, -1,  0,  0}, { 0,  0, -2,  2}, { 0,  0, -2,  1}, { 1,  0, -2,  1},
+  {-1,  0, -2,  1}, { 0,  1, -2,  1}, { 0, -1, -2,  1}, {-2,  0,  0,  1},
+  {-1,  0,  0,  1}
+  };
+
+static void moontimes_term_args_at (const double *fundamental, double *arg)
+{
+  int i;
+  for (i = 0; i < MOONTIMES_TERMS; i++)
+    arg[i] = moontimes_term_args[i][0] * fundamental[0]
+      + moontimes_term_args[i][1] * fundamental[1]
+      + moontimes_term_args[i][2] * fundamental[2]
+      + moontimes_term_args[i][3] * fundamental[3];
+}
+
+void MoonTimes_get_sin_altitude_grid (const Observer *observer,
+    double mjd0, double step, int n, double *result)
+{
+  const double CosEPS = 0.91748;
+  const double SinEPS = 0.39778;
+  const double ARC = 206264.8062;
+  const double P2 = M_PI * 2.0;
+
+  double fundamental[4], arg[MOONTIMES_TERMS];
+  double s[MOONTIMES_TERMS], c[MOONTIMES_TERMS];
+  double sinStep[MOONTIMES_TERMS], cosStep[MOONTIMES_TERMS];
+  double sn[MOONTIMES_BLOCK][MOONTIMES_TERMS];
+  double L_moon[MOONTIMES_BLOCK], B_moon[MOONTIMES_BLOCK];
+  double S[MOONTIMES_BLOCK], sinS[MOONTIMES_BLOCK];
+  double sinL[MOONTIMES_BLOCK], cosL[MOONTIMES_BLOCK];
+  double sinB[MOONTIMES_BLOCK], cosB[MOONTIMES_BLOCK];
+  double lmst[MOONTIMES_BLOCK], sinLmst[MOONTIMES_BLOCK];
+  double cosLmst[MOONTIMES_BLOCK];
+
+  // The angle by which each term advances at each step
+  double t_step = step / 36525.0;
+  fundamental[0] = P2 * roundutil_pascalFrac (1325.552410 * t_step);
+  fundamental[1] = P2 * roundutil_pascalFrac (99.997361 * t_step);
+  fundamental[2] = P2 * roundutil_pascalFrac (1236.853086 * t_step);
+  fundamental[3] = P2 * roundutil_pascalFrac (1342.227825 * t_step);
+  moontimes_term_args_at (fundamental, arg);
+  sinArray (arg, sinStep, MOONTIMES_TERMS);
+  cosArray (arg, cosStep, MOONTIMES_TERMS);
+
+  int start;
+  for (start = 0; start < n; start += MOONTIMES_BLOCK)
+    {
+    int i, j, m = n - start;
+    if (m > MOONTIMES_BLOCK) m = MOONTIMES_BLOCK;
+
+    double t0 = (mjd0 + start * step + 2400000.5 - 2451545.0) / 36525.0;
+    fundamental[0] = P2 * roundutil_pascalFrac(0.374897 + 1325.552410 * t0);
+    fundamental[1] = P2 * roundutil_pascalFrac(0.993133 + 99.997361 * t0);
+    fundamental[2] = P2 * roundutil_pascalFrac(0.827361 + 1236.853086 * t0);
+    fundamental[3] = P2 * roundutil_pascalFrac(0.259086 + 1342.227825 * t0);
+    moontimes_term_args_at (fundamental, arg);
+    sinArray (arg, s, MOONTIMES_TERMS);
+    cosArray (arg, c, MOONTIMES_TERMS);
+
+    for (i = 0; i < m; i++)
+      {
+      for (j = 0; j < MOONTIMES_TERMS; j++)
+        {
+        double next = s[j] * cosStep[j] + c[j] * sinStep[j];
+        c[j] = c[j] * cosStep[j] - s[j] * sinStep[j];
+        sn[i][j] = s[j];
+        s[j] = next;
+        }
+      }
+
+    for (i = 0; i < m; i++)
+      {
+      double t = (mjd0 + (start + i) * step + 2400000.5 - 2451545.0) 
+        / 36525.0;
+      double L0 = roundutil_pascalFrac(0.606433 + 1336.855225 * t); 
+      double F = P2 * roundutil_pascalFrac(0.259086 + 1342.227825 * t);
+      const double *x = sn[i];
+
+      double DL =  22640 * x[0]  -4586 * x[1] +2370 * x[2];
+      DL +=  +769 * x[3]  -668 * x[4] -412 * x[5];
+      DL +=  -212 * x[6] -206 * x[7];
+      DL +=  +192 * x[8] -165 * x[9];
+      DL +=  -125 * x[10] -110 * x[11] +148 * x[12];
+      DL +=   -55 * x[13];
+
+      S[i] = F + (DL + 412 * x[5] + 541* x[4]) / ARC;
+      double N =   -526 * x[14]+44 * x[15] -31 * x[16];
+      N +=   -23 * x[17] +11 * x[18] -25 * x[19];
+      N +=   +21 * x[20];
+
+      L_moon[i] = P2 * roundutil_pascalFrac(L0 + DL / 1296000);
+      B_moon[i] = N;
+      }
+
+    sinArray (S, sinS, m);
+    for (i = 0; i < m; i++)
+      B_moon[i] = (18520.0 * sinS[i] + B_moon[i]) /ARC;
+
+    timeutil_lmst_grid (mjd0 + start * step, step, m, 
+      observer->longitude_hours, lmst);
+    for (i = 0; i < m; i++)
+      lmst[i] *= P2 / 24.0;
+
+    sinArray (L_moon, sinL, m);
+    cosArray (L_moon, cosL, m);
+    sinArray (B_moon, sinB, m);
+    cosArray (B_moon, cosB, m);
+    sinArray (lmst, sinLmst, m);
+    cosArray (lmst, cosLmst, m);
+
+    for (i = 0; i < m; i++)
+      {
+      double CB = cosB[i];
+      double X = CB * cosL[i];
+      double V = CB * sinL[i];
+      double W = sinB[i];
+      double Y = CosEPS * V - SinEPS * W;
+      double Z = SinEPS * V + CosEPS * W;
+      // sin(dec) is Z and cos(dec) is RHO, and the RA is the angle
+      //  whose tangent is Y / X, so cos (LMST - RA) follows from the
+      //  sine and cosine of the sidereal time
+      double RHO = sqrt(1.0 - Z*Z);
+      double XY = sqrt(X * X + Y * Y);
+      double cosTau = (cosLmst[i] * X + sinLmst[i] * Y) / XY;
+      result[start + i] = observer->sin_latitude * Z 
+        + observer->cos_latitude * RHO * cosTau;
+      }
+    }
+}
+
+
 /*=======================================================================
 DateTime_getSinAltitude
 =======================================================================*/
-double MoonTimes_getSinAltitude (double longitude, double latitude, double mjd)
+double MoonTimes_getSinAltitude (const Observer *observer, double mjd)
 {
-  double cosLatitude = cosDeg (latitude);
-  double sinLatitude = sinDeg (latitude);
   double ra, dec;
   MoonTimes_get_lunar_ephemeris(mjd, &ra, &dec);
-  double TAU = 15.0 * (timeutil_lmst (mjd, longitude) - ra);
-  double result	= sinLatitude * sinDeg(dec)
-    + cosLatitude * cosDeg(dec) * cosDeg(TAU);
+  double TAU = 15.0 * (timeutil_lmst_hours (mjd, observer->longitude_hours) 
+    - ra);
+  double sinDec, cosDec;
+  sincosDeg (dec, &sinDec, &cosDec);
+  double result	= observer->sin_latitude * sinDec
+    + observer->cos_latitude * cosDec * cosDeg(TAU);
 return result;
 }
 
@@ -243,117 +890,102 @@ void MoonTimes_get_moon_state (const DateTime *date, double *phase,
 
 
 /*=======================================================================
-DateTime_get_moon_rises
-Determines zero or more moonrises withing the specified start and
-end times. Results are written into events[] and *nevents specifies
-the number found. The caller must free the contents of events[], if
-any 
+MoonTimes_get_moon_events
+Determines the moonrises and moonsets within the specified start and 
+end times, to within 'tolerance' seconds, in one pass, with the moon's
+position from the series for 'precision'. Results are written into 
+'events', which must have been initialized, and from which any events
+left over from a previous call are freed. The moon's position is 
+taken from 'cache', which may be NULL
 =======================================================================*/
-void MoonTimes_get_moon_rises (const LatLong *latlong, 
-       DateTime *start, DateTime *end, int interval, 
-       DateTime *events[], int max_events, int *nevents)
-{
-  long seconds_difference = DateTime_seconds_difference (start, end); 
-  int npoints = seconds_difference / interval + 2;
-
-  double *x = (double *) malloc (npoints * sizeof (double));
-  double *y = (double *) malloc (npoints * sizeof (double));
-
-  DateTime *tx = DateTime_clone (start);
-
-  int i;
-  for (i = 0; i < npoints; i++)
+void MoonTimes_get_moon_events (const Observer *observer, 
+       const DateTime *start, const DateTime *end, double tolerance, 
+       MoonTimesPrecision precision, EphemerisCache *cache, 
+       RiseSetEvents *events)
   {
-    double alt = MoonTimes_getSinAltitude 
-      (LatLong_get_longitude (latlong), LatLong_get_latitude (latlong), 
-       DateTime_get_modified_julian_date (tx));
-    x[i] = i * interval;
-    y[i] = alt;
-    DateTime_add_seconds (tx, interval); 
-  }
-
-  // Note that x values are in seconds relative to 00:00 on the day
-  //  in question
-
-  double *d_events = (double *) malloc (max_events * sizeof (double));
-  mathutil_get_positive_axis_crossings (x, y, npoints, d_events, 
-    max_events, nevents);
-
-  for (i = 0; i < *nevents; i++) 
-    { 
-    long offset_from_start = (long) d_events [i]; 
-    events[i] = DateTime_clone (start);
-    DateTime_add_seconds (events[i], offset_from_start); 
+  switch (precision)
+    {
+    case MOONTIMES_PRECISION_FAST:
+      RiseSet_find_moon_fast_events (observer, start, end, 0.0, 
+        tolerance, cache, events);
+      break;
+    case MOONTIMES_PRECISION_HIGH:
+      RiseSet_find_moon_high_events (observer, start, end, 0.0, 
+        tolerance, cache, events);
+      break;
+    default:
+      RiseSet_find_moon_events (observer, start, end, 0.0, tolerance, 
+        cache, events);
     }
-  free (d_events);
-
-  DateTime_free (tx);
-  free (x);
-  free (y);
-}
+  }
 
 
 /*=======================================================================
-DateTime_get_moon_sets
-Determines zero or more moonrises withing the specified start and
-end times. Results are written into events[] and *nevents specifies
-the number found. The caller must free the contents of events[], if
-any 
+MoonTimes_get_moon_times
+As MoonTimes_get_moon_events, but between two Julian dates, with the
+results as Julian dates. Nothing is allocated
 =======================================================================*/
-void MoonTimes_get_moon_sets (const LatLong *latlong, 
-       DateTime *start, DateTime *end, int interval, 
-       DateTime *events[], int max_events, int *nevents)
-{
-  long seconds_difference = DateTime_seconds_difference (start, end); 
-  int npoints = seconds_difference / interval + 1;
-
-  double *x = (double *) malloc (npoints * sizeof (double));
-  double *y = (double *) malloc (npoints * sizeof (double));
-
-  DateTime *tx = DateTime_clone (start);
-
-  int i;
-  for (i = 0; i < npoints; i++)
+void MoonTimes_get_moon_times (const Observer *observer, 
+       double start_jd, double end_jd, double tolerance, 
+       MoonTimesPrecision precision, EphemerisCache *cache, 
+       RiseSetTimes *times)
   {
-    double alt = MoonTimes_getSinAltitude 
-      (LatLong_get_longitude (latlong), LatLong_get_latitude (latlong), 
-       DateTime_get_modified_julian_date (tx));
-    x[i] = i * interval;
-    y[i] = alt;
-    DateTime_add_seconds (tx, interval); 
+  switch (precision)
+    {
+    case MOONTIMES_PRECISION_FAST:
+      RiseSet_find_moon_fast_times (observer, start_jd, end_jd, 0.0, 
+        tolerance, cache, times);
+      break;
+    case MOONTIMES_PRECISION_HIGH:
+      RiseSet_find_moon_high_times (observer, start_jd, end_jd, 0.0, 
+        tolerance, cache, times);
+      break;
+    default:
+      RiseSet_find_moon_times (observer, start_jd, end_jd, 0.0, 
+        tolerance, cache, times);
+    }
   }
 
-  // Note that x values are in seconds relative to 00:00 on the day
-  //  in question
-
-  double *d_events = (double *) malloc (max_events * sizeof (double));
-  mathutil_get_negative_axis_crossings (x, y, npoints, d_events, 
-    max_events, nevents);
 
-  for (i = 0; i < *nevents; i++) 
-    { 
-    long offset_from_start = (long) d_events [i]; 
-    events[i] = DateTime_clone (start);
-    DateTime_add_seconds (events[i], offset_from_start); 
+/*=======================================================================
+MoonTimes_get_times_range
+As MoonTimes_get_moon_times, but for each of ndays days, which start
+at the Julian dates in bounds[], which ends with the start of the day
+after the last. This gives the same results as calling 
+MoonTimes_get_moon_times for each day, but more cheaply, because each
+event is first looked for about 50 minutes later than on the day 
+before. Nothing is allocated
+=======================================================================*/
+void MoonTimes_get_times_range (const Observer *observer, 
+       const double *bounds, int ndays, double tolerance, 
+       MoonTimesPrecision precision, EphemerisCache *cache, 
+       RiseSetTimes *days)
+  {
+  switch (precision)
+    {
+    case MOONTIMES_PRECISION_FAST:
+      RiseSet_find_moon_fast_times_range (observer, bounds, ndays, 0.0, 
+        MOONTIMES_DAILY_DRIFT, tolerance, cache, days);
+      break;
+    case MOONTIMES_PRECISION_HIGH:
+      RiseSet_find_moon_high_times_range (observer, bounds, ndays, 0.0, 
+        MOONTIMES_DAILY_DRIFT, tolerance, cache, days);
+      break;
+    default:
+      RiseSet_find_moon_times_range (observer, bounds, ndays, 0.0, 
+        MOONTIMES_DAILY_DRIFT, tolerance, cache, days);
     }
-  free (d_events);
-
-  DateTime_free (tx);
-  free (x);
-  free (y);
-}
-
+  }
 
 
 /*=======================================================================
 SunTimes_get_SA
 =======================================================================*/
-double MoonTimes_get_SA (const LatLong *latlong, 
+double MoonTimes_get_SA (const Observer *observer, 
     const DateTime *datetime)
   {
   double mjd = DateTime_get_modified_julian_date (datetime);
-  return MoonTimes_getSinAltitude (LatLong_get_longitude (latlong), 
-    LatLong_get_latitude (latlong), mjd);
+  return MoonTimes_getSinAltitude (observer, mjd);
   }
 
 
@@ -6,9 +6,27 @@ moontimes.h
 #pragma once
 
 #include "datetime.h"
-#include "latlong.h"
+#include "observer.h"
+#include "ephemeris.h"
+#include "riseset.h"
 
-extern double MoonTimes_synmonth; 
+// Default precision of moonrise and moonset times, in seconds
+#define MOONTIMES_DEFAULT_TOLERANCE 1.0
+
+// Average time between one moonrise, or moonset, and the next, in 
+//  seconds
+#define MOONTIMES_DAILY_DRIFT (86400.0 + 50 * 60.0)
+
+// Which series gives the moon's position. Each tier's accuracy and 
+//  cost are given with its function in moontimes.c
+typedef enum _MoonTimesPrecision
+  {
+  MOONTIMES_PRECISION_FAST = 0,
+  MOONTIMES_PRECISION_STANDARD,
+  MOONTIMES_PRECISION_HIGH
+  } MoonTimesPrecision;
+
+extern const double MoonTimes_synmonth; 
 
 extern void MoonTimes_get_moon_state_jd (double jd, double *phase, 
   double *age, double *distance);
@@ -16,22 +34,49 @@ extern void MoonTimes_get_moon_state_jd (double jd, double *phase,
 extern void MoonTimes_get_lunar_ephemeris (double mjd, 
   double *ra, double *dec);
 
-extern double MoonTimes_getSinAltitude (double longitude, 
-  double latitude, double mjd);
+void MoonTimes_get_lunar_ephemeris_fast (double mjd, double *ra, 
+  double *dec);
+
+void MoonTimes_get_lunar_ephemeris_high (double mjd, double *ra, 
+  double *dec);
+
+const char *MoonTimes_get_precision_name (MoonTimesPrecision precision);
+
+BOOL MoonTimes_parse_precision (const char *name, 
+  MoonTimesPrecision *precision);
+
+void MoonTimes_get_lunar_ephemeris_array (const double *mjd, int n,
+  double *ra, double *dec);
+
+extern double MoonTimes_getSinAltitude (const Observer *observer, 
+  double mjd);
+
+void MoonTimes_get_sin_altitude_array (const Observer *observer,
+  const double *mjd, int n, double *result);
+
+void MoonTimes_get_sin_altitude_grid (const Observer *observer,
+  double mjd0, double step, int n, double *result);
 
 void MoonTimes_get_moon_state (const DateTime *date, double *phase, 
    double *age, double *distance);
 
 const char *MoonTimes_get_phase_name (double phase);
 
-void MoonTimes_get_moon_rises (const LatLong *latlong, DateTime *start, 
-       DateTime *end, int interval, DateTime *events[], int max_events, 
-       int *nevents);
+void MoonTimes_get_moon_events (const Observer *observer, 
+       const DateTime *start, const DateTime *end, double tolerance, 
+       MoonTimesPrecision precision, EphemerisCache *cache, 
+       RiseSetEvents *events);
+
+void MoonTimes_get_moon_times (const Observer *observer, 
+       double start_jd, double end_jd, double tolerance, 
+       MoonTimesPrecision precision, EphemerisCache *cache, 
+       RiseSetTimes *times);
 
-void MoonTimes_get_moon_sets (const LatLong *latlong, DateTime *start, 
-       DateTime *end, int interval, DateTime *events[], int max_events, 
-       int *nevents);
+void MoonTimes_get_times_range (const Observer *observer, 
+       const double *bounds, int ndays, double tolerance, 
+       MoonTimesPrecision precision, EphemerisCache *cache, 
+       RiseSetTimes *days);
 
-double MoonTimes_get_SA (const LatLong *latlong, 
+double MoonTimes_get_SA (const Observer *observer, 
     const DateTime *datetime);
 
@@ -5,21 +5,125 @@ information from methods in holidays.c and astrodays.c
 (c)2005-2012 Kevin Boone
 =======================================================================*/
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "defs.h"
 #include "datetime.h"
+#include "timeutil.h"
+#include "pointerarray.h"
 #include "astrodays.h"
 #include "holidays.h"
+#include "nameddays.h"
 
 /*=======================================================================
-NamedDays_get_list_for_year 
+nameddays_get_day
+The UTC day number of a time
 =======================================================================*/
-PointerList *NamedDays_get_list_for_year (int year, const char *tz, BOOL utc,
-    BOOL southern)
+static int64_t nameddays_get_day (const DateTime *dt)
   {
-  PointerList *l = NULL;
-  l = Holidays_get_list_for_year (l, year, tz, utc);
-  l = AstroDays_get_list_for_year (l, year, tz, utc, southern);
-  return l;
+  return timeutil_floor_div (DateTime_get_utime (dt), SECONDS_PER_DAY);
+  }
+
+
+/*=======================================================================
+NamedDays_new
+Collect the named days of each year from first_year to last_year, 
+and index them by day. Caller must free with NamedDays_free
+=======================================================================*/
+NamedDays *NamedDays_new (int first_year, int last_year, const char *tz,
+    BOOL utc, BOOL southern)
+  {
+  PointerArray *l = PointerArray_new ();
+  int year;
+  for (year = first_year; year <= last_year; year++)
+    {
+    Holidays_get_list_for_year (l, year, tz, utc);
+    AstroDays_get_list_for_year (l, year, southern);
+    }
+
+  NamedDays *self = (NamedDays *) malloc (sizeof (NamedDays));
+  int n = PointerArray_get_length (l);
+  int i;
+  int64_t first = 0, last = -1;
+  for (i = 0; i < n; i++)
+    {
+    int64_t day = nameddays_get_day (PointerArray_get_pointer (l, i));
+    if (i == 0 || day < first) first = day;
+    if (i == 0 || day > last) last = day;
+    }
+  self->first_day = first;
+  self->ndays = (int)(last - first + 1);
+  self->nevents = n;
+  self->bucket = (int *) calloc (self->ndays + 1, sizeof (int));
+  self->events = (DateTime **) malloc ((n > 0 ? (size_t) n : 1) 
+    * sizeof (DateTime *));
+
+  // A counting sort, which keeps the events of each day in the order
+  //  they were added in. First count the events of each day into the 
+  //  bucket after it, then add up the counts to give where each 
+  //  bucket starts
+  for (i = 0; i < n; i++)
+    self->bucket[nameddays_get_day (PointerArray_get_pointer (l, i)) 
+      - first + 1]++;
+  for (i = 0; i < self->ndays; i++)
+    self->bucket[i + 1] += self->bucket[i];
+  int *next = (int *) malloc ((self->ndays > 0 ? (size_t) self->ndays : 1)
+    * sizeof (int));
+  memcpy (next, self->bucket, self->ndays * sizeof (int));
+  for (i = 0; i < n; i++)
+    {
+    DateTime *event = PointerArray_get_pointer (l, i);
+    self->events[next[nameddays_get_day (event) - first]++] = event;
+    }
+  free (next);
+
+  PointerArray_free (l, FALSE);
+  return self;
+  }
+
+
+/*=======================================================================
+NamedDays_get_day
+Set events to the events of a day, given as a UTC day number, and 
+return how many there are. The events belong to the NamedDays
+=======================================================================*/
+int NamedDays_get_day (const NamedDays *self, int64_t day, 
+    DateTime *const **events)
+  {
+  int64_t i = day - self->first_day;
+  if (i < 0 || i >= self->ndays)
+    {
+    *events = self->events;
+    return 0;
+    }
+  *events = self->events + self->bucket[i];
+  return self->bucket[i + 1] - self->bucket[i];
+  }
+
+
+/*=======================================================================
+NamedDays_get_events_on
+As NamedDays_get_day, for the events on the same day as dt, as 
+DateTime_is_same_day tells it
+=======================================================================*/
+int NamedDays_get_events_on (const NamedDays *self, const DateTime *dt,
+    DateTime *const **events)
+  {
+  return NamedDays_get_day (self, nameddays_get_day (dt), events);
+  }
+
+
+/*=======================================================================
+NamedDays_free
+Free the index and the events in it
+=======================================================================*/
+void NamedDays_free (NamedDays *self)
+  {
+  int i;
+  for (i = 0; i < self->nevents; i++)
+    DateTime_free (self->events[i]);
+  free (self->events);
+  free (self->bucket);
+  free (self);
   }
 
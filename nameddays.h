@@ -4,9 +4,39 @@ nameddays.h
 =======================================================================*/
 #pragma once
 
+#include <stdint.h>
 #include "defs.h"
-#include "pointerlist.h"
+#include "datetime.h"
 
-PointerList *NamedDays_get_list_for_year (int year, const char *tz, BOOL utc,
-  BOOL southern);
+/*=======================================================================
+NamedDays
+The named days -- festivals, equinoxes and solstices -- of a range of 
+years, indexed by day. Days are numbered as UTC days since 1970-01-01,
+which is how DateTime_is_same_day compares them. Each day has a bucket
+in one array of events, so finding the events of a day takes constant
+time, and going through the days in order takes one pass
+=======================================================================*/
+typedef struct _NamedDays
+  {
+  // The day of the first bucket, and the number of buckets
+  int64_t first_day;
+  int ndays;
+  // The events of day first_day + i are events[bucket[i]] up to, but
+  //  not including, events[bucket[i + 1]], in the order they were
+  //  added in
+  int *bucket;
+  DateTime **events;
+  int nevents;
+  } NamedDays;
+
+NamedDays *NamedDays_new (int first_year, int last_year, const char *tz,
+  BOOL utc, BOOL southern);
+
+int NamedDays_get_day (const NamedDays *self, int64_t day, 
+  DateTime *const **events);
+
+int NamedDays_get_events_on (const NamedDays *self, const DateTime *dt,
+  DateTime *const **events);
+
+void NamedDays_free (NamedDays *self);
 
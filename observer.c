@@ -0,0 +1,31 @@
+/*=======================================================================
+solunar
+observer.c
+Definition of the Observer value
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include "observer.h"
+#include "trigutil.h"
+
+
+/*=======================================================================
+Observer_init
+=======================================================================*/
+void Observer_init (Observer *self, double longitude, double latitude)
+  {
+  self->longitude = longitude;
+  self->latitude = latitude;
+  self->longitude_hours = longitude / 15.0;
+  sincosDeg (latitude, &self->sin_latitude, &self->cos_latitude);
+  }
+
+
+/*=======================================================================
+Observer_init_latlong
+=======================================================================*/
+void Observer_init_latlong (Observer *self, const LatLong *latlong)
+  {
+  Observer_init (self, LatLong_get_longitude (latlong), 
+    LatLong_get_latitude (latlong));
+  }
+
@@ -0,0 +1,29 @@
+/*=======================================================================
+solunar
+observer.h
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#pragma once
+
+#include "latlong.h"
+
+/*=======================================================================
+Observer
+A place from which the sun and moon are observed, along with the 
+values derived from its position that the altitude calculations use
+over and over again. It is a plain value, so it can be copied, and 
+kept on the stack or in another structure, and needs no freeing
+=======================================================================*/
+typedef struct _Observer
+  {
+  double longitude; // Degrees, east positive
+  double latitude; // Degrees, north positive
+  double longitude_hours; // Longitude as a time difference from Greenwich
+  double sin_latitude;
+  double cos_latitude;
+  } Observer;
+
+void Observer_init (Observer *self, double longitude, double latitude);
+
+void Observer_init_latlong (Observer *self, const LatLong *latlong);
+
@@ -0,0 +1,125 @@
+/*=======================================================================
+solunar
+pointerarray.c
+PointerArray object defines a growable array of pointers
+(c)2005-2012 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "pointerarray.h"
+#include "defs.h"
+
+// The capacity of an array's first allocation. It doubles after that
+#define POINTERARRAY_INITIAL_CAPACITY 16
+
+/*=======================================================================
+PointerArray_new
+Create an empty array. Caller must free with PointerArray_free
+=======================================================================*/
+PointerArray *PointerArray_new (void)
+  {
+  PointerArray *self = (PointerArray *) malloc (sizeof (PointerArray));
+  self->pointers = NULL;
+  self->length = 0;
+  self->capacity = 0;
+  return self;
+  }
+
+
+/*=======================================================================
+PointerArray_append
+=======================================================================*/
+void PointerArray_append (PointerArray *self, void *pointer)
+  {
+  if (self->length == self->capacity)
+    {
+    self->capacity = self->capacity 
+      ? 2 * self->capacity : POINTERARRAY_INITIAL_CAPACITY;
+    self->pointers = (void **) realloc (self->pointers, 
+      self->capacity * sizeof (void *));
+    }
+  self->pointers[self->length++] = pointer;
+  }
+
+
+/*=======================================================================
+PointerArray_get_length
+=======================================================================*/
+int PointerArray_get_length (const PointerArray *self)
+  {
+  return self->length;
+  }
+
+
+/*=======================================================================
+PointerArray_get_pointer
+=======================================================================*/
+void *PointerArray_get_pointer (const PointerArray *self, int index)
+  {
+  if (index < 0 || index >= self->length)
+    {
+    fprintf (stderr, 
+      "PointerArray index %d out of range in get_pointer()\n", index);
+    return NULL;
+    }
+  return self->pointers[index];
+  }
+
+
+/*=======================================================================
+PointerArray_get_const_pointer
+=======================================================================*/
+const void *PointerArray_get_const_pointer (const PointerArray *self, 
+    int index)
+  {
+  return PointerArray_get_pointer (self, index);
+  }
+
+
+/*=======================================================================
+PointerArray_foreach
+Call fn on each element, in order, passing user_data along with it
+=======================================================================*/
+void PointerArray_foreach (const PointerArray *self, PointerArrayFunc fn,
+    void *user_data)
+  {
+  int i;
+  for (i = 0; i < self->length; i++)
+    fn (self->pointers[i], user_data);
+  }
+
+
+/*=======================================================================
+PointerArray_free_contents
+Free each element with free_fn, or with free() if that is NULL, and
+leave the array empty
+=======================================================================*/
+void PointerArray_free_contents (PointerArray *self, 
+    PointerArrayFreeFunc free_fn)
+  {
+  int i;
+  for (i = 0; i < self->length; i++)
+    {
+    if (self->pointers[i])
+      {
+      if (free_fn) 
+        free_fn (self->pointers[i]);
+      else
+        free (self->pointers[i]);
+      }
+    }
+  self->length = 0;
+  }
+
+
+/*=======================================================================
+PointerArray_free
+Free the array and, if free_contents is set, each element with free()
+=======================================================================*/
+void PointerArray_free (PointerArray *self, BOOL free_contents)
+  {
+  if (free_contents) PointerArray_free_contents (self, NULL);
+  free (self->pointers);
+  free (self);
+  }
+
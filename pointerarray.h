@@ -0,0 +1,39 @@
+/*=======================================================================
+solunar
+pointerarray.h
+(c)2005-2012 Kevin Boone
+=======================================================================*/
+#pragma once
+
+#include "defs.h"
+
+// A function that frees one element of a PointerArray
+typedef void (*PointerArrayFreeFunc) (void *pointer);
+
+// A function to call on each element of a PointerArray
+typedef void (*PointerArrayFunc) (void *pointer, void *user_data);
+
+/*=======================================================================
+PointerArray
+A growable array of pointers, held contiguously, so that appending 
+takes amortized constant time and indexing constant time
+=======================================================================*/
+typedef struct _PointerArray
+  {
+  void **pointers;
+  int length;
+  int capacity;
+  } PointerArray;
+
+PointerArray *PointerArray_new (void);
+void PointerArray_append (PointerArray *self, void *pointer);
+int PointerArray_get_length (const PointerArray *self);
+void *PointerArray_get_pointer (const PointerArray *self, int index);
+const void *PointerArray_get_const_pointer (const PointerArray *self, 
+  int index);
+void PointerArray_foreach (const PointerArray *self, PointerArrayFunc fn,
+  void *user_data);
+void PointerArray_free_contents (PointerArray *self, 
+  PointerArrayFreeFunc free_fn);
+void PointerArray_free (PointerArray *self, BOOL free_contents);
+
@@ -0,0 +1,630 @@
+/*=======================================================================
+solunar
+riseset.c
+Functions for finding the times at which the sun or the moon crosses
+a particular altitude, such as the horizon. The body's position is
+supplied by a function, so that the same search serves for both
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdlib.h>
+#include <math.h>
+#include "riseset.h"
+#include "timeutil.h"
+#include "trigutil.h"
+#include "mathutil.h"
+
+/*=======================================================================
+RiseSetSearch
+The parameters of a search for rises and sets, which are the times at
+which the sine altitude of the body crosses sin_h0. Times in the
+search are in seconds from the start of the range
+=======================================================================*/
+typedef struct _RiseSetSearch
+  {
+  const Observer *observer;
+  double sin_h0;
+  double start_mjd;
+  // Local sidereal time at the start, in hours
+  double start_lmst;
+  double length;
+  // The part of the search over which the approximate altitude is
+  //  modelled
+  double model_start;
+  double model_length;
+  // RA and declination at the start, middle, and end of the model, 
+  //  with the RA unwrapped so that it does not jump back by 24 hours
+  double ra[3];
+  double dec[3];
+  EphemerisCache *cache;
+  } RiseSetSearch;
+
+/*=======================================================================
+RiseSetBody
+What the search needs to know about a body: the function that gives 
+its position, and a function for its sine altitude in the search, 
+which calls that one directly. There is a constant RiseSetBody for 
+each body in RISESET_BODIES. The search functions below are inlined
+into each body's own entry points, with its RiseSetBody as a constant,
+so the compiler produces a search for each body that calls its 
+functions directly, rather than one that works out at each step which
+body it is dealing with
+=======================================================================*/
+typedef struct _RiseSetBody
+  {
+  RiseSetPositionFunc position;
+  double (*sin_altitude_at) (double t, void *data);
+  } RiseSetBody;
+
+#ifdef __GNUC__
+#define RISESET_INLINE static inline __attribute__ ((always_inline))
+#else
+#define RISESET_INLINE static inline
+#endif
+
+// Interval at which the approximate altitude is sampled to look for 
+//  crossings, in seconds
+#define RISESET_MODEL_STEP 600
+// Half-width of the interval around an approximate crossing in which
+//  the exact crossing is sought, in seconds
+#define RISESET_BRACKET 600
+// Number of samples of the approximate altitude worked out together
+#define RISESET_BLOCK 64
+// Half-width of the interval around a predicted crossing in which a 
+//  range search looks for it if it is not within RISESET_BRACKET of 
+//  the prediction, in seconds. It has to allow for the variation of 
+//  the body's daily drift
+#define RISESET_WARM_BRACKET 5400
+// Longest stretch of a range search that one approximate model 
+//  covers, in seconds
+#define RISESET_WINDOW 86400
+
+static const double DegRad = M_PI / 180.0;
+
+
+/*=======================================================================
+RiseSetEvents_init
+=======================================================================*/
+void RiseSetEvents_init (RiseSetEvents *self)
+  {
+  self->nrises = 0;
+  self->nsets = 0;
+  }
+
+
+/*=======================================================================
+RiseSetEvents_clear
+Free the events, leaving the structure ready to be used again
+=======================================================================*/
+void RiseSetEvents_clear (RiseSetEvents *self)
+  {
+  int i;
+  for (i = 0; i < self->nrises; i++)
+    DateTime_free (self->rises[i]);
+  for (i = 0; i < self->nsets; i++)
+    DateTime_free (self->sets[i]);
+  self->nrises = 0;
+  self->nsets = 0;
+  }
+
+
+/*=======================================================================
+RiseSetEvents_set_times
+Replace the events with the times in 'times', to the nearest second
+=======================================================================*/
+void RiseSetEvents_set_times (RiseSetEvents *self, 
+    const RiseSetTimes *times)
+  {
+  int i;
+  RiseSetEvents_clear (self);
+  for (i = 0; i < times->nrises; i++)
+    self->rises[i] = DateTime_new_utime (timeutil_JD_to_unix 
+      (times->rises[i]));
+  for (i = 0; i < times->nsets; i++)
+    self->sets[i] = DateTime_new_utime (timeutil_JD_to_unix 
+      (times->sets[i]));
+  self->nrises = times->nrises;
+  self->nsets = times->nsets;
+  }
+
+
+/*=======================================================================
+RiseSetTimes_init
+=======================================================================*/
+void RiseSetTimes_init (RiseSetTimes *self)
+  {
+  self->nrises = 0;
+  self->nsets = 0;
+  }
+
+
+/*=======================================================================
+riseset_sin_altitude
+The sine altitude, less sin_h0, of the body whose position is given
+by 'position', t seconds into a search, from the full ephemeris. Each
+body's sin_altitude_at function is this, with its own position
+=======================================================================*/
+RISESET_INLINE double riseset_sin_altitude (const RiseSetSearch *search,
+    RiseSetPositionFunc position, double t)
+  {
+  double mjd = search->start_mjd + t / 86400.0;
+  double ra, dec;
+  position (search->cache, mjd, &ra, &dec);
+  const Observer *observer = search->observer;
+  double tau = 15.0 * (timeutil_lmst_hours (mjd, observer->longitude_hours) 
+    - ra);
+  double sin_dec, cos_dec;
+  sincosDeg (dec, &sin_dec, &cos_dec);
+  return observer->sin_latitude * sin_dec
+    + observer->cos_latitude * cos_dec * cosDeg (tau) - search->sin_h0;
+  }
+
+
+/*=======================================================================
+riseset_set_model
+Work out the RA and declination at the start, middle, and end of the 
+part of the search between t0 and t1, for the approximate altitude to 
+be interpolated from
+=======================================================================*/
+RISESET_INLINE void riseset_set_model (const RiseSetBody *body, 
+    RiseSetSearch *search, double t0, double t1)
+  {
+  search->model_start = t0;
+  search->model_length = t1 - t0;
+  int i;
+  for (i = 0; i < 3; i++)
+    {
+    body->position (search->cache, search->start_mjd 
+      + (t0 + i * search->model_length / 2.0) / 86400.0, 
+      &search->ra[i], &search->dec[i]);
+    if (i > 0)
+      {
+      if (search->ra[i] < search->ra[i - 1] - 12.0) search->ra[i] += 24.0;
+      if (search->ra[i] > search->ra[i - 1] + 12.0) search->ra[i] -= 24.0;
+      }
+    }
+  }
+
+
+/*=======================================================================
+riseset_approx_sin_altitude_array
+The body's approximate sine altitude, less sin_h0, at each of the n
+times t[] seconds into a search, where n is no more than 
+RISESET_BLOCK. The RA and declination of the sun and moon change 
+slowly and smoothly compared to their hour angles, so they are 
+interpolated from the three values worked out by riseset_set_model.
+The sidereal time advances at a constant rate, so it is the time at
+the start of the search plus t[] sidereal seconds, with none of the
+floor() and pascalFrac() that timeutil_lmst_hours() does. The sines
+and cosines are worked out together by sinArray() and cosArray()
+=======================================================================*/
+static void riseset_approx_sin_altitude_array (const RiseSetSearch *search,
+    const double *t, int n, double *result)
+  {
+  double dec[RISESET_BLOCK], tau[RISESET_BLOCK];
+  double sin_dec[RISESET_BLOCK], cos_dec[RISESET_BLOCK];
+  int i;
+  for (i = 0; i < n; i++)
+    {
+    double u = 2.0 * (t[i] - search->model_start) / search->model_length;
+    double ra = search->ra[0] + u * (search->ra[1] - search->ra[0])
+      + 0.5 * u * (u - 1) * (search->ra[2] - 2 * search->ra[1] 
+      + search->ra[0]);
+    dec[i] = (search->dec[0] + u * (search->dec[1] - search->dec[0])
+      + 0.5 * u * (u - 1) * (search->dec[2] - 2 * search->dec[1] 
+      + search->dec[0])) * DegRad;
+    tau[i] = 15.0 * (search->start_lmst 
+      + TIMEUTIL_SIDEREAL_RATE * t[i] / 3600.0 - ra) * DegRad;
+    }
+  sinArray (dec, sin_dec, n);
+  cosArray (dec, cos_dec, n);
+  cosArray (tau, tau, n);
+  for (i = 0; i < n; i++)
+    result[i] = search->observer->sin_latitude * sin_dec[i] 
+      + search->observer->cos_latitude * cos_dec[i] * tau[i] 
+      - search->sin_h0;
+  }
+
+
+/*=======================================================================
+riseset_refine_crossing
+Look for a crossing in the right direction in the interval within 
+'width' seconds of 'guess', but not before 'lower', and if there is 
+one, pin it down to within 'tolerance' seconds. Returns the time of 
+the crossing, or -1 if there is no crossing in the interval
+=======================================================================*/
+RISESET_INLINE double riseset_refine_crossing (const RiseSetBody *body,
+    RiseSetSearch *search, double guess, double width, double lower, 
+    double tolerance, BOOL rising)
+  {
+  double a = guess - width;
+  double b = guess + width;
+  if (a < lower) a = lower;
+  if (b > search->length) b = search->length;
+  double fa = body->sin_altitude_at (a, search);
+  double fb = body->sin_altitude_at (b, search);
+  if (rising ? (fa < 0 && fb >= 0) : (fa > 0 && fb <= 0))
+    return mathutil_find_root (body->sin_altitude_at, search, 
+      a, b, fa, fb, tolerance, NULL);
+  return -1;
+  }
+
+
+/*=======================================================================
+riseset_pin_crossing
+Pin down a crossing whose approximate time is 'guess', but which is
+not before 'lower'. Returns the time of the crossing, or -1 if there 
+turns out not to be one
+=======================================================================*/
+RISESET_INLINE double riseset_pin_crossing (const RiseSetBody *body,
+    RiseSetSearch *search, double guess, double lower, double tolerance, 
+    BOOL rising)
+  {
+  double root = riseset_refine_crossing (body, search, guess, 
+    RISESET_BRACKET, lower, tolerance, rising);
+  if (root < 0)
+    root = riseset_refine_crossing (body, search, guess, 
+      3 * RISESET_BRACKET, lower, tolerance, rising);
+  return root;
+  }
+
+
+/*=======================================================================
+riseset_add_crossing
+Pin down a crossing whose approximate time is 'guess', and add its
+Julian date to 'events' and 'nevents' if it is genuine, and not the 
+same as the last one found in the same direction
+=======================================================================*/
+RISESET_INLINE void riseset_add_crossing (const RiseSetBody *body,
+    RiseSetSearch *search, double guess, double tolerance, BOOL rising, 
+    double *last_root, double events[], int *nevents)
+  {
+  double root = riseset_pin_crossing (body, search, guess, 0, tolerance, 
+    rising);
+  // A wide bracket might find the same crossing twice
+  if (root >= 0 && (*last_root < 0 || root - *last_root > 60.0))
+    {
+    events[*nevents] = search->start_mjd + 2400000.5 + root / 86400.0;
+    (*nevents)++;
+    *last_root = root;
+    }
+  }
+
+
+/*=======================================================================
+riseset_init_search
+Set up a search between two Julian dates
+=======================================================================*/
+static void riseset_init_search (RiseSetSearch *search, 
+    const Observer *observer, double start_jd, double end_jd, 
+    double sin_h0, EphemerisCache *cache)
+  {
+  search->cache = cache;
+  search->observer = observer;
+  search->sin_h0 = sin_h0;
+  search->start_mjd = start_jd - 2400000.5;
+  search->start_lmst = timeutil_lmst_hours (search->start_mjd, 
+    observer->longitude_hours);
+  search->length = (end_jd - start_jd) * 86400.0;
+  }
+
+
+/*=======================================================================
+riseset_find_times
+Find the times between the Julian dates start_jd and end_jd at which
+the sine altitude of 'body' rises through or falls through sin_h0, 
+and write them into 'events', replacing whatever was there.
+
+This is done in two stages. First, the body's RA and declination
+are worked out at the start, middle, and end of the range, and the 
+sine altitude that follows from interpolating them is sampled to 
+find the approximate times of the crossings in both directions. This
+needs only the sidereal time for each sample, not the ephemeris. Then
+each crossing is bracketed and found by Brent's method, using the 
+full ephemeris, to within 'tolerance' seconds. For a day, this takes 
+twenty or so evaluations of the ephemeris, for rises and sets 
+together. Nothing is allocated. 'cache' may be NULL 
+=======================================================================*/
+RISESET_INLINE void riseset_find_times (const RiseSetBody *body, 
+    const Observer *observer, double start_jd, double end_jd, 
+    double sin_h0, double tolerance, EphemerisCache *cache, 
+    RiseSetTimes *events)
+  {
+  RiseSetTimes_init (events);
+
+  RiseSetSearch search;
+  riseset_init_search (&search, observer, start_jd, end_jd, sin_h0, 
+    cache);
+
+  if (search.length <= 0) return;
+
+  double last_rise = -1, last_set = -1;
+  int i;
+  riseset_set_model (body, &search, 0, search.length);
+
+  // The approximate altitude is sampled every RISESET_MODEL_STEP 
+  //  seconds, and at the end of the range, a block at a time 
+  double t[RISESET_BLOCK], y[RISESET_BLOCK];
+  double last_t = 0, last_y = 0;
+  int npoints = (int) ceil (search.length / RISESET_MODEL_STEP) + 1;
+  int first;
+  for (first = 0; first < npoints && (events->nrises < RISESET_MAX_EVENTS
+      || events->nsets < RISESET_MAX_EVENTS); first += RISESET_BLOCK)
+    {
+    int m = npoints - first;
+    if (m > RISESET_BLOCK) m = RISESET_BLOCK;
+    for (i = 0; i < m; i++)
+      {
+      t[i] = (double) (first + i) * RISESET_MODEL_STEP;
+      if (t[i] > search.length) t[i] = search.length;
+      }
+    riseset_approx_sin_altitude_array (&search, t, m, y);
+
+    for (i = 0; i < m; i++)
+      {
+      if (first + i > 0)
+        {
+        if (last_y < 0 && y[i] >= 0 && events->nrises < RISESET_MAX_EVENTS)
+          {
+          riseset_add_crossing (body, &search, last_t + (t[i] - last_t) 
+            * last_y / (last_y - y[i]), tolerance, TRUE, 
+            &last_rise, events->rises, &events->nrises);
+          }
+        else if (last_y > 0 && y[i] <= 0 
+            && events->nsets < RISESET_MAX_EVENTS)
+          {
+          riseset_add_crossing (body, &search, last_t + (t[i] - last_t) 
+            * last_y / (last_y - y[i]), tolerance, FALSE, 
+            &last_set, events->sets, &events->nsets);
+          }
+        }
+      last_t = t[i];
+      last_y = y[i];
+      }
+    }
+  }
+
+
+/*=======================================================================
+riseset_scan_crossing
+Look for the first crossing between t0 and t1 that is at least a 
+minute after 'last', and, if last_rising is 0 or 1, in the opposite
+direction to it, by sampling the approximate altitude. Sets *rising
+and returns the time of the crossing, or returns -1 if there is none
+=======================================================================*/
+RISESET_INLINE double riseset_scan_crossing (const RiseSetBody *body, 
+    RiseSetSearch *search, double t0, double t1, double last, 
+    int last_rising, double tolerance, BOOL *rising)
+  {
+  double t[RISESET_BLOCK], y[RISESET_BLOCK];
+  double last_t = 0, last_y = 0;
+  double lower = last < 0 ? 0 : last + 1;
+  int npoints = (int) ceil ((t1 - t0) / RISESET_MODEL_STEP) + 1;
+  int first, i;
+  riseset_set_model (body, search, t0, t1);
+  for (first = 0; first < npoints; first += RISESET_BLOCK)
+    {
+    int m = npoints - first;
+    if (m > RISESET_BLOCK) m = RISESET_BLOCK;
+    for (i = 0; i < m; i++)
+      {
+      t[i] = t0 + (double) (first + i) * RISESET_MODEL_STEP;
+      if (t[i] > t1) t[i] = t1;
+      }
+    riseset_approx_sin_altitude_array (search, t, m, y);
+
+    for (i = 0; i < m; i++)
+      {
+      if (first + i > 0 && ((last_y < 0 && y[i] >= 0) 
+          || (last_y > 0 && y[i] <= 0)))
+        {
+        BOOL up = last_y < 0;
+        if (up != last_rising)
+          {
+          double root = riseset_pin_crossing (body, search, last_t + (t[i] 
+            - last_t) * last_y / (last_y - y[i]), lower, tolerance, up);
+          if (root >= 0 && (last < 0 || root - last > 60.0))
+            {
+            *rising = up;
+            return root;
+            }
+          }
+        }
+      last_t = t[i];
+      last_y = y[i];
+      }
+    }
+  return -1;
+  }
+
+
+/*=======================================================================
+riseset_predict_crossing
+Look for a crossing in the specified direction near 'guess', which is
+predicted from the body's daily drift, and after the last crossing, 
+which was at 'last' and in the other direction. Returns the time of
+the crossing, or -1 if it isn't where it was predicted to be, or if 
+there might be other crossings between 'last' and it
+=======================================================================*/
+RISESET_INLINE double riseset_predict_crossing (const RiseSetBody *body,
+    RiseSetSearch *search, double last, double guess, double tolerance, 
+    BOOL rising)
+  {
+  double a = guess - RISESET_WARM_BRACKET;
+  if (a <= last) return -1;
+  // The altitude rises and falls once a day, so there can only be
+  //  more crossings between the last one and the start of the 
+  //  bracket if the drift is far off. If it is, the altitude is 
+  //  likely to have the wrong sign somewhere in between
+  double fm = body->sin_altitude_at (0.5 * (last + a), search);
+  if (rising ? fm >= 0 : fm <= 0) return -1;
+  double root = riseset_refine_crossing (body, search, guess, 
+    RISESET_BRACKET, last, tolerance, rising);
+  if (root < 0)
+    root = riseset_refine_crossing (body, search, guess, 
+      RISESET_WARM_BRACKET, last, tolerance, rising);
+  return root;
+  }
+
+
+/*=======================================================================
+riseset_find_times_range
+Find the rises and sets of 'body' on each of ndays days, and write 
+them into the corresponding elements of days[]. bounds[] holds the
+Julian date at which each day starts, followed by the one at which 
+the day after the last starts. This is the same as calling 
+riseset_find_times for each day, but cheaper. The days are searched
+as one range, so events close to midnight are neither missed nor 
+found twice. Rises and sets alternate, and once one of each has been
+found, each crossing is first looked for where the previous crossing
+in the same direction, moved on by the drift between the last two 
+such crossings, or by 'drift' seconds at first, predicts it to be. 
+Only if it isn't there is the approximate altitude sampled, as 
+riseset_find_times does, to find it. Nothing is allocated
+=======================================================================*/
+RISESET_INLINE void riseset_find_times_range (const RiseSetBody *body,
+    const Observer *observer, const double *bounds, int ndays, 
+    double sin_h0, double drift, double tolerance, EphemerisCache *cache, 
+    RiseSetTimes *days)
+  {
+  if (ndays <= 0) return;
+
+  int i;
+  for (i = 0; i < ndays; i++)
+    RiseSetTimes_init (&days[i]);
+
+  // The search stops at the last second of the last day, as 
+  //  riseset_find_times does for each day
+  RiseSetSearch search;
+  riseset_init_search (&search, observer, bounds[0], 
+    bounds[ndays] - 1.0 / 86400.0, sin_h0, cache);
+
+  double t = 0; // The search has covered everything before t
+  double last = -1; // Time of the last crossing found
+  int last_rising = -1;
+  double previous[2] = {-1, -1}; // Time of the last set and rise
+  double drifts[2] = {drift, drift}; // Time between the last two of each
+  int d = 0;
+  while (t < search.length)
+    {
+    double root = -1;
+    BOOL rising = !last_rising;
+    if (last_rising >= 0 && previous[rising] >= 0)
+      root = riseset_predict_crossing (body, &search, last, 
+        previous[rising] + drifts[rising], tolerance, rising);
+    if (root < 0)
+      {
+      // Start a little early, in case a crossing just before t was
+      //  missed, because the model changes at t
+      double t0 = t - RISESET_MODEL_STEP;
+      if (t0 < 0) t0 = 0;
+      double t1 = t0 + RISESET_WINDOW;
+      if (t1 > search.length) t1 = search.length;
+      root = riseset_scan_crossing (body, &search, t0, t1, last, 
+        last_rising, tolerance, &rising);
+      if (root < 0)
+        {
+        t = t1;
+        continue;
+        }
+      }
+
+    // The day is decided to the nearest second, as it would be for
+    //  the time that is eventually displayed
+    long offset = (long) floor (root + 0.5);
+    while (d < ndays - 1 && offset >= (long) floor ((bounds[d + 1] 
+        - bounds[0]) * 86400.0 + 0.5)) d++;
+    RiseSetTimes *events = &days[d];
+    double jd = bounds[0] + root / 86400.0;
+    if (rising && events->nrises < RISESET_MAX_EVENTS)
+      events->rises[events->nrises++] = jd;
+    else if (!rising && events->nsets < RISESET_MAX_EVENTS)
+      events->sets[events->nsets++] = jd;
+    if (previous[rising] >= 0 
+        && fabs (root - previous[rising] - drift) < RISESET_WARM_BRACKET)
+      drifts[rising] = root - previous[rising];
+    t = last = previous[rising] = root;
+    last_rising = rising;
+    }
+  }
+
+
+/*=======================================================================
+RiseSet_get_day_bounds
+Write into bounds[] the Julian dates at which each of ndays days in 
+zone tz starts, starting with the day containing 'first', followed by
+the one at which the day after the last starts, as the range searches
+need them. bounds[] must have room for ndays + 1 values. The days are
+stepped in the same way as callers that search each day separately
+=======================================================================*/
+void RiseSet_get_day_bounds (const DateTime *first, int ndays, 
+    const char *tz, BOOL utc, double *bounds)
+  {
+  DateTimeValue day = DateTime_get_value (first);
+  DateTimeValue start = DateTimeValue_get_day_start (day, tz);
+  double start_jd = DateTimeValue_get_julian_date (start);
+  int i;
+  for (i = 0; i < ndays; i++)
+    {
+    if (i != 0) day = DateTimeValue_add_days (day, 1, tz, utc);
+    bounds[i] = start_jd + DateTimeValue_seconds_difference (start, 
+      DateTimeValue_get_day_start (day, tz)) / 86400.0;
+    }
+  DateTimeValue end = DateTimeValue_get_day_end (day, tz);
+  bounds[ndays] = start_jd 
+    + (DateTimeValue_seconds_difference (start, end) + 1) / 86400.0;
+  }
+
+
+/*=======================================================================
+The entry points for each body in RISESET_BODIES. For a body 'name',
+RiseSet_find_name_times finds the times between two Julian dates at 
+which its sine altitude rises through or falls through sin_h0, as 
+riseset_find_times describes, and RiseSet_find_name_times_range 
+finds them for each of a number of days, as riseset_find_times_range
+describes. Neither allocates anything. RiseSet_find_name_events does 
+the same as RiseSet_find_name_times for times given as DateTimes, and
+gives the results as DateTimes, which the caller must free with 
+RiseSetEvents_clear. 'cache' may be NULL
+=======================================================================*/
+#define RISESET_BODY(name, position_func) \
+  static double riseset_##name##_sin_altitude_at (double t, void *data) \
+    { \
+    return riseset_sin_altitude (data, position_func, t); \
+    } \
+  \
+  static const RiseSetBody riseset_##name = \
+    { \
+    position_func, riseset_##name##_sin_altitude_at \
+    }; \
+  \
+  void RiseSet_find_##name##_times (const Observer *observer, \
+      double start_jd, double end_jd, double sin_h0, double tolerance, \
+      EphemerisCache *cache, RiseSetTimes *times) \
+    { \
+    riseset_find_times (&riseset_##name, observer, start_jd, end_jd, \
+      sin_h0, tolerance, cache, times); \
+    } \
+  \
+  void RiseSet_find_##name##_times_range (const Observer *observer, \
+      const double *bounds, int ndays, double sin_h0, double drift, \
+      double tolerance, EphemerisCache *cache, RiseSetTimes *days) \
+    { \
+    riseset_find_times_range (&riseset_##name, observer, bounds, ndays, \
+      sin_h0, drift, tolerance, cache, days); \
+    } \
+  \
+  void RiseSet_find_##name##_events (const Observer *observer, \
+      const DateTime *start, const DateTime *end, double sin_h0, \
+      double tolerance, EphemerisCache *cache, RiseSetEvents *events) \
+    { \
+    RiseSetTimes times; \
+    double start_jd = DateTime_get_julian_date (start); \
+    RiseSet_find_##name##_times (observer, start_jd, \
+      start_jd + DateTime_seconds_difference (start, end) / 86400.0, \
+      sin_h0, tolerance, cache, &times); \
+    RiseSetEvents_set_times (events, &times); \
+    }
+
+RISESET_BODIES
+
+#undef RISESET_BODY
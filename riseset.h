@@ -0,0 +1,104 @@
+/*=======================================================================
+solunar
+riseset.h
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#pragma once
+
+#include "defs.h"
+#include "datetime.h"
+#include "observer.h"
+#include "ephemeris.h"
+
+// Most rises, and most sets, that are recorded for one range of times
+#define RISESET_MAX_EVENTS 4
+
+// Something that gives the RA and declination of a body at a time,
+//  such as EphemerisCache_get_moon
+typedef void (*RiseSetPositionFunc) (EphemerisCache *cache, double mjd,
+  double *ra, double *dec);
+
+/*=======================================================================
+RiseSetStatus
+The outcome of looking for a rise or set that may not happen, such 
+as sunrise near the poles. Functions that return one allocate 
+nothing, unlike those that report the same thing with an Error
+=======================================================================*/
+typedef enum _RiseSetStatus
+  {
+  RISESET_OK = 0,
+  // The body stays below the altitude all day
+  RISESET_ALWAYS_BELOW,
+  // The body stays above the altitude all day
+  RISESET_ALWAYS_ABOVE
+  } RiseSetStatus;
+
+/*=======================================================================
+RiseSetTimes
+The rises and sets of one body found in a range of times, as Julian
+dates. This is what the searches produce, and as it holds no pointers,
+finding and discarding events needs no memory to be allocated
+=======================================================================*/
+typedef struct _RiseSetTimes
+  {
+  int nrises;
+  int nsets;
+  double rises [RISESET_MAX_EVENTS];
+  double sets [RISESET_MAX_EVENTS];
+  } RiseSetTimes;
+
+void RiseSetTimes_init (RiseSetTimes *self);
+
+/*=======================================================================
+RiseSetEvents
+The rises and sets of one body found in a range of times. The 
+caller owns the structure, and usually keeps it for the whole of a
+run, so nothing need be allocated for each range apart from the 
+events themselves
+=======================================================================*/
+typedef struct _RiseSetEvents
+  {
+  int nrises;
+  int nsets;
+  DateTime *rises [RISESET_MAX_EVENTS];
+  DateTime *sets [RISESET_MAX_EVENTS];
+  } RiseSetEvents;
+
+void RiseSetEvents_init (RiseSetEvents *self);
+
+void RiseSetEvents_clear (RiseSetEvents *self);
+
+void RiseSetEvents_set_times (RiseSetEvents *self, 
+  const RiseSetTimes *times);
+
+void RiseSet_get_day_bounds (const DateTime *first, int ndays, 
+  const char *tz, BOOL utc, double *bounds);
+
+// The bodies whose rises and sets can be found, each with the function
+//  that gives its position. The moon is here once for each precision
+//  tier of its series. Each gets its own search, specialised for 
+//  it when riseset.c is compiled. To add a body, add a line here
+#define RISESET_BODIES \
+  RISESET_BODY (sun, EphemerisCache_get_sun) \
+  RISESET_BODY (moon, EphemerisCache_get_moon) \
+  RISESET_BODY (moon_fast, EphemerisCache_get_moon_fast) \
+  RISESET_BODY (moon_high, EphemerisCache_get_moon_high)
+
+// Declares RiseSet_find_sun_times, RiseSet_find_sun_times_range,
+//  and RiseSet_find_sun_events, and the same for each of the other 
+//  bodies
+#define RISESET_BODY(name, position_func) \
+  void RiseSet_find_##name##_times (const Observer *observer, \
+    double start_jd, double end_jd, double sin_h0, double tolerance, \
+    EphemerisCache *cache, RiseSetTimes *times); \
+  void RiseSet_find_##name##_times_range (const Observer *observer, \
+    const double *bounds, int ndays, double sin_h0, double drift, \
+    double tolerance, EphemerisCache *cache, RiseSetTimes *days); \
+  void RiseSet_find_##name##_events (const Observer *observer, \
+    const DateTime *start, const DateTime *end, double sin_h0, \
+    double tolerance, EphemerisCache *cache, RiseSetEvents *events);
+
+RISESET_BODIES
+
+#undef RISESET_BODY
+
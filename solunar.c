@@ -13,6 +13,11 @@ solunar.c
 #include "latlong.h"
 #include "error.h"
 #include "datetime.h"
+#include "suntimes.h"
+#include "moontimes.h"
+#include "solunar.h"
+#include "timeutil.h"
+#include "riseset.h"
 
 #define PERIGEE 363285
 #define APOGEE 405503
@@ -25,7 +30,7 @@ and sunrise. The time period at high noon with score 1.0 varies from
 around 3 hours at midsummer, to nothing at all in winter
 =======================================================================*/
 double Solunar_score_solar_sa (double sa, BOOL include_high_noon,
-    BOOL include_sun_underfoot, double max_sa, double min_a)
+    BOOL include_sun_underfoot, double max_sa)
   {
   double score = 0;
   if (include_high_noon && (sa > 0.0))
@@ -111,3 +116,324 @@ double Solunar_score_moon_distance (double distance)
 
 
 
+/*=======================================================================
+solunar_score_day
+Works out the solunar scores for each half-hour period of the day 
+that starts at the MJD start_mjd, with the moon's phase and distance
+taken at the Julian date state_jd, along with the overall scores. 
+Rather than the peak times, which are left alone in 'result', the 
+number of seconds from the start of the day to each peak is written
+to peak_offsets[]. The periods are evenly spaced, so the positions of
+the sun and moon are worked out with the grid functions, which step 
+from one period to the next. Nothing is allocated
+=======================================================================*/
+static void solunar_score_day (const Observer *observer, double start_mjd,
+    double state_jd, SolunarDay *result, long *peak_offsets)
+  {
+  double phase, age, distance;
+  MoonTimes_get_moon_state_jd (state_jd, &phase, &age, &distance); 
+  result->phase_score = Solunar_score_moon_phase (phase);
+  result->distance_score = Solunar_score_moon_distance (distance);
+
+  // Work out the solar and lunar sine altitude for each period, and
+  //  the maximum and minimum values over the whole day. We'll take 
+  //  our calculation point as the middle of the 30 minute time period 
+
+  double sas [SOLUNAR_PERIODS], las [SOLUNAR_PERIODS];
+  double min_la = 0, max_la = 0, max_sa = 0;
+
+  double mjd0 = start_mjd + (1800 / 2) / 86400.0;
+  SunTimes_get_sin_altitude_grid (observer, mjd0, 1800 / 86400.0, 
+    SOLUNAR_PERIODS, sas);
+  MoonTimes_get_sin_altitude_grid (observer, mjd0, 1800 / 86400.0, 
+    SOLUNAR_PERIODS, las);
+
+  int i;
+  for (i = 0; i < SOLUNAR_PERIODS; i++)
+    {
+    if (sas[i] > max_sa) max_sa = sas[i];
+    if (las[i] > max_la) max_la = las[i];
+    if (las[i] < min_la) min_la = las[i];
+    }
+
+  double total_combined_score = 0.0;
+  BOOL in_solunar_period = FALSE;
+  double last_combined_score = 0;
+  BOOL got_solunar = FALSE;
+  result->num_peaks = 0;
+
+  // Offset of the centre of the current period from the start
+  long t_center = 1800 / 2;
+  for (i = 0; i < SOLUNAR_PERIODS; i++)
+    {
+    BOOL include_high_noon = TRUE;
+    BOOL include_sun_underfoot = FALSE;
+    double sunscore = Solunar_score_solar_sa (sas[i], include_high_noon, 
+      include_sun_underfoot, max_sa);
+
+    double moonscore = Solunar_score_moon (las[i], max_la, min_la);
+    double combined_score = moonscore * sunscore;
+    total_combined_score += combined_score;
+
+    if (in_solunar_period)
+      {
+      if (combined_score < last_combined_score)
+        {
+        if (!got_solunar && result->num_peaks < SOLUNAR_MAX_PEAKS)
+          {
+          got_solunar = TRUE;
+          peak_offsets[result->num_peaks] = t_center - 1800;
+          result->num_peaks++;
+          }
+        }
+      }
+
+    if (combined_score > 0.05 && !in_solunar_period)
+      {
+      in_solunar_period = TRUE;
+      }
+
+    if (combined_score <= 0.05 && in_solunar_period)
+      {
+      in_solunar_period = FALSE;
+      }
+
+    if (combined_score <= 0.05) 
+      {
+      got_solunar = FALSE; 
+      }
+
+    result->sun_score[i] = sunscore;
+    result->moon_score[i] = moonscore;
+    result->combined_score[i] = combined_score;
+    t_center += 1800;
+    last_combined_score = combined_score;
+    }
+
+  // We get the total coincidence score by integrating the 
+  //  combined sun/moon score over the 24-hour period. It's 
+  //  very difficult to work out what the maximum value of this
+  //  setting. The divisor '5' here is based on a large number of
+  //  experiments, such that the maximum value in a year-long period
+  //  is 1.00 
+  double coincidence_score = total_combined_score / 5; 
+  if (coincidence_score > 1.0) coincidence_score = 1.0;
+  result->coincidence_score = coincidence_score;
+  result->overall_score = (coincidence_score + result->phase_score 
+    + result->distance_score) / 3.0;
+  }
+
+
+/*=======================================================================
+Solunar_get_day
+Works out the solunar scores for each half-hour period of the day
+in which 'date' falls, along with the peak times and the overall
+scores, as solunar_score_day does. The times in the result are held
+by value, so nothing is allocated
+=======================================================================*/
+void Solunar_get_day (const Observer *observer, const DateTime *date,
+    const char *tz, BOOL utc, SolunarDay *result)
+  {
+  int dummy, year, month, day;
+  DateTimeValue value = DateTime_get_value (date);
+  DateTimeValue_get_ymdhms (value, &year, &month, &day, &dummy,
+        &dummy, &dummy, tz, utc);
+
+  result->start = DateTimeValue_from_dmy (day, month, year, NULL, tz, utc);
+
+  long peak_offsets [SOLUNAR_MAX_PEAKS];
+  solunar_score_day (observer, 
+    DateTimeValue_get_modified_julian_date (result->start), 
+    DateTimeValue_get_julian_date (value), result, peak_offsets);
+
+  int i;
+  for (i = 0; i < result->num_peaks; i++)
+    result->peaks[i] = DateTimeValue_add_seconds (result->start, 
+      peak_offsets[i]);
+  }
+
+
+
+// Each array in a SolunarYear starts on a boundary of this many bytes
+#define SOLUNAR_YEAR_ALIGN 64
+// The hour of the day that DateTime_parse_fields gives a date with no time
+#define SOLUNAR_YEAR_HOUR 2
+
+
+/*=======================================================================
+Solunar_compute_year
+Works out the events and scores for each day of 'year' in zone tz, at
+the observer's location, into 'result', which the caller must free 
+with Solunar_free_year. Each day is as the batch output gives it for
+a date with no time, which is taken to be SOLUNAR_YEAR_HOUR local
+time: the sun's events are by the almanac formula for the UT day of
+that time, all four from one SunTimes_get_day_jd call, and the phase and the score are those MoonTimes_get_moon_state
+and Solunar_get_day give for that time. The days are divided as they 
+are for --ndays, each ending where the next starts, and the moon's 
+events come from one range search over the whole year, with the series
+for 'precision'. The moon's position is taken from 'cache', which may 
+be NULL. Apart from the result itself and the working storage for the 
+moon's events, nothing is allocated. If either can't be allocated, the
+result's ndays is zero and its arrays are NULL, and it can still be 
+passed to Solunar_free_year
+=======================================================================*/
+void Solunar_compute_year (const Observer *observer, int year, 
+    const char *tz, BOOL utc, MoonTimesPrecision precision, 
+    EphemerisCache *cache, SolunarYear *result)
+  {
+  int ndays = timeutil_is_leap_year (year) ? 366 : 365;
+  result->year = year;
+  result->ndays = ndays;
+
+  // Room for one more day start, to mark the end of the year, rounded
+  //  up to a whole number of alignment units
+  const int per_unit = SOLUNAR_YEAR_ALIGN / sizeof (double);
+  int stride = (ndays + 1 + per_unit - 1) / per_unit * per_unit;
+  double *block = NULL;
+  if (posix_memalign ((void **)&block, SOLUNAR_YEAR_ALIGN, 
+      9 * stride * sizeof (double) + ndays) != 0)
+    {
+    memset (result, 0, sizeof (SolunarYear));
+    result->year = year;
+    return;
+    }
+  result->block = block;
+  result->day_start = block;
+  result->sunrise = block + stride;
+  result->sunset = block + 2 * stride;
+  result->dawn = block + 3 * stride;
+  result->dusk = block + 4 * stride;
+  result->moonrise = block + 5 * stride;
+  result->moonset = block + 6 * stride;
+  result->phase = block + 7 * stride;
+  result->score = block + 8 * stride;
+  result->flags = (unsigned char *) (block + 9 * stride);
+
+  RiseSetTimes *moon = malloc (ndays * sizeof (RiseSetTimes));
+  if (!moon)
+    {
+    free (block);
+    memset (result, 0, sizeof (SolunarYear));
+    result->year = year;
+    return;
+    }
+
+  // Each day is given the time that parsing a date with no time gives
+  //  it, with the day of January carried into the following months, 
+  //  and its start is midnight on that date, as Solunar_get_day takes
+  //  it. The bounds are the starts of the days that --ndays steps 
+  //  through from 1 January, which can differ from midnight where the
+  //  clocks change. Working the time out from the bounds instead would
+  //  put it on the wrong date where a day starts at 23:00 on the one 
+  //  before
+  DateTimeFields fields;
+  memset (&fields, 0, sizeof (DateTimeFields));
+  fields.year = year;
+  fields.month = 1;
+  fields.has_year = TRUE;
+  fields.has_date = TRUE;
+
+  static const double zeniths[] = { SUNTIMES_DEFAULT_ZENITH, 
+    SUNTIMES_CIVIL_TWILIGHT };
+  DateTimeValue first_start = DateTimeValue_from_utime (0);
+  double first_start_jd = 0;
+  DateTimeValue value = first_start;
+
+  int i;
+  for (i = 0; i < ndays; i++)
+    {
+    unsigned char flags = 0;
+
+    fields.day = i + 1;
+    fields.hour = 0;
+    double start = DateTimeValue_get_modified_julian_date 
+      (DateTimeValue_from_utime (DateTimeFields_get_utime (&fields, tz, 
+      utc)));
+    fields.hour = SOLUNAR_YEAR_HOUR;
+    value = DateTimeValue_from_utime (DateTimeFields_get_utime 
+      (&fields, tz, utc));
+    double jd = DateTimeValue_get_julian_date (value);
+
+    // The bounds are measured from the first, as RiseSet_get_day_bounds
+    //  measures them
+    DateTimeValue day_start = DateTimeValue_get_day_start (value, tz);
+    if (i == 0)
+      {
+      first_start = day_start;
+      first_start_jd = DateTimeValue_get_julian_date (day_start);
+      }
+    result->day_start[i] = first_start_jd 
+      + DateTimeValue_seconds_difference (first_start, day_start) 
+      / 86400.0;
+
+    SunTimesDay sun[2];
+    SunTimes_get_day_jd (observer, (long) floor (jd - 2400000.5), 
+      zeniths, 2, sun);
+    result->sunrise[i] = sun[0].sunrise;
+    result->sunset[i] = sun[0].sunset;
+    result->dawn[i] = sun[1].sunrise;
+    result->dusk[i] = sun[1].sunset;
+    if (sun[0].sunrise_status != RISESET_OK) 
+      flags |= SOLUNAR_NO_SUNRISE 
+        | (sun[0].sunrise_status == RISESET_ALWAYS_ABOVE 
+        ? SOLUNAR_SUN_ALWAYS_UP : SOLUNAR_SUN_ALWAYS_DOWN);
+    if (sun[0].sunset_status != RISESET_OK) 
+      flags |= SOLUNAR_NO_SUNSET 
+        | (sun[0].sunset_status == RISESET_ALWAYS_ABOVE 
+        ? SOLUNAR_SUN_ALWAYS_UP : SOLUNAR_SUN_ALWAYS_DOWN);
+    if (sun[1].sunrise_status != RISESET_OK) flags |= SOLUNAR_NO_DAWN;
+    if (sun[1].sunset_status != RISESET_OK) flags |= SOLUNAR_NO_DUSK;
+
+    double age, distance;
+    MoonTimes_get_moon_state_jd (jd, &result->phase[i], &age, 
+      &distance);
+
+    SolunarDay day;
+    long peak_offsets [SOLUNAR_MAX_PEAKS];
+    solunar_score_day (observer, start, jd, &day, peak_offsets);
+    result->score[i] = day.overall_score;
+
+    result->flags[i] = flags;
+    }
+
+  // The last day ends where the day after it would start
+  DateTimeValue end = DateTimeValue_get_day_end (value, tz);
+  result->day_start[ndays] = first_start_jd 
+    + (DateTimeValue_seconds_difference (first_start, end) + 1) / 86400.0;
+
+  // The moon's events come from one search over the whole year, which
+  //  needs all the bounds, so they are filled in last
+  MoonTimes_get_times_range (observer, result->day_start, ndays,
+    MOONTIMES_DEFAULT_TOLERANCE, precision, cache, moon);
+  for (i = 0; i < ndays; i++)
+    {
+    if (moon[i].nrises > 0)
+      result->moonrise[i] = moon[i].rises[0];
+    else
+      {
+      result->flags[i] |= SOLUNAR_NO_MOONRISE;
+      result->moonrise[i] = NAN;
+      }
+    if (moon[i].nsets > 0)
+      result->moonset[i] = moon[i].sets[0];
+    else
+      {
+      result->flags[i] |= SOLUNAR_NO_MOONSET;
+      result->moonset[i] = NAN;
+      }
+    }
+  free (moon);
+  }
+
+
+/*=======================================================================
+Solunar_free_year
+Frees the arrays in a SolunarYear, but not the SolunarYear itself
+=======================================================================*/
+void Solunar_free_year (SolunarYear *year)
+  {
+  free (year->block);
+  year->block = NULL;
+  year->ndays = 0;
+  }
+
@@ -3,9 +3,76 @@ solunar
 solunar.h
 (c)2005-2013 Kevin Boone
 =======================================================================*/
+#pragma once
+
+#include "defs.h"
+#include "observer.h"
+#include "datetime.h"
+#include "moontimes.h"
+
+// The solunar table divides the day into half-hour periods
+#define SOLUNAR_PERIODS 48
+
+// Since there's only one sun, and it has at most four significant
+//  events (rise, set, under, over), there can't be more than four
+//  active solunar events
+#define SOLUNAR_MAX_PEAKS 4
+
+typedef struct _SolunarDay
+  {
+  double phase_score;
+  double distance_score;
+  DateTimeValue start; // Midnight at the start of the day
+  double sun_score [SOLUNAR_PERIODS];
+  double moon_score [SOLUNAR_PERIODS];
+  double combined_score [SOLUNAR_PERIODS];
+  double coincidence_score;
+  double overall_score;
+  int num_peaks;
+  DateTimeValue peaks [SOLUNAR_MAX_PEAKS];
+  } SolunarDay;
+
+// Flags for a day in a SolunarYear, each marking an event that the 
+//  day doesn't have. The sun is always up, or always down, when it 
+//  doesn't rise or set because of polar day or night
+#define SOLUNAR_NO_SUNRISE 0x01
+#define SOLUNAR_NO_SUNSET 0x02
+#define SOLUNAR_SUN_ALWAYS_UP 0x04
+#define SOLUNAR_SUN_ALWAYS_DOWN 0x08
+#define SOLUNAR_NO_DAWN 0x10
+#define SOLUNAR_NO_DUSK 0x20
+#define SOLUNAR_NO_MOONRISE 0x40
+#define SOLUNAR_NO_MOONSET 0x80
+
+/*=======================================================================
+SolunarYear
+The events and scores for each day of a year at one location, as 
+Solunar_compute_year works them out. Each array has an element for 
+each day, and starts on a cache line. Times are Julian dates, and an
+event that the day doesn't have, according to its flags, is NAN. 
+Dawn and dusk are the start and end of civil twilight; moonrise and
+moonset are the first of the day, if there are two. All the arrays
+are in one block, which Solunar_free_year frees
+=======================================================================*/
+typedef struct _SolunarYear
+  {
+  int year;
+  int ndays;
+  double *day_start; // Midnight at the start of each day
+  double *sunrise;
+  double *sunset;
+  double *dawn;
+  double *dusk;
+  double *moonrise;
+  double *moonset;
+  double *phase;
+  double *score; // The overall solunar score, from 0 to 1
+  unsigned char *flags;
+  void *block;
+  } SolunarYear;
 
 double Solunar_score_solar_sa (double sa, BOOL include_high_noon,
-    BOOL include_sun_underfoot, double max_sa, double min_sa);
+    BOOL include_sun_underfoot, double max_sa);
 
 double Solunar_score_moon (double la, double max_la, double min_la);
 
@@ -14,3 +81,12 @@ double Solunar_score_moon_phase (double phase);
 
 double Solunar_score_moon_distance (double distance);
 
+void Solunar_get_day (const Observer *observer, const DateTime *date,
+    const char *tz, BOOL utc, SolunarDay *result);
+
+void Solunar_compute_year (const Observer *observer, int year, 
+    const char *tz, BOOL utc, MoonTimesPrecision precision, 
+    EphemerisCache *cache, SolunarYear *result);
+
+void Solunar_free_year (SolunarYear *year);
+
@@ -5,27 +5,68 @@ suntimes.h
 =======================================================================*/
 #pragma once
 
-#include "latlong.h"
+#include "observer.h"
 #include "datetime.h"
 #include "error.h"
+#include "ephemeris.h"
+#include "riseset.h"
 
 #define SUNTIMES_DEFAULT_ZENITH (90.0 + 50.0/60.0)
 #define SUNTIMES_CIVIL_TWILIGHT (90 + 50.0/60.0 + 6)
 #define SUNTIMES_NAUTICAL_TWILIGHT (90 + 50.0/60.0 + 12)
 #define SUNTIMES_ASTRONOMICAL_TWILIGHT (90 + 50.0/60.0 + 18)
 
-DateTime *SunTimes_get_sunrise (const LatLong *workingLatlong, 
-  const DateTime *date, double zenith, const char *tz, Error **e);
-DateTime *SunTimes_get_sunset (const LatLong *workingLatlong, 
-  const DateTime *date, double zenith, const char *tz, Error **e);
+DateTime *SunTimes_get_sunrise (const Observer *observer, 
+  const DateTime *date, double zenith, Error **e);
+DateTime *SunTimes_get_sunset (const Observer *observer, 
+  const DateTime *date, double zenith, Error **e);
 
-DateTime *SunTimes_get_high_noon (const LatLong *latlong, 
-    const DateTime *date, const char *tz, Error **e);
+// The most zeniths that SunTimes_get_day_jd takes at once
+#define SUNTIMES_MAX_ZENITHS 4
+
+// The almanac sunrise and sunset on one day, for one zenith, as 
+//  Julian dates. A time is NAN when its status is not RISESET_OK
+typedef struct _SunTimesDay
+  {
+  double sunrise;
+  double sunset;
+  RiseSetStatus sunrise_status;
+  RiseSetStatus sunset_status;
+  } SunTimesDay;
+
+RiseSetStatus SunTimes_get_sunrise_jd (const Observer *observer, long day,
+    double zenith, double *jd);
+RiseSetStatus SunTimes_get_sunset_jd (const Observer *observer, long day,
+    double zenith, double *jd);
+
+void SunTimes_get_day_jd (const Observer *observer, long day,
+    const double *zeniths, int nzeniths, SunTimesDay *times);
+
+DateTime *SunTimes_get_high_noon (const Observer *observer, 
+    const DateTime *date, Error **e);
+
+void SunTimes_get_sun_events (const Observer *observer, 
+    const DateTime *start, const DateTime *end, double zenith, 
+    double tolerance, EphemerisCache *cache, RiseSetEvents *events);
+
+void SunTimes_get_sun_times (const Observer *observer, double start_jd,
+    double end_jd, double zenith, double tolerance, EphemerisCache *cache,
+    RiseSetTimes *times);
+
+void SunTimes_get_times_range (const Observer *observer, 
+    const double *bounds, int ndays, double zenith, double tolerance, 
+    EphemerisCache *cache, RiseSetTimes *days);
 
 void suntimes_getSolarRAandDec (double MJD, double *ra, double *dec);
 
-//double suntimes_getSinAltitude (double longitude, double latitude, double mjd);
+void SunTimes_get_position_array (const Observer *observer,
+    const double *mjd, int n, double *ra, double *dec, double *sin_alt);
+
+void SunTimes_get_sin_altitude_grid (const Observer *observer,
+    double mjd0, double step, int n, double *sin_alt);
+
+double suntimes_getSinAltitude (const Observer *observer, double mjd);
 
-double SunTimes_get_SA (const LatLong *latlong, 
+double SunTimes_get_SA (const Observer *observer, 
     const DateTime *datetime);
 
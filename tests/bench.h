@@ -0,0 +1,26 @@
+/*=======================================================================
+solunar
+tests/bench.h
+Timing for the benchmark programs in tests/
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#pragma once
+
+#include <time.h>
+
+// How many times each benchmark loop is repeated. The best time of
+//  the repeats is the one reported, which is the least disturbed by
+//  whatever else the machine is doing
+#define BENCH_REPEATS 5
+
+/*=======================================================================
+bench_seconds
+The time now, in seconds, from a clock that only moves forwards
+=======================================================================*/
+static inline double bench_seconds (void)
+  {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
@@ -0,0 +1,79 @@
+/*=======================================================================
+solunar
+tests/bench_moon.c
+Compares MoonTimes_get_lunar_ephemeris_array with the scalar 
+MoonTimes_get_lunar_ephemeris it stands in for: the time each takes
+for the same dates, and the largest difference between their results,
+which must be within the tolerance documented in moontimes.c
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "moontimes.h"
+#include "bench.h"
+
+#define BENCH_DATES 1000000
+// Dates are spread over about a century either side of 2000
+#define BENCH_FIRST_MJD 15000.0
+#define BENCH_STEP 0.073
+// The tolerances documented with MoonTimes_get_lunar_ephemeris_array
+#define BENCH_RA_TOLERANCE 1e-8
+#define BENCH_DEC_TOLERANCE 1e-12
+
+/*=======================================================================
+main
+=======================================================================*/
+int main (void)
+  {
+  double *mjd = malloc (BENCH_DATES * sizeof (double));
+  double *ra = malloc (BENCH_DATES * sizeof (double));
+  double *dec = malloc (BENCH_DATES * sizeof (double));
+  double *ra_array = malloc (BENCH_DATES * sizeof (double));
+  double *dec_array = malloc (BENCH_DATES * sizeof (double));
+  int i, r;
+  for (i = 0; i < BENCH_DATES; i++)
+    mjd[i] = BENCH_FIRST_MJD + i * BENCH_STEP;
+
+  double scalar = 1e30, array = 1e30;
+  for (r = 0; r < BENCH_REPEATS; r++)
+    {
+    double t = bench_seconds ();
+    for (i = 0; i < BENCH_DATES; i++)
+      MoonTimes_get_lunar_ephemeris (mjd[i], &ra[i], &dec[i]);
+    t = bench_seconds () - t;
+    if (t < scalar) scalar = t;
+
+    t = bench_seconds ();
+    MoonTimes_get_lunar_ephemeris_array (mjd, BENCH_DATES, ra_array, 
+      dec_array);
+    t = bench_seconds () - t;
+    if (t < array) array = t;
+    }
+
+  double max_ra = 0, max_dec = 0;
+  for (i = 0; i < BENCH_DATES; i++)
+    {
+    double d_ra = fabs (ra[i] - ra_array[i]);
+    // RA wraps at 24 hours
+    if (d_ra > 12) d_ra = 24 - d_ra;
+    double d_dec = fabs (dec[i] - dec_array[i]);
+    if (d_ra > max_ra) max_ra = d_ra;
+    if (d_dec > max_dec) max_dec = d_dec;
+    }
+
+  BOOL ok = max_ra <= BENCH_RA_TOLERANCE && max_dec <= BENCH_DEC_TOLERANCE;
+  printf ("bench_moon: lunar ephemeris for %d dates\n", BENCH_DATES);
+  printf ("  scalar %.3lf s, array %.3lf s, speedup %.2lfx\n", 
+    scalar, array, scalar / array);
+  printf ("  largest difference: RA %.2le h, dec %.2le deg: %s\n", 
+    max_ra, max_dec, ok ? "OK" : "FAILED");
+
+  free (dec_array);
+  free (ra_array);
+  free (dec);
+  free (ra);
+  free (mjd);
+  return ok ? 0 : 1;
+  }
+
@@ -0,0 +1,196 @@
+/*=======================================================================
+solunar
+tests/bench_precision.c
+Measures the moon's precision tiers against each other: how far the
+fast and standard series are from the high one, in position and in
+the times of moonrise and moonset, and how long each series takes.
+The errors must be within the bounds documented with each tier's
+function in moontimes.c
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "defs.h"
+#include "observer.h"
+#include "moontimes.h"
+#include "riseset.h"
+#include "bench.h"
+
+// Positions are compared, and timed, at BENCH_DATES dates spread
+//  evenly over 1900-2100
+#define BENCH_DATES 200000
+#define BENCH_FIRST_MJD 15020.0
+#define BENCH_LAST_MJD 88069.0
+// Rises and sets are compared on BENCH_DAYS days over the same
+//  period, at each of the latitudes in bench_latitudes
+#define BENCH_DAYS 400
+#define BENCH_TIERS 3
+
+static const double bench_latitudes[] = { 0, 30, -35, 45, 52, 60 };
+#define BENCH_PLACES (int)(sizeof (bench_latitudes) / sizeof (double))
+
+typedef void (*BenchSeries) (double mjd, double *ra, double *dec);
+
+/*=======================================================================
+BenchTier
+One series, with the bounds on its error documented in moontimes.c.
+The position bounds are in degrees, and the rise and set bounds in
+seconds. moontimes.c gives the average error in rise and set times
+only roughly, so mean_event allows a little over the figure it gives
+=======================================================================*/
+typedef struct _BenchTier
+  {
+  MoonTimesPrecision precision;
+  BenchSeries series;
+  double max_ra;
+  double max_dec;
+  double max_event;
+  double mean_event;
+  } BenchTier;
+
+static const BenchTier bench_tiers [BENCH_TIERS] =
+  {
+  { MOONTIMES_PRECISION_FAST, MoonTimes_get_lunar_ephemeris_fast,
+    0.4, 0.3, 300, 40 },
+  { MOONTIMES_PRECISION_STANDARD, MoonTimes_get_lunar_ephemeris,
+    0.11, 0.05, 45, 6 },
+  { MOONTIMES_PRECISION_HIGH, MoonTimes_get_lunar_ephemeris_high,
+    0, 0, 0, 0 }
+  };
+
+
+/*=======================================================================
+bench_match
+Add to *max, *total, and *count the differences, in seconds, between
+each time in 'times' and the nearest one in 'high'. A time with
+nothing within an hour of it in 'high' is one that the two series
+put either side of the start or end of the day, and is left out
+=======================================================================*/
+static void bench_match (const double *times, int n, const double *high,
+    int nhigh, double *max, double *total, int *count)
+  {
+  int i, j;
+  for (i = 0; i < n; i++)
+    {
+    double best = 1e30;
+    for (j = 0; j < nhigh; j++)
+      {
+      double d = fabs (times[i] - high[j]) * 86400.0;
+      if (d < best) best = d;
+      }
+    if (best > 3600.0) continue;
+    if (best > *max) *max = best;
+    *total += best;
+    (*count)++;
+    }
+  }
+
+
+/*=======================================================================
+main
+=======================================================================*/
+int main (void)
+  {
+  double *mjd = malloc (BENCH_DATES * sizeof (double));
+  double *ra = malloc (BENCH_TIERS * BENCH_DATES * sizeof (double));
+  double *dec = malloc (BENCH_TIERS * BENCH_DATES * sizeof (double));
+  double step = (BENCH_LAST_MJD - BENCH_FIRST_MJD) / BENCH_DATES;
+  int i, t, r, p;
+  for (i = 0; i < BENCH_DATES; i++)
+    mjd[i] = BENCH_FIRST_MJD + i * step;
+
+  double seconds [BENCH_TIERS];
+  for (t = 0; t < BENCH_TIERS; t++)
+    {
+    double *tra = ra + t * BENCH_DATES, *tdec = dec + t * BENCH_DATES;
+    seconds[t] = 1e30;
+    for (r = 0; r < BENCH_REPEATS; r++)
+      {
+      double s = bench_seconds ();
+      for (i = 0; i < BENCH_DATES; i++)
+        bench_tiers[t].series (mjd[i], &tra[i], &tdec[i]);
+      s = bench_seconds () - s;
+      if (s < seconds[t]) seconds[t] = s;
+      }
+    }
+
+  // The high tier's rises and sets, which the others are compared with
+  RiseSetTimes *high = malloc (BENCH_PLACES * BENCH_DAYS
+    * sizeof (RiseSetTimes));
+  double day_step = floor ((BENCH_LAST_MJD - BENCH_FIRST_MJD) / BENCH_DAYS);
+  for (p = 0; p < BENCH_PLACES; p++)
+    {
+    Observer observer;
+    Observer_init (&observer, 0, bench_latitudes[p]);
+    for (i = 0; i < BENCH_DAYS; i++)
+      {
+      double start = BENCH_FIRST_MJD + i * day_step + 2400000.5;
+      MoonTimes_get_moon_times (&observer, start, start + 1,
+        MOONTIMES_DEFAULT_TOLERANCE, MOONTIMES_PRECISION_HIGH, NULL,
+        &high[p * BENCH_DAYS + i]);
+      }
+    }
+
+  BOOL ok = TRUE;
+  const BenchTier *h = &bench_tiers[BENCH_TIERS - 1];
+  for (t = 0; t < BENCH_TIERS; t++)
+    {
+    const BenchTier *tier = &bench_tiers[t];
+    const char *name = MoonTimes_get_precision_name (tier->precision);
+    printf ("bench_precision: %s: %.0f ns per position (%.2fx standard)\n",
+      name, seconds[t] / BENCH_DATES * 1e9, seconds[t] / seconds[1]);
+    if (tier == h) continue;
+
+    const double *tra = ra + t * BENCH_DATES, *tdec = dec + t * BENCH_DATES;
+    const double *hra = ra + (h - bench_tiers) * BENCH_DATES;
+    const double *hdec = dec + (h - bench_tiers) * BENCH_DATES;
+    double max_ra = 0, max_dec = 0;
+    for (i = 0; i < BENCH_DATES; i++)
+      {
+      double d_ra = fabs (tra[i] - hra[i]);
+      // RA wraps at 24 hours, and is measured on the sky
+      if (d_ra > 12) d_ra = 24 - d_ra;
+      d_ra *= 15.0 * cos (hdec[i] * M_PI / 180.0);
+      double d_dec = fabs (tdec[i] - hdec[i]);
+      if (d_ra > max_ra) max_ra = d_ra;
+      if (d_dec > max_dec) max_dec = d_dec;
+      }
+
+    double max_event = 0, total = 0;
+    int count = 0;
+    for (p = 0; p < BENCH_PLACES; p++)
+      {
+      Observer observer;
+      Observer_init (&observer, 0, bench_latitudes[p]);
+      for (i = 0; i < BENCH_DAYS; i++)
+        {
+        const RiseSetTimes *ht = &high[p * BENCH_DAYS + i];
+        RiseSetTimes times;
+        double start = BENCH_FIRST_MJD + i * day_step + 2400000.5;
+        MoonTimes_get_moon_times (&observer, start, start + 1,
+          MOONTIMES_DEFAULT_TOLERANCE, tier->precision, NULL, &times);
+        bench_match (times.rises, times.nrises, ht->rises, ht->nrises,
+          &max_event, &total, &count);
+        bench_match (times.sets, times.nsets, ht->sets, ht->nsets,
+          &max_event, &total, &count);
+        }
+      }
+    double mean_event = count ? total / count : 0;
+
+    BOOL tier_ok = max_ra <= tier->max_ra && max_dec <= tier->max_dec
+      && max_event <= tier->max_event && mean_event <= tier->mean_event;
+    printf ("bench_precision: %s: from high, RA %.3f, dec %.3f degrees, "
+      "rise/set %.0f s at most, %.1f s on average (%d events): %s\n",
+      name, max_ra, max_dec, max_event, mean_event, count,
+      tier_ok ? "OK" : "FAILED");
+    if (!tier_ok) ok = FALSE;
+    }
+
+  free (high);
+  free (dec);
+  free (ra);
+  free (mjd);
+  return ok ? 0 : 1;
+  }
+
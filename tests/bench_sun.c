@@ -0,0 +1,107 @@
+/*=======================================================================
+solunar
+tests/bench_sun.c
+Compares SunTimes_get_position_array with the scalar 
+suntimes_getSolarRAandDec and suntimes_getSinAltitude it stands in 
+for, over a year of dates a minute apart: the time each takes, and 
+the largest difference between their results, which must be within
+the tolerance documented in suntimes.c
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "observer.h"
+#include "suntimes.h"
+#include "bench.h"
+
+// A minute apart for a year, from the start of 2024
+#define BENCH_DATES (366 * 1440)
+#define BENCH_FIRST_MJD 60310.0
+#define BENCH_STEP (1.0 / 1440.0)
+// The tolerances documented with SunTimes_get_position_array
+#define BENCH_RA_TOLERANCE 1e-9
+#define BENCH_DEC_TOLERANCE 1e-12
+#define BENCH_SIN_ALT_TOLERANCE 1e-10
+
+/*=======================================================================
+main
+=======================================================================*/
+int main (void)
+  {
+  Observer observer;
+  // London
+  Observer_init (&observer, -0.1275, 51.5072);
+
+  double *mjd = malloc (BENCH_DATES * sizeof (double));
+  double *ra = malloc (BENCH_DATES * sizeof (double));
+  double *dec = malloc (BENCH_DATES * sizeof (double));
+  double *sin_alt = malloc (BENCH_DATES * sizeof (double));
+  double *ra_array = malloc (BENCH_DATES * sizeof (double));
+  double *dec_array = malloc (BENCH_DATES * sizeof (double));
+  double *sin_alt_array = malloc (BENCH_DATES * sizeof (double));
+  int i, r;
+  for (i = 0; i < BENCH_DATES; i++)
+    mjd[i] = BENCH_FIRST_MJD + i * BENCH_STEP;
+
+  double scalar = 1e30, array = 1e30, curve = 1e30;
+  for (r = 0; r < BENCH_REPEATS; r++)
+    {
+    double t = bench_seconds ();
+    for (i = 0; i < BENCH_DATES; i++)
+      {
+      suntimes_getSolarRAandDec (mjd[i], &ra[i], &dec[i]);
+      sin_alt[i] = suntimes_getSinAltitude (&observer, mjd[i]);
+      }
+    t = bench_seconds () - t;
+    if (t < scalar) scalar = t;
+
+    t = bench_seconds ();
+    SunTimes_get_position_array (&observer, mjd, BENCH_DATES, ra_array,
+      dec_array, sin_alt_array);
+    t = bench_seconds () - t;
+    if (t < array) array = t;
+
+    // The sine altitude alone, which is all a curve of the sun's 
+    //  height needs
+    t = bench_seconds ();
+    SunTimes_get_position_array (&observer, mjd, BENCH_DATES, NULL,
+      NULL, sin_alt_array);
+    t = bench_seconds () - t;
+    if (t < curve) curve = t;
+    }
+
+  double max_ra = 0, max_dec = 0, max_sin_alt = 0;
+  for (i = 0; i < BENCH_DATES; i++)
+    {
+    double d_ra = fabs (ra[i] - ra_array[i]);
+    // RA wraps at 24 hours
+    if (d_ra > 12) d_ra = 24 - d_ra;
+    double d_dec = fabs (dec[i] - dec_array[i]);
+    double d_sin_alt = fabs (sin_alt[i] - sin_alt_array[i]);
+    if (d_ra > max_ra) max_ra = d_ra;
+    if (d_dec > max_dec) max_dec = d_dec;
+    if (d_sin_alt > max_sin_alt) max_sin_alt = d_sin_alt;
+    }
+
+  BOOL ok = max_ra <= BENCH_RA_TOLERANCE && max_dec <= BENCH_DEC_TOLERANCE
+    && max_sin_alt <= BENCH_SIN_ALT_TOLERANCE;
+  printf ("bench_sun: solar position for a year, a minute apart "
+    "(%d dates)\n", BENCH_DATES);
+  printf ("  scalar %.1lf ms, array %.1lf ms, speedup %.2lfx\n", 
+    scalar * 1000, array * 1000, scalar / array);
+  printf ("  array, sine altitude only: %.1lf ms\n", curve * 1000);
+  printf ("  largest difference: RA %.2le h, dec %.2le deg, "
+    "sin alt %.2le: %s\n", max_ra, max_dec, max_sin_alt, 
+    ok ? "OK" : "FAILED");
+
+  free (sin_alt_array);
+  free (dec_array);
+  free (ra_array);
+  free (sin_alt);
+  free (dec);
+  free (ra);
+  free (mjd);
+  return ok ? 0 : 1;
+  }
+
@@ -0,0 +1,159 @@
+/*=======================================================================
+solunar
+tests/bench_trig.c
+Times the ways trigutil.c offers of getting the sine and cosine of 
+the same angle: sinDeg and cosDeg separately, sincosDeg, and the fast
+polynomial sincosDegFast, and, for arrays of angles in radians, the
+C library against sinArray and cosArray. The accuracy of each is 
+checked by tests/test_trig.c
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "trigutil.h"
+#include "bench.h"
+
+#define BENCH_ANGLES 2000000
+// Degrees, over the range that the sun's and moon's arguments cover
+#define BENCH_RANGE 720.0
+
+// Each result is added to this, so the work can't be optimized away
+static volatile double bench_sink;
+// Where the array functions write their results
+static double *bench_out;
+static double *bench_out2;
+
+
+/*=======================================================================
+bench_best
+Run 'func' BENCH_REPEATS times over the angles, and return the best
+time
+=======================================================================*/
+static double bench_best (double (*func) (const double *, int), 
+    const double *deg, int n)
+  {
+  double best = 1e30;
+  int r;
+  for (r = 0; r < BENCH_REPEATS; r++)
+    {
+    double t = bench_seconds ();
+    bench_sink += func (deg, n);
+    t = bench_seconds () - t;
+    if (t < best) best = t;
+    }
+  return best;
+  }
+
+/*=======================================================================
+bench_separate
+sinDeg and cosDeg of each angle, called separately
+=======================================================================*/
+static double bench_separate (const double *deg, int n)
+  {
+  double sum = 0;
+  int i;
+  for (i = 0; i < n; i++)
+    sum += sinDeg (deg[i]) + cosDeg (deg[i]);
+  return sum;
+  }
+
+
+/*=======================================================================
+bench_sincos
+sincosDeg of each angle
+=======================================================================*/
+static double bench_sincos (const double *deg, int n)
+  {
+  double sum = 0, s, c;
+  int i;
+  for (i = 0; i < n; i++)
+    {
+    sincosDeg (deg[i], &s, &c);
+    sum += s + c;
+    }
+  return sum;
+  }
+
+
+/*=======================================================================
+bench_sincos_fast
+sincosDegFast of each angle
+=======================================================================*/
+static double bench_sincos_fast (const double *deg, int n)
+  {
+  double sum = 0, s, c;
+  int i;
+  for (i = 0; i < n; i++)
+    {
+    sincosDegFast (deg[i], &s, &c);
+    sum += s + c;
+    }
+  return sum;
+  }
+
+
+/*=======================================================================
+bench_libm_array
+The C library's sin and cos of each angle in radians, added, into
+bench_out
+=======================================================================*/
+static double bench_libm_array (const double *rad, int n)
+  {
+  int i;
+  for (i = 0; i < n; i++)
+    bench_out[i] = sin (rad[i]) + cos (rad[i]);
+  return bench_out[n / 2];
+  }
+
+
+/*=======================================================================
+bench_array
+sinArray and cosArray of the angles in radians, into bench_out and
+bench_out2
+=======================================================================*/
+static double bench_array (const double *rad, int n)
+  {
+  sinArray (rad, bench_out, n);
+  cosArray (rad, bench_out2, n);
+  return bench_out[n / 2] + bench_out2[n / 2];
+  }
+
+
+/*=======================================================================
+main
+=======================================================================*/
+int main (void)
+  {
+  double *deg = malloc (BENCH_ANGLES * sizeof (double));
+  double *rad = malloc (BENCH_ANGLES * sizeof (double));
+  bench_out = malloc (BENCH_ANGLES * sizeof (double));
+  bench_out2 = malloc (BENCH_ANGLES * sizeof (double));
+  int i;
+  for (i = 0; i < BENCH_ANGLES; i++)
+    {
+    deg[i] = -BENCH_RANGE + 2 * BENCH_RANGE * i / BENCH_ANGLES;
+    rad[i] = deg[i] * M_PI / 180.0;
+    }
+
+  double separate = bench_best (bench_separate, deg, BENCH_ANGLES);
+  double sincos = bench_best (bench_sincos, deg, BENCH_ANGLES);
+  double fast = bench_best (bench_sincos_fast, deg, BENCH_ANGLES);
+  double libm_array = bench_best (bench_libm_array, rad, BENCH_ANGLES);
+  double array = bench_best (bench_array, rad, BENCH_ANGLES);
+
+  printf ("bench_trig: sine and cosine of %d angles, ns per angle\n", 
+    BENCH_ANGLES);
+  printf ("  sinDeg + cosDeg %.1lf, sincosDeg %.1lf, sincosDegFast %.1lf\n",
+    separate * 1e9 / BENCH_ANGLES, sincos * 1e9 / BENCH_ANGLES,
+    fast * 1e9 / BENCH_ANGLES);
+  printf ("  sin + cos %.1lf, sinArray + cosArray %.1lf\n", 
+    libm_array * 1e9 / BENCH_ANGLES, array * 1e9 / BENCH_ANGLES);
+
+  free (bench_out2);
+  free (bench_out);
+  free (rad);
+  free (deg);
+  return 0;
+  }
+
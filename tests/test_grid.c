@@ -0,0 +1,150 @@
+/*=======================================================================
+solunar
+tests/test_grid.c
+Checks that the functions that step the sun's and moon's altitudes,
+and the sidereal time, along a uniform grid of times agree with the
+functions that work out each time from scratch, to within the 
+tolerances documented in suntimes.c, moontimes.c, and timeutil.c. The
+grids cover places at high and low latitudes, on either side of the 
+date line, and steps from a minute to a few hours
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "defs.h"
+#include "observer.h"
+#include "suntimes.h"
+#include "moontimes.h"
+#include "timeutil.h"
+
+// Long enough for several blocks, and a partial block at the end
+#define TEST_POINTS 1000
+// The documented tolerances, for steps of up to TEST_SHORT_STEP, and
+//  for longer ones, which cross more 0h UT jumps in the sidereal time
+//  formula between anchors
+#define TEST_SHORT_STEP (30.0 / 1440.0)
+#define TEST_SIN_ALT_TOLERANCE 1e-9
+#define TEST_SIN_ALT_TOLERANCE_LONG 1e-8
+#define TEST_LMST_TOLERANCE 5e-9
+#define TEST_LMST_TOLERANCE_LONG 2e-8
+
+typedef struct _TestPlace
+  {
+  const char *name;
+  double longitude;
+  double latitude;
+  } TestPlace;
+
+static const TestPlace test_places[] = 
+  {
+  {"London", -0.1275, 51.5072},
+  {"Tromso", 18.9553, 69.6492},
+  {"Quito", -78.4678, -0.1807},
+  {"Auckland", 174.7633, -36.8485},
+  {"Anchorage", -149.9003, 61.2181},
+  {"McMurdo", 166.6667, -77.85},
+  };
+
+// In days: a minute, a quarter-hour, as the moon's scans use, a half
+//  hour, as the solunar table uses, and a little over three hours
+static const double test_steps[] = 
+  {
+  1.0 / 1440.0, 15.0 / 1440.0, 30.0 / 1440.0, 0.13
+  };
+
+// Modified Julian dates of the first time on each grid, some of them
+//  not on a whole day
+static const double test_starts[] = 
+  {
+  51544.5, 60310.0, 60310.3701, 44239.91, 73000.25
+  };
+
+#define TEST_COUNT(a) ((int) (sizeof (a) / sizeof (a[0])))
+
+
+/*=======================================================================
+test_max_difference
+=======================================================================*/
+static double test_max_difference (const double *a, const double *b, 
+    int n, double wrap)
+  {
+  double max = 0;
+  int i;
+  for (i = 0; i < n; i++)
+    {
+    double d = fabs (a[i] - b[i]);
+    if (wrap > 0 && d > wrap / 2) d = wrap - d;
+    if (d > max) max = d;
+    }
+  return max;
+  }
+
+
+/*=======================================================================
+main
+=======================================================================*/
+int main (void)
+  {
+  static double mjd [TEST_POINTS];
+  static double expected [TEST_POINTS];
+  static double grid [TEST_POINTS];
+  // The largest differences for short steps, and for long ones
+  double max_sun[2] = {0, 0}, max_moon[2] = {0, 0}, max_lmst[2] = {0, 0};
+  int p, s, t, i;
+
+  for (p = 0; p < TEST_COUNT (test_places); p++)
+    {
+    Observer observer;
+    Observer_init (&observer, test_places[p].longitude, 
+      test_places[p].latitude);
+    for (s = 0; s < TEST_COUNT (test_steps); s++)
+      {
+      for (t = 0; t < TEST_COUNT (test_starts); t++)
+        {
+        double mjd0 = test_starts[t];
+        double step = test_steps[s];
+        int k = step > TEST_SHORT_STEP;
+        for (i = 0; i < TEST_POINTS; i++)
+          mjd[i] = mjd0 + i * step;
+
+        SunTimes_get_position_array (&observer, mjd, TEST_POINTS, 
+          NULL, NULL, expected);
+        SunTimes_get_sin_altitude_grid (&observer, mjd0, step, 
+          TEST_POINTS, grid);
+        double d = test_max_difference (expected, grid, TEST_POINTS, 0);
+        if (d > max_sun[k]) max_sun[k] = d;
+
+        MoonTimes_get_sin_altitude_array (&observer, mjd, TEST_POINTS, 
+          expected);
+        MoonTimes_get_sin_altitude_grid (&observer, mjd0, step, 
+          TEST_POINTS, grid);
+        d = test_max_difference (expected, grid, TEST_POINTS, 0);
+        if (d > max_moon[k]) max_moon[k] = d;
+
+        for (i = 0; i < TEST_POINTS; i++)
+          expected[i] = timeutil_lmst_hours (mjd[i], 
+            observer.longitude_hours);
+        timeutil_lmst_grid (mjd0, step, TEST_POINTS, 
+          observer.longitude_hours, grid);
+        d = test_max_difference (expected, grid, TEST_POINTS, 24.0);
+        if (d > max_lmst[k]) max_lmst[k] = d;
+        }
+      }
+    }
+
+  BOOL ok = max_sun[0] <= TEST_SIN_ALT_TOLERANCE 
+    && max_moon[0] <= TEST_SIN_ALT_TOLERANCE
+    && max_lmst[0] <= TEST_LMST_TOLERANCE
+    && max_sun[1] <= TEST_SIN_ALT_TOLERANCE_LONG
+    && max_moon[1] <= TEST_SIN_ALT_TOLERANCE_LONG
+    && max_lmst[1] <= TEST_LMST_TOLERANCE_LONG;
+  printf ("test_grid: largest difference, short steps: sun sin alt %.2le, "
+    "moon sin alt %.2le, LMST %.2le h\n", max_sun[0], max_moon[0], 
+    max_lmst[0]);
+  printf ("test_grid: largest difference, long steps: sun sin alt %.2le, "
+    "moon sin alt %.2le, LMST %.2le h: %s\n", max_sun[1], max_moon[1], 
+    max_lmst[1], ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+  }
+
@@ -0,0 +1,246 @@
+/*=======================================================================
+solunar
+tests/test_threads.c
+Checks that the library gives the same results when many threads use
+it at once as when one thread does. Every thread works through a
+matrix of cities and dates, each with its own SolunarContext and
+ephemeris cache, and each result is compared, byte for byte, with the one worked out afterwards
+on the main thread. The threads run first, while the zone cache is
+still empty, and neighbouring results are for different cities, so
+the threads load and publish zones at the same time
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "defs.h"
+#include "error.h"
+#include "city.h"
+#include "latlong.h"
+#include "datetime.h"
+#include "suntimes.h"
+#include "moontimes.h"
+#include "riseset.h"
+#include "solunar.h"
+#include "context.h"
+#include "ephemeris.h"
+
+#define TEST_THREADS 8
+// Every TEST_CITY_STEP'th city is used, on each of TEST_DAYS dates,
+//  TEST_DAY_STEP days apart, so that the dates cover all the seasons
+#define TEST_CITY_STEP 2
+#define TEST_DAYS 24
+#define TEST_DAY_STEP 15
+// 02:00 UTC on 1 January 2024
+#define TEST_FIRST_JD (2460310.5 + 2.0 / 24.0)
+#define TEST_STRING 32
+
+/*=======================================================================
+TestResult
+Everything worked out for one city and date. It is cleared before it
+is filled in, so that results can be compared with memcmp(). Times are
+kept as the strings the report would print
+=======================================================================*/
+typedef struct _TestResult
+  {
+  char sunrise [TEST_STRING];
+  char sunset [TEST_STRING];
+  char moonrises [RISESET_MAX_EVENTS][TEST_STRING];
+  char moonsets [RISESET_MAX_EVENTS][TEST_STRING];
+  double phase;
+  double age;
+  double distance;
+  double sun_score [SOLUNAR_PERIODS];
+  double moon_score [SOLUNAR_PERIODS];
+  double overall_score;
+  char peaks [SOLUNAR_MAX_PEAKS][TEST_STRING];
+  char stars [SOLUNAR_STARS + 1];
+  char date [TEST_STRING];
+  } TestResult;
+
+typedef struct _TestRun
+  {
+  const City **cities;
+  int ncities;
+  int nresults;
+  TestResult *results;
+  int next;
+  pthread_mutex_t lock;
+  } TestRun;
+
+
+/*=======================================================================
+test_copy
+Copy a string that the library allocated into a result, and free it
+=======================================================================*/
+static void test_copy (char *dest, char *s)
+  {
+  if (!s) return;
+  strncpy (dest, s, TEST_STRING - 1);
+  free (s);
+  }
+
+
+/*=======================================================================
+test_copy_time
+Format an event in the context's time zone, and free it. A NULL event
+(a sun that does not rise, for example) leaves the string empty
+=======================================================================*/
+static void test_copy_time (const SolunarContext *ctx, char *dest,
+    DateTime *event, Error *e)
+  {
+  if (event)
+    {
+    test_copy (dest, SolunarContext_time_to_string (ctx, event));
+    DateTime_free (event);
+    }
+  if (e) Error_free (e);
+  }
+
+
+/*=======================================================================
+test_compute
+Work out result 'index' of the matrix, as the report and batch modes
+would, using the caller's ephemeris cache. Consecutive indexes are for
+different cities
+=======================================================================*/
+static void test_compute (const TestRun *run, int index,
+    EphemerisCache *cache, TestResult *result)
+  {
+  const City *city = run->cities[index % run->ncities];
+  int day = index / run->ncities;
+  memset (result, 0, sizeof (TestResult));
+
+  SolunarContext ctx;
+  SolunarContext_init (&ctx, city->name, FALSE, FALSE);
+  LatLong *latlong = City_get_latlong (city);
+  DateTime *datetime = DateTime_new_julian
+    (TEST_FIRST_JD + day * TEST_DAY_STEP);
+  SolunarContext_set_location (&ctx, latlong);
+  ctx.datetime = datetime;
+  ctx.ephemeris = cache;
+
+  Error *e = NULL;
+  DateTime *event = SunTimes_get_sunrise (&ctx.observer, datetime,
+    SUNTIMES_DEFAULT_ZENITH, &e);
+  test_copy_time (&ctx, result->sunrise, event, e);
+  e = NULL;
+  event = SunTimes_get_sunset (&ctx.observer, datetime,
+    SUNTIMES_DEFAULT_ZENITH, &e);
+  test_copy_time (&ctx, result->sunset, event, e);
+
+  DateTime *start = DateTime_get_day_start (datetime, ctx.tz);
+  DateTime *end = DateTime_get_day_end (datetime, ctx.tz);
+  RiseSetEvents events;
+  RiseSetEvents_init (&events);
+  MoonTimes_get_moon_events (&ctx.observer, start, end,
+    MOONTIMES_DEFAULT_TOLERANCE, ctx.precision, cache, &events);
+  int i;
+  for (i = 0; i < events.nrises; i++)
+    test_copy (result->moonrises[i],
+      SolunarContext_time_to_string (&ctx, events.rises[i]));
+  for (i = 0; i < events.nsets; i++)
+    test_copy (result->moonsets[i],
+      SolunarContext_time_to_string (&ctx, events.sets[i]));
+  RiseSetEvents_clear (&events);
+  test_copy (result->date, SolunarContext_date_to_string (&ctx, start));
+  DateTime_free (start);
+  DateTime_free (end);
+
+  MoonTimes_get_moon_state (datetime, &result->phase, &result->age,
+    &result->distance);
+
+  SolunarDay sd;
+  Solunar_get_day (&ctx.observer, datetime, ctx.tz, ctx.utc, &sd);
+  memcpy (result->sun_score, sd.sun_score, sizeof (sd.sun_score));
+  memcpy (result->moon_score, sd.moon_score, sizeof (sd.moon_score));
+  result->overall_score = sd.overall_score;
+  DateTimeFormatter formatter;
+  SolunarContext_init_formatter (&ctx, &formatter);
+  for (i = 0; i < sd.num_peaks; i++)
+    DateTimeValue_format_time (sd.peaks[i], &formatter, result->peaks[i]);
+  strcpy (result->stars, SolunarContext_get_stars (&ctx, sd.overall_score));
+
+  DateTime_free (datetime);
+  LatLong_free (latlong);
+  }
+
+
+/*=======================================================================
+test_worker
+Take unclaimed results from the matrix until there are none left
+=======================================================================*/
+static void *test_worker (void *arg)
+  {
+  TestRun *run = arg;
+  EphemerisCache *cache = EphemerisCache_new (NULL);
+  while (1)
+    {
+    pthread_mutex_lock (&run->lock);
+    int i = run->next++;
+    pthread_mutex_unlock (&run->lock);
+    if (i >= run->nresults) break;
+    test_compute (run, i, cache, &run->results[i]);
+    }
+  EphemerisCache_free (cache);
+  return NULL;
+  }
+
+
+/*=======================================================================
+main
+=======================================================================*/
+int main (void)
+  {
+  TestRun run;
+  memset (&run, 0, sizeof (TestRun));
+  pthread_mutex_init (&run.lock, NULL);
+
+  int ncities = 0;
+  while (cities[ncities].name) ncities++;
+  run.cities = malloc (ncities * sizeof (City *));
+  int i;
+  for (i = 0; i < ncities; i += TEST_CITY_STEP)
+    run.cities[run.ncities++] = &cities[i];
+  run.nresults = run.ncities * TEST_DAYS;
+
+  // The multi-threaded pass, which starts with nothing cached
+  run.results = malloc (run.nresults * sizeof (TestResult));
+  pthread_t threads [TEST_THREADS];
+  int started = 0;
+  for (i = 0; i < TEST_THREADS; i++)
+    if (pthread_create (&threads[started], NULL, test_worker, &run) == 0)
+      started++;
+  for (i = 0; i < started; i++)
+    pthread_join (threads[i], NULL);
+  if (started == 0) test_worker (&run);
+
+  // The single-threaded pass
+  TestResult *expected = malloc (run.nresults * sizeof (TestResult));
+  EphemerisCache *cache = EphemerisCache_new (NULL);
+  for (i = 0; i < run.nresults; i++)
+    test_compute (&run, i, cache, &expected[i]);
+  EphemerisCache_free (cache);
+
+  int failures = 0;
+  for (i = 0; i < run.nresults; i++)
+    {
+    if (memcmp (&expected[i], &run.results[i], sizeof (TestResult)) != 0)
+      {
+      if (failures < 10)
+        fprintf (stderr, "test_threads: %s, day %d differs\n",
+          run.cities[i % run.ncities]->name, i / run.ncities);
+      failures++;
+      }
+    }
+
+  printf ("test_threads: %d results on %d threads: %s\n", run.nresults,
+    started, failures ? "FAILED" : "OK");
+
+  free (run.results);
+  free (expected);
+  free (run.cities);
+  pthread_mutex_destroy (&run.lock);
+  return failures ? 1 : 0;
+  }
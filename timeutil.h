@@ -7,6 +7,7 @@ Various functions for handling time and date
 #pragma once
 
 #include <time.h>
+#include <stdint.h>
 #include "defs.h" 
 
 #define SECONDS_PER_DAY 86400
@@ -33,6 +34,26 @@ Various functions for handling time and date
 default or the setting of the TZ environment variable */
 
 
+// The civil calendar core. Days are counted from 1970-01-01, and 
+//  seconds from 1970-01-01 00:00 UTC, in 64 bits, in the proleptic 
+//  Gregorian calendar. None of these calls the C library
+
+// a / b, rounded towards minus infinity
+extern int64_t timeutil_floor_div (int64_t a, int64_t b);
+
+extern int64_t timeutil_days_from_civil (int64_t year, int month, int day);
+
+extern void timeutil_civil_from_days (int64_t days, int64_t *year, 
+  int *month, int *day);
+
+// Out-of-range fields are carried, as mktime() does
+extern int64_t timeutil_civil_to_unix (int64_t year, int month, int day,
+  int hour, int min, int sec);
+
+// Any of the pointers may be NULL
+extern void timeutil_unix_to_civil (int64_t t, int64_t *year, int *month,
+  int *day, int *hour, int *min, int *sec);
+
 extern time_t timeutil_getMidnightLocal (int year, int month, const int day);
 
 extern time_t timeutil_get3AMLocal (int year, int month, int day);
@@ -44,6 +65,18 @@ extern time_t timeutil_makeTimeGMT (int year, int month, int day, double hours);
 
 // Local mean sidereal time. Longitude is +ve to the east
 extern double timeutil_lmst (double mjd, double longitude);
+extern double timeutil_lmst_hours (double mjd, double longitude_hours);
+
+// Sidereal hours that pass in an hour of mean solar time
+#define TIMEUTIL_SIDEREAL_RATE 1.0027379093
+
+// Local mean sidereal time, in hours, at each of n times 'step' days 
+//  apart, starting at mjd0. Longitude is in hours, +ve to the east
+extern void timeutil_lmst_grid (double mjd0, double step, int n, 
+  double longitude_hours, double *lmst);
+
+// Dynamical time less universal time, in seconds, at a julian date
+extern double timeutil_delta_t (double jd);
 
 extern int timeutil_getDayOfYear (int year, int month, int day);
 
@@ -53,6 +86,9 @@ double timeutil_unix_to_MJD (time_t t);
 /* Get the unix time as a julian date */
 double timeutil_unix_to_JD (time_t t);
 
+/* Get the julian date as a unix time, to the nearest second */
+time_t timeutil_JD_to_unix (double jd);
+
 /* Convert julian to modified julian date */
 double timeutil_JD_to_MJD (double t);
 
@@ -69,7 +105,7 @@ double timeutil_ymdhms_to_JD (int _year, int _month, int _day,
 
 int timeutil_get_days_in_month (int year, int month);
 
-BOOL timeutil_is_leap_year (int year);
+BOOL timeutil_is_leap_year (int64_t year);
 
 int timeutil_get_day_of_week (int year, int month, int day, BOOL monday_first);
 
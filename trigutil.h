@@ -30,6 +30,22 @@ cos of an angle in degrees
 */
 extern double cosDeg (double deg);
 
+/**
+sin and cos of the same angle in degrees, more quickly than calling
+sinDeg and cosDeg
+*/
+extern void sincosDeg (double deg, double *s, double *c);
+
+/**
+sin, cos, and both, of an angle in degrees, by polynomial approximation.
+These are quicker than the C library, but are only accurate to within 
+6e-11. Defining TRIG_FAST when compiling makes sinDeg, cosDeg, and
+sincosDeg use them
+*/
+extern double sinDegFast (double deg);
+extern double cosDegFast (double deg);
+extern void sincosDegFast (double deg, double *s, double *c);
+
 /**
 atan2 of an angle, result in degrees
 */
@@ -38,3 +54,15 @@ extern double atan2Deg (double x, double y);
 /* Reduce an angle to the range 0-360 degrees */
 double fixAngle (double angle);
 
+/**
+sin of each of n angles in radians, by a polynomial approximation
+that agrees with sin() to about 1e-14 for angles of up to a few
+tens of radians. x and result may be the same array
+*/
+void sinArray (const double *x, double *result, int n);
+
+/**
+cos of each of n angles in radians, with the same accuracy as sinArray
+*/
+void cosArray (const double *x, double *result, int n);
+
@@ -0,0 +1,731 @@
+/*=======================================================================
+solunar
+zoneinfo.c
+Definition of the ZoneInfo object
+Converts between universal and local time without touching the TZ
+environment variable. Zones are read from the system's compiled
+zoneinfo (TZif) files or, failing that, from a POSIX TZ string like
+"UTC0" or "EST5EDT,M3.2.0,M11.1.0". Each zone is loaded the first
+time it is asked for, and kept for the life of the program, so
+looking up the UTC offset at a particular time is just a binary
+search of the zone's transition table.
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "zoneinfo.h"
+#include "timeutil.h"
+
+#define ZONEINFO_DIR "/usr/share/zoneinfo"
+#define ZONEINFO_LOCALTIME "/etc/localtime"
+#define ZONEINFO_HASH_SIZE 64
+// Don't believe any zoneinfo file larger than this
+#define ZONEINFO_MAX_FILE 1000000
+
+typedef struct _ZoneType
+  {
+  int32_t utoff; // Seconds east of UTC
+  BOOL isdst;
+  } ZoneType;
+
+// One end of the daylight savings period in a POSIX TZ string.
+//  kind is 'J' for Jn (day 1-365, never counting February 29th),
+//  'D' for n (day 0-365, counting February 29th) or 'M' for
+//  Mm.w.d (day d of week w of month m)
+typedef struct _ZoneRuleDate
+  {
+  char kind;
+  int day;
+  int week;
+  int month;
+  int32_t time; // Seconds after local midnight
+  } ZoneRuleDate;
+
+typedef struct _ZoneRule
+  {
+  BOOL valid;
+  int32_t std_off;
+  int32_t dst_off;
+  BOOL has_dst;
+  ZoneRuleDate start;
+  ZoneRuleDate end;
+  } ZoneRule;
+
+typedef struct _ZoneInfoPriv
+  {
+  char *name;
+  int ntrans;
+  int64_t *trans;
+  unsigned char *trans_type;
+  int ntypes;
+  ZoneType *types;
+  // The rule for times after the last transition, from the footer
+  //  of a version 2+ file, or the whole zone if it was specified
+  //  as a POSIX TZ string
+  ZoneRule rule;
+  ZoneInfo *next;
+  } ZoneInfoPriv;
+
+// Zones are never removed from the cache, so lookups can walk a chain
+//  without locking, so long as new zones are published with release
+//  semantics after they have been fully loaded. The lock only serializes
+//  the loading and insertion of new zones
+static ZoneInfo *zoneinfo_cache [ZONEINFO_HASH_SIZE];
+static pthread_mutex_t zoneinfo_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*=======================================================================
+zoneinfo_parse_name
+Skip over a zone abbreviation in a POSIX TZ string -- either three or
+more letters, or anything in <angle brackets>. Returns NULL if there
+is no valid name
+=======================================================================*/
+static const char *zoneinfo_parse_name (const char *p)
+  {
+  if (*p == '<')
+    {
+    while (*p && *p != '>') p++;
+    if (*p != '>') return NULL;
+    return p + 1;
+    }
+  const char *s = p;
+  while (isalpha ((unsigned char)*p)) p++;
+  if (p - s < 3) return NULL;
+  return p;
+  }
+
+
+/*=======================================================================
+zoneinfo_parse_time
+Parse [+-]hh[:mm[:ss]] into seconds
+=======================================================================*/
+static const char *zoneinfo_parse_time (const char *p, int32_t *secs)
+  {
+  int sign = 1;
+  int32_t part[3] = {0, 0, 0};
+  int i;
+  if (*p == '+')
+    p++;
+  else if (*p == '-')
+    {
+    sign = -1;
+    p++;
+    }
+  for (i = 0; i < 3; i++)
+    {
+    if (i > 0)
+      {
+      if (*p != ':') break;
+      p++;
+      }
+    if (!isdigit ((unsigned char)*p)) return NULL;
+    while (isdigit ((unsigned char)*p))
+      part[i] = part[i] * 10 + (*p++ - '0');
+    }
+  *secs = sign * (part[0] * 3600 + part[1] * 60 + part[2]);
+  return p;
+  }
+
+
+/*=======================================================================
+zoneinfo_parse_int
+=======================================================================*/
+static const char *zoneinfo_parse_int (const char *p, int *n)
+  {
+  if (!isdigit ((unsigned char)*p)) return NULL;
+  *n = 0;
+  while (isdigit ((unsigned char)*p))
+    *n = *n * 10 + (*p++ - '0');
+  return p;
+  }
+
+
+/*=======================================================================
+zoneinfo_parse_rule_date
+=======================================================================*/
+static const char *zoneinfo_parse_rule_date (const char *p, ZoneRuleDate *d)
+  {
+  memset (d, 0, sizeof (ZoneRuleDate));
+  if (*p == 'M')
+    {
+    d->kind = 'M';
+    p = zoneinfo_parse_int (p + 1, &d->month);
+    if (!p || *p != '.') return NULL;
+    p = zoneinfo_parse_int (p + 1, &d->week);
+    if (!p || *p != '.') return NULL;
+    p = zoneinfo_parse_int (p + 1, &d->day);
+    if (!p) return NULL;
+    if (d->month < 1 || d->month > 12 || d->week < 1 || d->week > 5
+        || d->day > 6)
+      return NULL;
+    }
+  else if (*p == 'J')
+    {
+    d->kind = 'J';
+    p = zoneinfo_parse_int (p + 1, &d->day);
+    if (!p || d->day < 1 || d->day > 365) return NULL;
+    }
+  else
+    {
+    d->kind = 'D';
+    p = zoneinfo_parse_int (p, &d->day);
+    if (!p || d->day > 365) return NULL;
+    }
+  d->time = 2 * 3600;
+  if (*p == '/')
+    p = zoneinfo_parse_time (p + 1, &d->time);
+  return p;
+  }
+
+
+/*=======================================================================
+zoneinfo_parse_rule
+Parse a POSIX TZ string, e.g., "GMT0BST,M3.5.0/1,M10.5.0"
+=======================================================================*/
+static BOOL zoneinfo_parse_rule (const char *s, ZoneRule *r)
+  {
+  int32_t off;
+  memset (r, 0, sizeof (ZoneRule));
+  const char *p = zoneinfo_parse_name (s);
+  if (!p) return FALSE;
+  p = zoneinfo_parse_time (p, &off);
+  if (!p) return FALSE;
+  // POSIX offsets are positive to the _west_ of Greenwich
+  r->std_off = -off;
+  if (*p)
+    {
+    p = zoneinfo_parse_name (p);
+    if (!p) return FALSE;
+    r->has_dst = TRUE;
+    r->dst_off = r->std_off + 3600;
+    if (*p && *p != ',')
+      {
+      p = zoneinfo_parse_time (p, &off);
+      if (!p) return FALSE;
+      r->dst_off = -off;
+      }
+    if (*p == ',')
+      {
+      p = zoneinfo_parse_rule_date (p + 1, &r->start);
+      if (!p || *p != ',') return FALSE;
+      p = zoneinfo_parse_rule_date (p + 1, &r->end);
+      if (!p) return FALSE;
+      }
+    else
+      {
+      // No dates -- the C library assumes the US rules
+      zoneinfo_parse_rule_date ("M3.2.0", &r->start);
+      zoneinfo_parse_rule_date ("M11.1.0", &r->end);
+      }
+    if (*p) return FALSE;
+    }
+  r->valid = TRUE;
+  return TRUE;
+  }
+
+
+/*=======================================================================
+zoneinfo_rule_day
+Days since the epoch of a daylight savings transition in a given year
+=======================================================================*/
+static int64_t zoneinfo_rule_day (const ZoneRuleDate *d, int64_t year)
+  {
+  int64_t jan1 = timeutil_days_from_civil (year, 1, 1);
+  if (d->kind == 'J')
+    {
+    int day = d->day;
+    if (day >= 60 && timeutil_is_leap_year (year)) day++;
+    return jan1 + day - 1;
+    }
+  if (d->kind == 'D')
+    return jan1 + d->day;
+
+  // 1970-01-01 was a Thursday
+  int64_t first = timeutil_days_from_civil (year, d->month, 1);
+  int wday = (int)(((first % 7) + 7 + 4) % 7);
+  int64_t day = first + (d->day - wday + 7) % 7 + 7 * (d->week - 1);
+  // Week 5 means the last such day in the month
+  int mdays = timeutil_days_from_civil (d->month == 12 ? year + 1 : year,
+     d->month == 12 ? 1 : d->month + 1, 1) - first;
+  while (day >= first + mdays) day -= 7;
+  return day;
+  }
+
+
+/*=======================================================================
+zoneinfo_rule_offset
+Fill in the offset that a POSIX TZ rule gives at time t. The span is
+clipped to the standard-time year that contains t, because the 
+changes are worked out a year at a time
+=======================================================================*/
+static void zoneinfo_rule_offset (const ZoneRule *r, int64_t t,
+    ZoneOffset *offset)
+  {
+  offset->isdst = FALSE;
+  offset->utoff = r->std_off;
+  offset->from = INT64_MIN;
+  offset->until = INT64_MAX;
+  if (!r->has_dst) return;
+
+  int64_t year;
+  int month, day;
+  timeutil_civil_from_days (timeutil_floor_div (t + r->std_off,
+    SECONDS_PER_DAY), &year, &month, &day);
+
+  int64_t year_start = timeutil_days_from_civil (year, 1, 1) 
+    * SECONDS_PER_DAY - r->std_off;
+  int64_t year_end = timeutil_days_from_civil (year + 1, 1, 1) 
+    * SECONDS_PER_DAY - r->std_off;
+  int64_t start = zoneinfo_rule_day (&r->start, year) * SECONDS_PER_DAY
+    + r->start.time - r->std_off;
+  int64_t end = zoneinfo_rule_day (&r->end, year) * SECONDS_PER_DAY
+    + r->end.time - r->dst_off;
+  if (start < end)
+    offset->isdst = (t >= start && t < end);
+  else // Southern hemisphere
+    offset->isdst = (t < end || t >= start);
+
+  // Within the year, the offset only changes at the start and end 
+  //  of daylight savings
+  offset->from = year_start;
+  offset->until = year_end;
+  if (start <= t && start > offset->from) offset->from = start;
+  if (end <= t && end > offset->from) offset->from = end;
+  if (start > t && start < offset->until) offset->until = start;
+  if (end > t && end < offset->until) offset->until = end;
+
+  if (offset->isdst) offset->utoff = r->dst_off;
+  }
+
+
+/*=======================================================================
+zoneinfo_get32
+=======================================================================*/
+static int32_t zoneinfo_get32 (const unsigned char *p)
+  {
+  return (int32_t)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+    | ((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+  }
+
+
+/*=======================================================================
+zoneinfo_get64
+=======================================================================*/
+static int64_t zoneinfo_get64 (const unsigned char *p)
+  {
+  return (int64_t)(((uint64_t)(uint32_t)zoneinfo_get32 (p) << 32)
+    | (uint64_t)(uint32_t)zoneinfo_get32 (p + 4));
+  }
+
+
+/*=======================================================================
+zoneinfo_parse_tzif
+Parse the contents of a TZif file, as described in RFC 8536. For
+version 2 and later files we skip the 32-bit data block and use the
+64-bit one, along with the TZ string footer
+=======================================================================*/
+static BOOL zoneinfo_parse_tzif (ZoneInfoPriv *priv,
+    const unsigned char *buf, size_t len)
+  {
+  const unsigned char *p = buf;
+  const unsigned char *end = buf + len;
+  int tsize = 4;
+  int i;
+
+  if (len < 44 || memcmp (buf, "TZif", 4) != 0) return FALSE;
+
+  if (buf[4] >= '2')
+    {
+    size_t v1 = 44
+      + (size_t)zoneinfo_get32 (p + 32) * 5
+      + (size_t)zoneinfo_get32 (p + 36) * 6
+      + (size_t)zoneinfo_get32 (p + 40)
+      + (size_t)zoneinfo_get32 (p + 28) * 8
+      + (size_t)zoneinfo_get32 (p + 24)
+      + (size_t)zoneinfo_get32 (p + 20);
+    if (v1 + 44 > len) return FALSE;
+    p += v1;
+    if (memcmp (p, "TZif", 4) != 0) return FALSE;
+    tsize = 8;
+    }
+
+  int32_t isutcnt = zoneinfo_get32 (p + 20);
+  int32_t isstdcnt = zoneinfo_get32 (p + 24);
+  int32_t leapcnt = zoneinfo_get32 (p + 28);
+  int32_t timecnt = zoneinfo_get32 (p + 32);
+  int32_t typecnt = zoneinfo_get32 (p + 36);
+  int32_t charcnt = zoneinfo_get32 (p + 40);
+  p += 44;
+
+  if (isutcnt < 0 || isstdcnt < 0 || leapcnt < 0 || timecnt < 0
+      || typecnt <= 0 || charcnt < 0)
+    return FALSE;
+
+  size_t need = (size_t)timecnt * (tsize + 1) + (size_t)typecnt * 6
+    + charcnt + (size_t)leapcnt * (tsize + 4) + isstdcnt + isutcnt;
+  if ((size_t)(end - p) < need) return FALSE;
+
+  priv->ntrans = timecnt;
+  priv->trans = (int64_t *) malloc ((timecnt + 1) * sizeof (int64_t));
+  priv->trans_type = (unsigned char *) malloc (timecnt + 1);
+  for (i = 0; i < timecnt; i++)
+    {
+    priv->trans[i] = tsize == 8 ? zoneinfo_get64 (p) : zoneinfo_get32 (p);
+    p += tsize;
+    }
+  for (i = 0; i < timecnt; i++)
+    {
+    priv->trans_type[i] = *p++;
+    if (priv->trans_type[i] >= typecnt) return FALSE;
+    }
+
+  priv->ntypes = typecnt;
+  priv->types = (ZoneType *) malloc (typecnt * sizeof (ZoneType));
+  for (i = 0; i < typecnt; i++)
+    {
+    priv->types[i].utoff = zoneinfo_get32 (p);
+    priv->types[i].isdst = p[4] != 0;
+    p += 6;
+    }
+  p += charcnt + (size_t)leapcnt * (tsize + 4) + isstdcnt + isutcnt;
+
+  if (tsize == 8 && p < end && *p == '\n')
+    {
+    const unsigned char *nl = memchr (p + 1, '\n', end - p - 1);
+    if (nl && nl - p < 256)
+      {
+      char footer[256];
+      memcpy (footer, p + 1, nl - p - 1);
+      footer[nl - p - 1] = 0;
+      zoneinfo_parse_rule (footer, &priv->rule);
+      }
+    }
+
+  return TRUE;
+  }
+
+
+/*=======================================================================
+zoneinfo_load_file
+=======================================================================*/
+static BOOL zoneinfo_load_file (ZoneInfoPriv *priv, const char *path)
+  {
+  BOOL ret = FALSE;
+  FILE *f = fopen (path, "rb");
+  if (!f) return FALSE;
+  unsigned char *buf = (unsigned char *) malloc (ZONEINFO_MAX_FILE);
+  size_t len = fread (buf, 1, ZONEINFO_MAX_FILE, f);
+  fclose (f);
+  if (len > 0 && len < ZONEINFO_MAX_FILE)
+    ret = zoneinfo_parse_tzif (priv, buf, len);
+  free (buf);
+  return ret;
+  }
+
+
+/*=======================================================================
+zoneinfo_new
+Load a zone in the same way as the C library would for the same value
+of TZ: try to read a file, then try to parse it as a POSIX TZ string,
+and if all else fails, use UTC
+=======================================================================*/
+static ZoneInfo *zoneinfo_new (const char *name)
+  {
+  ZoneInfo *self = (ZoneInfo *) malloc (sizeof (ZoneInfo));
+  self->priv = (ZoneInfoPriv *) malloc (sizeof (ZoneInfoPriv));
+  memset (self->priv, 0, sizeof (ZoneInfoPriv));
+  self->priv->name = strdup (name);
+
+  const char *file = name;
+  if (*file == ':') file++;
+  char path[512];
+  if (*file == '/')
+    snprintf (path, sizeof (path), "%s", file);
+  else
+    {
+    const char *dir = getenv ("TZDIR");
+    snprintf (path, sizeof (path), "%s/%s", dir ? dir : ZONEINFO_DIR, file);
+    }
+
+  if (*file && zoneinfo_load_file (self->priv, path)) return self;
+
+  free (self->priv->trans);
+  free (self->priv->trans_type);
+  free (self->priv->types);
+  self->priv->trans = NULL;
+  self->priv->trans_type = NULL;
+  self->priv->types = NULL;
+  self->priv->ntrans = 0;
+  self->priv->ntypes = 0;
+
+  if (!zoneinfo_parse_rule (name, &self->priv->rule))
+    {
+    memset (&self->priv->rule, 0, sizeof (ZoneRule));
+    self->priv->rule.valid = TRUE;
+    }
+  return self;
+  }
+
+
+/*=======================================================================
+zoneinfo_find
+Look up a zone in the cache, returning NULL if it has not been loaded
+=======================================================================*/
+static ZoneInfo *zoneinfo_find (unsigned int hash, const char *tz)
+  {
+  ZoneInfo *zone = __atomic_load_n (&zoneinfo_cache[hash], __ATOMIC_ACQUIRE);
+  while (zone)
+    {
+    if (strcmp (zone->priv->name, tz) == 0) return zone;
+    zone = zone->priv->next;
+    }
+  return NULL;
+  }
+
+
+/*=======================================================================
+ZoneInfo_get
+Get the zone with the specified name. The name is anything that might
+be the value of the TZ environment variable: a zone name like
+"Europe/London", a path to a file, or a POSIX TZ string. If tz is
+NULL, gets the system local zone -- TZ if it is set, or /etc/localtime
+otherwise. The result is owned by the cache, and must not be freed.
+This function is safe to call from multiple threads
+=======================================================================*/
+const ZoneInfo *ZoneInfo_get (const char *tz)
+  {
+  if (!tz)
+    {
+    tz = getenv ("TZ");
+    if (!tz) tz = ZONEINFO_LOCALTIME;
+    }
+
+  unsigned int hash = 5381;
+  const char *p;
+  for (p = tz; *p; p++)
+    hash = hash * 33 + (unsigned char)*p;
+  hash %= ZONEINFO_HASH_SIZE;
+
+  ZoneInfo *zone = zoneinfo_find (hash, tz);
+  if (zone) return zone;
+
+  pthread_mutex_lock (&zoneinfo_cache_lock);
+  // Another thread might have loaded the zone while we waited
+  zone = zoneinfo_find (hash, tz);
+  if (!zone)
+    {
+    zone = zoneinfo_new (tz);
+    zone->priv->next = zoneinfo_cache[hash];
+    __atomic_store_n (&zoneinfo_cache[hash], zone, __ATOMIC_RELEASE);
+    }
+  pthread_mutex_unlock (&zoneinfo_cache_lock);
+  return zone;
+  }
+
+
+/*=======================================================================
+ZoneInfo_get_offset_span
+Fill in the offset from UTC that is in effect in this zone at the 
+specified time, and the span of time over which it stays the same.
+The span may be shorter than the true one, but always contains the
+time. This allows a caller that converts many times to look up the
+offset only when a time falls outside the span
+=======================================================================*/
+void ZoneInfo_get_offset_span (const ZoneInfo *self, time_t utime, 
+    ZoneOffset *offset)
+  {
+  const ZoneInfoPriv *priv = self->priv;
+  int64_t t = utime;
+
+  if (priv->ntrans == 0 || t >= priv->trans[priv->ntrans - 1])
+    {
+    if (priv->rule.valid)
+      {
+      zoneinfo_rule_offset (&priv->rule, t, offset);
+      if (priv->ntrans > 0 && offset->from < priv->trans[priv->ntrans - 1])
+        offset->from = priv->trans[priv->ntrans - 1];
+      return;
+      }
+    }
+
+  const ZoneType *type;
+  if (priv->ntrans == 0 || t < priv->trans[0])
+    {
+    type = &priv->types[0];
+    offset->from = INT64_MIN;
+    offset->until = priv->ntrans == 0 ? INT64_MAX : priv->trans[0];
+    }
+  else
+    {
+    // Find the last transition at or before t
+    int lo = 0, hi = priv->ntrans - 1;
+    while (lo < hi)
+      {
+      int mid = (lo + hi + 1) / 2;
+      if (priv->trans[mid] <= t)
+        lo = mid;
+      else
+        hi = mid - 1;
+      }
+    type = &priv->types[priv->trans_type[lo]];
+    offset->from = priv->trans[lo];
+    offset->until = lo + 1 < priv->ntrans ? priv->trans[lo + 1] : INT64_MAX;
+    }
+  offset->utoff = type->utoff;
+  offset->isdst = type->isdst;
+  }
+
+
+/*=======================================================================
+ZoneInfo_get_offset
+Returns the offset from UTC in seconds, east being positive, that is
+in effect in this zone at the specified time. If isdst is not NULL, it
+is set according to whether that is a daylight savings offset
+=======================================================================*/
+int ZoneInfo_get_offset (const ZoneInfo *self, time_t utime, BOOL *isdst)
+  {
+  ZoneOffset offset;
+  ZoneInfo_get_offset_span (self, utime, &offset);
+  if (isdst) *isdst = offset.isdst;
+  return offset.utoff;
+  }
+
+
+/*=======================================================================
+ZoneInfo_gmtime
+Break down a universal time, as gmtime_r() does
+=======================================================================*/
+void ZoneInfo_gmtime (time_t utime, struct tm *tm)
+  {
+  int64_t days = timeutil_floor_div (utime, SECONDS_PER_DAY);
+  int64_t secs = (int64_t)utime - days * SECONDS_PER_DAY;
+  int64_t year;
+  int month, day;
+  timeutil_civil_from_days (days, &year, &month, &day);
+
+  memset (tm, 0, sizeof (struct tm));
+  tm->tm_year = year - 1900;
+  tm->tm_mon = month - 1;
+  tm->tm_mday = day;
+  tm->tm_hour = secs / 3600;
+  tm->tm_min = (secs / 60) % 60;
+  tm->tm_sec = secs % 60;
+  tm->tm_wday = (int)(((days % 7) + 7 + 4) % 7);
+  tm->tm_yday = days - timeutil_days_from_civil (year, 1, 1);
+  tm->tm_isdst = 0;
+  }
+
+
+/*=======================================================================
+ZoneInfo_localtime
+Break down a universal time into local time in this zone, as
+localtime_r() does
+=======================================================================*/
+void ZoneInfo_localtime (const ZoneInfo *self, time_t utime, struct tm *tm)
+  {
+  BOOL isdst;
+  int offset = ZoneInfo_get_offset (self, utime, &isdst);
+  ZoneInfo_gmtime (utime + offset, tm);
+  tm->tm_isdst = isdst;
+  }
+
+
+/*=======================================================================
+ZoneInfo_mktime
+Convert a broken-down local time in this zone to a universal time, as
+mktime() does. Out-of-range fields are allowed, and tm is normalized
+on return. When the clocks go back, a local time that happens twice
+is resolved as glibc does in a new process, unless tm_isdst says
+which one is wanted.
+A local time that falls in the gap when the clocks go forward is 
+taken to be in the offset before the change, unless tm_isdst asks for
+the other one. Like the C library, if tm_isdst asks for a kind of 
+time that is not in effect, the offset of a nearby time of that kind 
+is used
+=======================================================================*/
+time_t ZoneInfo_mktime (const ZoneInfo *self, struct tm *tm)
+  {
+  int64_t year = (int64_t)tm->tm_year + 1900
+    + timeutil_floor_div (tm->tm_mon, 12);
+  int month = tm->tm_mon - 12 * timeutil_floor_div (tm->tm_mon, 12) + 1;
+  int64_t local = (timeutil_days_from_civil (year, month, 1)
+    + tm->tm_mday - 1) * SECONDS_PER_DAY + (int64_t)tm->tm_hour * 3600
+    + (int64_t)tm->tm_min * 60 + tm->tm_sec;
+
+  // Real zones never change offset more than once in two days, so the
+  //  offsets a day either side are the only candidates
+  BOOL dst_before, dst_after, isdst;
+  int off_before = ZoneInfo_get_offset (self, local - SECONDS_PER_DAY, 
+    &dst_before);
+  int off_after = ZoneInfo_get_offset (self, local + SECONDS_PER_DAY, 
+    &dst_after);
+  BOOL before_ok = ZoneInfo_get_offset (self, local - off_before, NULL) 
+    == off_before;
+  BOOL after_ok = ZoneInfo_get_offset (self, local - off_after, NULL) 
+    == off_after;
+
+  int64_t t;
+  if (before_ok && after_ok && off_before != off_after)
+    {
+    // Clocks went back, and this local time happened twice
+    if (tm->tm_isdst >= 0)
+      t = local - ((tm->tm_isdst > 0) == dst_after ? off_after : off_before);
+    else
+      {
+      // Pick the one that glibc's mktime() would pick, the first time
+      //  it is called: it starts by guessing an offset of zero, and
+      //  corrects the guess until it is self-consistent
+      int off = ZoneInfo_get_offset (self, local, NULL);
+      t = local - ZoneInfo_get_offset (self, local - off, NULL);
+      }
+    }
+  else if (before_ok)
+    t = local - off_before;
+  else if (after_ok)
+    t = local - off_after;
+  else
+    {
+    // Clocks went forward, and this local time never happened
+    if (tm->tm_isdst >= 0 && (tm->tm_isdst > 0) == dst_after 
+        && dst_after != dst_before)
+      t = local - off_after;
+    else
+      t = local - off_before;
+    }
+  ZoneInfo_get_offset (self, t, &isdst);
+
+  if (tm->tm_isdst >= 0 && (tm->tm_isdst > 0) != isdst)
+    {
+    // Look up to eight years or so either side for a time of the
+    //  requested kind, a week at a time, as glibc does. If there isn't
+    //  one, just shift by an hour
+    const int64_t stride = 601200;
+    const int64_t bound = 536454000 / 2 + stride;
+    int64_t delta;
+    int dir;
+    BOOL found = FALSE;
+    for (delta = stride; delta < bound && !found; delta += stride)
+      {
+      for (dir = -1; dir <= 1 && !found; dir += 2)
+        {
+        BOOL probe_dst;
+        int off = ZoneInfo_get_offset (self, t + dir * delta, &probe_dst);
+        if (probe_dst == (tm->tm_isdst > 0))
+          {
+          t = local - off;
+          found = TRUE;
+          }
+        }
+      }
+    if (!found)
+      t += tm->tm_isdst > 0 ? -3600 : 3600;
+    }
+
+  ZoneInfo_localtime (self, t, tm);
+  return (time_t)t;
+  }
+
@@ -0,0 +1,39 @@
+/*=======================================================================
+solunar
+zoneinfo.h
+(c)2005-2019 Kevin Boone
+=======================================================================*/
+#pragma once
+
+#include <time.h>
+#include <stdint.h>
+#include "defs.h"
+
+typedef struct _ZoneInfo
+  {
+  struct _ZoneInfoPriv *priv;
+  } ZoneInfo;
+
+// An offset from UTC, in seconds east, and the universal times from
+//  'from' up to, but not including, 'until' over which it applies
+typedef struct _ZoneOffset
+  {
+  int32_t utoff;
+  BOOL isdst;
+  int64_t from;
+  int64_t until;
+  } ZoneOffset;
+
+const ZoneInfo *ZoneInfo_get (const char *tz);
+
+int ZoneInfo_get_offset (const ZoneInfo *self, time_t utime, BOOL *isdst);
+
+void ZoneInfo_get_offset_span (const ZoneInfo *self, time_t utime, 
+    ZoneOffset *offset);
+
+void ZoneInfo_localtime (const ZoneInfo *self, time_t utime, struct tm *tm);
+
+time_t ZoneInfo_mktime (const ZoneInfo *self, struct tm *tm);
+
+void ZoneInfo_gmtime (time_t utime, struct tm *tm);
+